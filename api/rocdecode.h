@@ -66,6 +66,7 @@ typedef enum rocDecStatus_enum{
     ROCDEC_NOT_IMPLEMENTED      = -6,
     ROCDEC_NOT_INITIALIZED      = -7,
     ROCDEC_NOT_SUPPORTED        = -8,
+    ROCDEC_SURFACE_BUSY         = -9,
     ROCDEC_SUCCESS              = 0,
 }rocDecStatus;
 
@@ -160,6 +161,80 @@ typedef struct _RocdecDecodeCaps {
     uint32_t                    reserved_2[6];              /**< Reserved for future use - set to zero */
 } RocdecDecodeCaps;
 
+/**************************************************************************************************************/
+//! \struct RocdecDevicePlacementInfo;
+//! \ingroup group_amd_rocdecode
+//! This structure is used in rocDecAcquireDevice and rocDecReleaseDevice APIs
+/**************************************************************************************************************/
+typedef struct _RocdecDevicePlacementInfo {
+    rocDecVideoCodec            codec_type;                 /**< IN: rocDecVideoCodec_XXX */
+    rocDecVideoChromaFormat     chroma_format;              /**< IN: rocDecVideoChromaFormat_XXX */
+    uint32_t                    bit_depth_minus_8;          /**< IN: The Value "BitDepth minus 8" */
+    uint32_t                    width;                      /**< IN: Coded width of the stream in pixels */
+    uint32_t                    height;                     /**< IN: Coded height of the stream in pixels */
+    uint32_t                    frame_rate_numerator;       /**< IN: Frame rate numerator of the stream; 0 if unknown (30 fps is assumed) */
+    uint32_t                    frame_rate_denominator;     /**< IN: Frame rate denominator of the stream */
+    uint32_t                    reserved[9];                /**< Reserved for future use - set to zero */
+} RocdecDevicePlacementInfo;
+
+/**************************************************************************************************************/
+//! \struct RocdecDecoderMemoryInfo;
+//! \ingroup group_amd_rocdecode
+//! This structure is used in rocDecGetDecoderMemoryInfo API
+/**************************************************************************************************************/
+typedef struct _RocdecDecoderMemoryInfo {
+    rocDecVideoCodec            codec_type;                 /**< IN: rocDecVideoCodec_XXX */
+    rocDecVideoChromaFormat     chroma_format;              /**< IN: rocDecVideoChromaFormat_XXX */
+    uint32_t                    bit_depth_minus_8;          /**< IN: The Value "BitDepth minus 8" */
+    uint32_t                    width;                      /**< IN: Width of the decode surfaces in pixels; the larger of the coded width
+                                                                     and RocDecoderCreateInfo::max_width */
+    uint32_t                    height;                     /**< IN: Height of the decode surfaces in pixels; the larger of the coded height
+                                                                     and RocDecoderCreateInfo::max_height */
+    uint32_t                    max_dpb_frames;             /**< IN: RocdecVideoFormatEx::max_dpb_frames of the sequence */
+    uint32_t                    max_num_reorder_frames;     /**< IN: RocdecVideoFormatEx::max_num_reorder_frames of the sequence */
+    uint32_t                    output_queue_depth;         /**< IN: Number of decoded frames the client holds on to after they are displayed,
+                                                                     on top of the ones the parser keeps for output */
+    uint32_t                    reserved_1[4];              /**< Reserved for future use - set to zero */
+    uint32_t                    num_decode_surfaces;        /**< OUT: Number of decode surfaces the session needs */
+    uint32_t                    surface_pitch;              /**< OUT: Estimated pitch of the luma plane of a decode surface in bytes */
+    uint32_t                    surface_height;             /**< OUT: Estimated height of the luma plane of a decode surface in rows */
+    uint64_t                    surface_size_in_bytes;      /**< OUT: Estimated size of a single decode surface in bytes */
+    uint64_t                    total_size_in_bytes;        /**< OUT: Estimated surface memory of the session in bytes */
+    uint32_t                    reserved_2[6];              /**< Reserved for future use - set to zero */
+} RocdecDecoderMemoryInfo;
+
+/**************************************************************************************************************/
+//! \enum rocDecDecoderFlags
+//! \ingroup group_amd_rocdecode
+//! Optional decoder behaviors
+//! These enums are OR-ed together in RocDecoderCreateInfo::decoder_flags
+/**************************************************************************************************************/
+typedef enum rocDecDecoderFlags_enum {
+    rocDecDecoderFlags_None             = 0,        /**< Default behavior */
+    rocDecDecoderFlags_CompletionQueue  = 0x1,      /**< Track every submitted picture and report it through
+                                                         rocDecGetDecodeCompletions once its decode has finished */
+    rocDecDecoderFlags_PremapSurfaces   = 0x2,      /**< Map all decode surfaces for HIP in the background right after they are
+                                                         created, instead of on their first rocDecGetVideoFrame call */
+    rocDecDecoderFlags_DeadlineScheduling = 0x4,    /**< Order the picture submissions of the decoder with the ones of the other
+                                                         scheduled decoders on the device by priority class and deadline */
+    rocDecDecoderFlags_PostProcess      = 0x8,      /**< Crop display_rect and scale it to target_width x target_height at
+                                                         target_rect with VA video processing, so rocDecGetVideoFrame returns
+                                                         the post-processed frame. rocDecCreateDecoder returns
+                                                         ROCDEC_NOT_SUPPORTED if the driver has no video processing */
+} rocDecDecoderFlags;
+
+/**************************************************************************************************************/
+//! \enum rocDecPriorityClass
+//! \ingroup group_amd_rocdecode
+//! Priority classes of the decoders created with rocDecDecoderFlags_DeadlineScheduling
+//! These enums are used in RocDecoderCreateInfo::priority_class
+/**************************************************************************************************************/
+typedef enum rocDecPriorityClass_enum {
+    rocDecPriorityClass_Realtime        = 0,        /**< Pictures are submitted earliest deadline first */
+    rocDecPriorityClass_Batch           = 1,        /**< Pictures are submitted earliest deadline first while no picture of a
+                                                         realtime decoder waits for submission */
+} rocDecPriorityClass;
+
 /**************************************************************************************************************/
 //! \struct RocDecoderCreateInfo
 //! \ingroup group_amd_rocdecode
@@ -178,7 +253,15 @@ typedef struct _RocDecoderCreateInfo {
                                                                  optimize video memory for Intra frames only decoding. The support is limited
                                                                 to specific codecs - AVC/H264, HEVC, VP9, the flag will be ignored for codecs which
                                                                 are not supported. However decoding might fail if the flag is enabled in case
-                                                                of supported codecs for regular bit streams having P and/or B frames. */
+                                                                of supported codecs for regular bit streams having P and/or B frames.
+                                                                 With the flag, the pictures are decoded into a pool of output_queue_depth + 2
+                                                                 surfaces in decode order. The surface of a picture is taken over once the
+                                                                 picture has been returned by rocDecGetVideoFrame, rocDecGetVideoFrameAsync or
+                                                                 rocDecExportVideoFrame and output_queue_depth newer pictures have been
+                                                                 returned; rocDecDecodeFrame fails with ROCDEC_OUTOF_MEMORY if no surface is
+                                                                 left, e.g. when the parser holds back pictures for reordering. Surfaces of
+                                                                 frames held with rocDecHoldVideoFrame or exported are skipped, and
+                                                                 rocDecDecodeFrame returns ROCDEC_SURFACE_BUSY if only those are left. */
     uint32_t                    max_width;             /**< IN: Coded sequence max width in pixels used with reconfigure Decoder */
     uint32_t                    max_height;            /**< IN: Coded sequence max height in pixels used with reconfigure Decoder */
     struct {
@@ -186,19 +269,36 @@ typedef struct _RocDecoderCreateInfo {
         int16_t top;
         int16_t right;
         int16_t bottom;
-    } display_rect;                                    /**< IN: area of the frame that should be displayed */
+    } display_rect;                                    /**< IN: area of the frame that should be displayed, the whole frame if null.
+                                                                 Applied with rocDecDecoderFlags_PostProcess */
     rocDecVideoSurfaceFormat    output_format;         /**< IN: rocDecVideoSurfaceFormat_XXX */
-    uint32_t                    target_width;          /**< IN: Post-processed output width (Should be aligned to 2) */
-    uint32_t                    target_height;         /**< IN: Post-processed output height (Should be aligned to 2) */
-    uint32_t                    num_output_surfaces;   /**< IN: Maximum number of output surfaces simultaneously mapped */
+    uint32_t                    target_width;          /**< IN: Post-processed output width (Should be aligned to 2), the display_rect
+                                                                 width if 0. Applied with rocDecDecoderFlags_PostProcess */
+    uint32_t                    target_height;         /**< IN: Post-processed output height (Should be aligned to 2), the display_rect
+                                                                 height if 0. Applied with rocDecDecoderFlags_PostProcess */
+    uint32_t                    num_output_surfaces;   /**< IN: Maximum number of output surfaces simultaneously mapped, 0 for no limit.
+                                                                 Mapping one more surface unmaps the least recently used one, and the
+                                                                 pointers returned for it by rocDecGetVideoFrame are no longer valid.
+                                                                 Surfaces held with rocDecHoldVideoFrame or exported, those of
+                                                                 rocDecGetVideoFrameAsync until their callback returns, and the one
+                                                                 returned by the latest rocDecGetVideoFrame call are not unmapped:
+                                                                 a frame read after the next rocDecGetVideoFrame call, including by
+                                                                 HIP work still in flight, must be held before it is mapped and
+                                                                 released once the reads are done. The limit is exceeded while more
+                                                                 surfaces are held. */
     struct {
         int16_t left;
         int16_t top;
         int16_t right;
         int16_t bottom;
-    } target_rect;                                     /**< IN: (for future use) target rectangle in the output frame (for aspect ratio conversion)
-                                                            if a null rectangle is specified, {0,0,target_width,target_height} will be used*/
-    uint32_t                    reserved_2[4];         /**< Reserved for future use - set to zero */
+    } target_rect;                                     /**< IN: target rectangle in the output frame (for aspect ratio conversion)
+                                                            if a null rectangle is specified, {0,0,target_width,target_height} will be used.
+                                                            Applied with rocDecDecoderFlags_PostProcess, the rest of the frame is black */
+    uint32_t                    decoder_flags;         /**< IN: Bitwise OR of rocDecDecoderFlags_XXX (default value is 0) */
+    rocDecPriorityClass         priority_class;        /**< IN: rocDecPriorityClass_XXX, used with rocDecDecoderFlags_DeadlineScheduling */
+    uint32_t                    output_queue_depth;    /**< IN: Number of decoded frames the client holds on to after they are displayed,
+                                                                 sizes the surface pool of intra_decode_only */
+    uint32_t                    reserved_2[1];         /**< Reserved for future use - set to zero */
 } RocDecoderCreateInfo;
 
 /*********************************************************************************************************/
@@ -213,6 +313,52 @@ typedef struct _RocdecDecodeStatus {
     void                *p_reserved[8];
 } RocdecDecodeStatus;
 
+/*********************************************************************************************************/
+//! \struct RocdecDecodeCompletion
+//! \ingroup group_amd_rocdecode
+//! Entry of the per-decoder completion queue, describing a picture whose decode has finished.
+//! This structure is used in rocDecGetDecodeCompletions API.
+/*********************************************************************************************************/
+typedef struct _RocdecDecodeCompletion {
+    int                 pic_idx;        /**< OUT: Picture index of the finished picture */
+    rocDecDecodeStatus  decode_status;  /**< OUT: rocDecodeStatus_Success, rocDecodeStatus_Error or rocDecodeStatus_Invalid
+                                                  if the completion of the picture could not be determined */
+    uint32_t            num_dropped;    /**< OUT: Entries dropped from the full queue since the previous call, set on the
+                                                  first entry returned by a call and 0 on the others */
+    uint32_t            decode_order;   /**< OUT: Number of the picture in submission order, recorded when it was submitted:
+                                                  0 for the first picture after rocDecCreateDecoder or rocDecResetDecoder */
+    uint32_t            reserved[4];    /**< Reserved for future use */
+} RocdecDecodeCompletion;
+
+/*********************************************************************************************************/
+//! \struct RocdecExportedFrame
+//! \ingroup group_amd_rocdecode
+//! DMA-BUF description of a decoded surface, for handing it to encoders, GL/Vulkan or other processes without a copy.
+//! Each plane is one layer of the surface. The file descriptors are owned by the decoder and stay open until
+//! rocDecReleaseVideoFrame() is called with frame_id; dup() them to keep the buffers beyond that.
+//! This structure is used in rocDecExportVideoFrame API.
+/*********************************************************************************************************/
+typedef struct _RocdecExportedFrame {
+    uint64_t    frame_id;                           /**< OUT: Identifies the exported frame in rocDecReleaseVideoFrame */
+    uint32_t    fourcc;                             /**< OUT: VA fourcc of the surface (e.g. VA_FOURCC_NV12, VA_FOURCC_P010) */
+    uint32_t    width;                              /**< OUT: Width of the surface in pixels */
+    uint32_t    height;                             /**< OUT: Height of the surface in pixels */
+    uint32_t    num_objects;                        /**< OUT: Number of valid entries in objects */
+    struct {
+        int         fd;                             /**< OUT: DMA-BUF file descriptor of the buffer */
+        uint32_t    size;                           /**< OUT: Size of the buffer in bytes */
+        uint64_t    drm_format_modifier;            /**< OUT: DRM format modifier describing the layout of the buffer */
+    } objects[4];
+    uint32_t    num_planes;                         /**< OUT: Number of valid entries in planes */
+    struct {
+        uint32_t    drm_format;                     /**< OUT: DRM fourcc of the plane (e.g. DRM_FORMAT_R8, DRM_FORMAT_GR88) */
+        uint32_t    object_index;                   /**< OUT: Index of the buffer in objects holding the plane */
+        uint32_t    offset;                         /**< OUT: Offset of the plane in the buffer in bytes */
+        uint32_t    pitch;                          /**< OUT: Pitch of the plane in bytes */
+    } planes[4];
+    uint32_t    reserved[16];                       /**< Reserved for future use (set to zero) */
+} RocdecExportedFrame;
+
 /****************************************************/
 //! \struct RocdecReconfigureDecoderInfo
 //! \ingroup group_amd_rocdecode
@@ -237,7 +383,7 @@ typedef struct _RocdecReconfigureDecoderInfo {
         int16_t top;
         int16_t right;
         int16_t bottom;
-    } target_rect;                  /**< IN: (for future use) target rectangle in the output frame (for aspect ratio conversion)
+    } target_rect;                  /**< IN: target rectangle in the output frame (for aspect ratio conversion)
                                     if a null rectangle is specified, {0,0,target_width,target_height} will be used */
     uint32_t reserved_2[11]; /**< Reserved for future use. Set to Zero */
 } RocdecReconfigureDecoderInfo; 
@@ -803,7 +949,12 @@ typedef struct _RocdecPicParams {
 
     int             ref_pic_flag;                      /**< IN: This picture is a reference picture */
     int             intra_pic_flag;                    /**< IN: This picture is entirely intra coded */
-    uint32_t        reserved[30];                      /**< Reserved for future use */
+    uint32_t        reserved_1;                        /**< Reserved for future use */
+    int64_t         pts;                               /**< IN: Presentation time stamp of the picture in clock_rate units */
+    uint32_t        clock_rate;                        /**< IN: Units of pts in Hz, 0 if the picture has no time stamp */
+    uint32_t        frame_rate_numerator;              /**< IN: Frame rate numerator of the stream, 0 if unknown */
+    uint32_t        frame_rate_denominator;            /**< IN: Frame rate denominator of the stream */
+    uint32_t        reserved[24];                      /**< Reserved for future use */
 
     // IN: Codec-specific data
     union {
@@ -830,6 +981,16 @@ typedef struct _RocdecPicParams {
     } iq_matrix;
 } RocdecPicParams;
 
+/*****************************************************************************************************/
+//! \typedef PFNVIDFRAMEREADYCALLBACK
+//! \ingroup group_amd_rocdecode
+//! Callback used by rocDecGetVideoFrameAsync to signal that the surface of pic_idx has been fully decoded and
+//! the HIP device pointers returned for it can be read. It is invoked from an internal thread of the decoder;
+//! applications waiting on an eventfd or a HIP event can signal it from within this callback.
+//! status is ROCDEC_SUCCESS when the surface is ready, or the error code of the failed synchronization.
+/*****************************************************************************************************/
+typedef void (ROCDECAPI *PFNVIDFRAMEREADYCALLBACK)(void *user_data, int pic_idx, rocDecStatus status);
+
 /******************************************************/
 //! \struct RocdecProcParams
 //! \ingroup group_amd_rocdecode
@@ -849,13 +1010,20 @@ typedef struct _RocdecProcParams
     uint64_t    raw_output_dptr;                 /**< IN: Output HIP device mem ptr for raw YUV extensions */
     uint32_t    raw_output_pitch;                /**< IN: pitch in bytes of raw YUV output (should be aligned appropriately) */
     uint32_t    raw_output_format;               /**< IN: Output YUV format (rocDecVideoCodec_enum) */
-    uint32_t    reserved[16];                    /**< Reserved for future use (set to zero) */
+    PFNVIDFRAMEREADYCALLBACK pfn_frame_ready;    /**< IN: Called when the frame is ready (used by rocDecGetVideoFrameAsync only) */
+    void        *frame_ready_user_data;          /**< IN: User data passed to pfn_frame_ready */
+    uint32_t    reserved[12];                    /**< Reserved for future use (set to zero) */
 } RocdecProcParams;
 
 /*****************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecCreateDecoder(rocDecDecoderHandle *decoder_handle, RocDecoderCreateInfo *decoder_create_info)
 //! \ingroup group_amd_rocdecode
 //! Create the decoder object based on decoder_create_info. A handle to the created decoder is returned
+//! The handle may be used by one submitting thread and any number of output threads at the same time. The submitting
+//! thread calls rocDecDecodeFrame(), rocDecDecodeFrames(), rocDecReconfigureDecoder(), rocDecResetDecoder() and
+//! rocDecDestroyDecoder(); the output threads call rocDecGetVideoFrame(), rocDecGetVideoFrameAsync(),
+//! rocDecExportVideoFrame(), rocDecHoldVideoFrame(), rocDecReleaseVideoFrame(), rocDecGetDecodeStatus() and rocDecGetDecodeCompletions(). rocDecReconfigureDecoder(), rocDecResetDecoder() and
+//! rocDecDestroyDecoder() must not overlap with calls from the output threads.
 /*****************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecCreateDecoder(rocDecDecoderHandle *decoder_handle, RocDecoderCreateInfo *decoder_create_info);
 
@@ -876,14 +1044,77 @@ extern rocDecStatus ROCDECAPI rocDecDestroyDecoder(rocDecDecoderHandle decoder_h
 /**********************************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecGetDecoderCaps(RocdecDecodeCaps *decode_caps);
 
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecAcquireDevice(RocdecDevicePlacementInfo *placement_info, int *device_id)
+//! \ingroup group_amd_rocdecode
+//! Picks the device with the most decode headroom for a new stream and books the stream's load on it until
+//! rocDecReleaseDevice() is called. The headroom of a device is estimated from the number of VCN instances supporting
+//! the stream (RocdecDecodeCaps::num_decoders), the decode rate measured for its live sessions, the highest aggregate
+//! decode rate observed on it, and the streams already placed on it. When every device is loaded beyond its capacity,
+//! the least oversubscribed one is returned.
+//! API returns ROCDEC_NOT_SUPPORTED if no visible device supports the codec, chroma format, bit depth and resolution.
+/**********************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecAcquireDevice(RocdecDevicePlacementInfo *placement_info, int *device_id);
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecReleaseDevice(RocdecDevicePlacementInfo *placement_info, int device_id)
+//! \ingroup group_amd_rocdecode
+//! Returns the load booked by rocDecAcquireDevice() for a stream once it's decoded. placement_info must hold the
+//! values used to acquire the device.
+/**********************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecReleaseDevice(RocdecDevicePlacementInfo *placement_info, int device_id);
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecoderMemoryInfo(RocdecDecoderMemoryInfo *memory_info)
+//! \ingroup group_amd_rocdecode
+//! Reports the number of decode surfaces and the surface memory a session needs before it is created. The surface
+//! count is derived from the DPB size and the reorder depth signaled in the SPS, plus one surface for the picture being
+//! decoded, one for the picture being output, and output_queue_depth surfaces held by the client. The value can be used
+//! as RocDecoderCreateInfo::num_decode_surfaces and returned from the sequence callback of the parser.
+//! API returns ROCDEC_NOT_SUPPORTED for unsupported chroma formats and bit depths.
+/**********************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecGetDecoderMemoryInfo(RocdecDecoderMemoryInfo *memory_info);
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecSetDecoderMemoryBudget(int device_id, uint64_t budget_in_bytes)
+//! \ingroup group_amd_rocdecode
+//! Sets the process-wide budget for the decode surfaces of all sessions on a device; 0 (the default) means no limit.
+//! rocDecCreateDecoder() and rocDecReconfigureDecoder() check a session against the budget before any surface is
+//! allocated, and fail with ROCDEC_OUTOF_MEMORY if its surfaces don't fit. A client can check a session beforehand with
+//! rocDecGetDecoderMemoryInfo() and drop the max_width x max_height reconfigure headroom of a session that doesn't fit.
+//! Lowering the budget doesn't affect live sessions.
+/**********************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecSetDecoderMemoryBudget(int device_id, uint64_t budget_in_bytes);
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecoderMemoryBudget(int device_id, uint64_t *budget_in_bytes, uint64_t *used_in_bytes)
+//! \ingroup group_amd_rocdecode
+//! Returns the decode surface memory budget of a device and the surface memory reserved by its live sessions
+/**********************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecGetDecoderMemoryBudget(int device_id, uint64_t *budget_in_bytes, uint64_t *used_in_bytes);
+
 /*****************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecDecodeFrame(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params)
 //! \ingroup group_amd_rocdecode
 //! Decodes a single picture
 //! Submits the frame for HW decoding 
+//! API returns ROCDEC_SURFACE_BUSY without submitting the picture if its surface holds a frame held with
+//! rocDecHoldVideoFrame() or exported with rocDecExportVideoFrame(); submit it again once the frame is released.
 /*****************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecDecodeFrame(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params);
 
+/*****************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecDecodeFrames(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params, uint32_t num_pictures)
+//! \ingroup group_amd_rocdecode
+//! Decodes a run of pictures
+//! Submits the num_pictures entries of the pic_params array for HW decoding back to back, in array order, with the
+//! per-call overhead of rocDecDecodeFrame paid once. The submission stops at the first picture that fails; the pictures
+//! before it have been submitted, including on ROCDEC_SURFACE_BUSY. With rocDecDecoderFlags_DeadlineScheduling, the run is dispatched as a whole: it is
+//! ordered with the submissions of the other decoders by the earliest deadline of its pictures, so keep runs short when
+//! their pictures have far apart deadlines.
+/*****************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecDecodeFrames(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params, uint32_t num_pictures);
+
 /************************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecGetDecodeStatus(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecDecodeStatus* decode_status);
 //! \ingroup group_amd_rocdecode
@@ -893,26 +1124,101 @@ extern rocDecStatus ROCDECAPI rocDecDecodeFrame(rocDecDecoderHandle decoder_hand
 /************************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecGetDecodeStatus(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecDecodeStatus* decode_status);
 
+/************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecodeCompletions(rocDecDecoderHandle decoder_handle, RocdecDecodeCompletion *completions,
+//!                                                       uint32_t max_completions, uint32_t *num_completions);
+//! \ingroup group_amd_rocdecode
+//! Drain up to max_completions entries from the completion queue of the decoder without blocking. The queue is filled
+//! by an internal thread as submitted pictures finish decoding, in submission order. The number of entries written to
+//! completions is returned in num_completions. The queue holds at most 1024 entries: when the application doesn't
+//! drain it, the oldest entries are dropped and counted in RocdecDecodeCompletion::num_dropped.
+//! API returns ROCDEC_NOT_SUPPORTED if the decoder was not created with rocDecDecoderFlags_CompletionQueue.
+/************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecGetDecodeCompletions(rocDecDecoderHandle decoder_handle, RocdecDecodeCompletion *completions,
+                                                        uint32_t max_completions, uint32_t *num_completions);
+
 /*********************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecReconfigureDecoder(rocDecDecoderHandle decoder_handle, RocdecReconfigureDecoderInfo *reconfig_params)
 //! \ingroup group_amd_rocdecode
 //! Used to reuse single decoder for multiple clips. Currently supports resolution change, resize params 
 //! params, target area params change for same codec. Must be called during RocdecParserParams::pfn_sequence_callback 
+//! Surfaces are allocated at max_width x max_height; as long as the new size fits into them, the surfaces, their HIP
+//! mappings and the decoding context are kept in place and only the picture dimensions change.
 /*********************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecReconfigureDecoder(rocDecDecoderHandle decoder_handle, RocdecReconfigureDecoderInfo *reconfig_params);
 
+/*********************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecResetDecoder(rocDecDecoderHandle decoder_handle)
+//! \ingroup group_amd_rocdecode
+//! Re-arms an existing decoder for a new stream of the same codec, chroma format and bit depth. Waits for all the
+//! submitted pictures to finish decoding, drops the pending completions and the data buffers of the last submission,
+//! and keeps the surfaces, their HIP mappings and the decoding context. A different resolution of the new stream is
+//! then handled by rocDecReconfigureDecoder(). Must not be called while frames from rocDecGetVideoFrame() are in use.
+/*********************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecResetDecoder(rocDecDecoderHandle decoder_handle);
+
 /************************************************************************************************************************/
 //! \fn extern rocDecStatus ROCDECAPI rocDecGetVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx,
 //!                                           uint32_t *dev_mem_ptr, uint32_t *horizontal_pitch,
 //!                                           RocdecProcParams *vid_postproc_params);
 //! \ingroup group_amd_rocdecode
 //! Post-process and map video frame corresponding to pic_idx for use in HIP. Returns HIP device pointer and associated
-//! pitch(horizontal stride) of the video frame. Returns device memory pointers and pitch for each plane (Y, U and V) seperately
+//! pitch(horizontal stride) of the video frame. Returns device memory pointers and pitch for each plane (Y, U and V) seperately.
+//! With RocDecoderCreateInfo::num_output_surfaces set, the pointers are only guaranteed to stay valid until the next
+//! rocDecGetVideoFrame call on the decoder, unless the frame is held with rocDecHoldVideoFrame() before this call.
 /************************************************************************************************************************/
 extern rocDecStatus ROCDECAPI rocDecGetVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx,
                                            void *dev_mem_ptr[3], uint32_t (&horizontal_pitch)[3],
                                            RocdecProcParams *vid_postproc_params);
 
+/************************************************************************************************************************/
+//! \fn extern rocDecStatus ROCDECAPI rocDecGetVideoFrameAsync(rocDecDecoderHandle decoder_handle, int pic_idx,
+//!                                           void *dev_mem_ptr[3], uint32_t (&horizontal_pitch)[3],
+//!                                           RocdecProcParams *vid_postproc_params);
+//! \ingroup group_amd_rocdecode
+//! Non-blocking variant of rocDecGetVideoFrame. Maps the surface corresponding to pic_idx for use in HIP and returns
+//! the device pointers and pitches immediately, without waiting for the decode of the surface to finish.
+//! vid_postproc_params->pfn_frame_ready is called with vid_postproc_params->frame_ready_user_data once the surface is
+//! ready; the returned memory must not be read before then. pfn_frame_ready must not be NULL.
+//! Frames are signalled in the order they were requested. The callback must not call back into the same decoder.
+//! Frames still waiting when the decoder is destroyed are signalled with ROCDEC_NOT_INITIALIZED from within
+//! rocDecDestroyDecoder(); their memory must not be read.
+/************************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecGetVideoFrameAsync(rocDecDecoderHandle decoder_handle, int pic_idx,
+                                           void *dev_mem_ptr[3], uint32_t (&horizontal_pitch)[3],
+                                           RocdecProcParams *vid_postproc_params);
+
+/************************************************************************************************************************/
+//! \fn extern rocDecStatus ROCDECAPI rocDecExportVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx,
+//!                                           RocdecExportedFrame *exported_frame);
+//! \ingroup group_amd_rocdecode
+//! Waits for the decode of the surface corresponding to pic_idx and exports it as DMA-BUF file descriptors with their
+//! plane offsets, pitches and DRM format modifier. With rocDecDecoderFlags_PostProcess, the post-processed output
+//! surface is exported, as returned by rocDecGetVideoFrame(). The surface is kept out of the decode pool until
+//! rocDecReleaseVideoFrame() is called with exported_frame->frame_id: a later picture decoding into it is refused by
+//! rocDecDecodeFrame() with ROCDEC_SURFACE_BUSY until the release.
+/************************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecExportVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecExportedFrame *exported_frame);
+
+/************************************************************************************************************************/
+//! \fn extern rocDecStatus ROCDECAPI rocDecHoldVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, uint64_t *frame_id);
+//! \ingroup group_amd_rocdecode
+//! Keeps the surface corresponding to pic_idx out of the decode pool, like rocDecExportVideoFrame() but without exporting
+//! it, until rocDecReleaseVideoFrame() is called with *frame_id. The mapping returned by rocDecGetVideoFrame() for
+//! pic_idx stays valid while the frame is held: held surfaces are not evicted to honour num_output_surfaces. Frames
+//! can be held and released in any order and from any output thread.
+/************************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecHoldVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, uint64_t *frame_id);
+
+/************************************************************************************************************************/
+//! \fn extern rocDecStatus ROCDECAPI rocDecReleaseVideoFrame(rocDecDecoderHandle decoder_handle, uint64_t frame_id);
+//! \ingroup group_amd_rocdecode
+//! Closes the file descriptors of a frame exported by rocDecExportVideoFrame(), or ends the hold of
+//! rocDecHoldVideoFrame(), and returns its surface to the decode pool. API returns ROCDEC_INVALID_PARAMETER if frame_id
+//! is not an outstanding export or hold of the decoder.
+/************************************************************************************************************************/
+extern rocDecStatus ROCDECAPI rocDecReleaseVideoFrame(rocDecDecoderHandle decoder_handle, uint64_t frame_id);
+
 /*****************************************************************************************************/
 //! \fn const char* ROCDECAPI rocDecGetErrorName(rocDecStatus rocdec_status)
 //! \ingroup group_amd_rocdecode
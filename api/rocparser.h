@@ -125,6 +125,10 @@ typedef struct {
     uint32_t max_width;
     uint32_t max_height;
     uint8_t  raw_seqhdr_data[1024];         /**< OUT: Sequence header data    */
+    uint8_t  max_dpb_frames;                /**< OUT: Maximum number of frames in the DPB of the sequence as signaled in the SPS */
+    uint8_t  max_num_reorder_frames;        /**< OUT: Maximum number of frames that can precede any frame in decoding order and
+                                                      follow it in output order; max_dpb_frames if not signaled             */
+    uint8_t  reserved[2];                   /**< Reserved for future use                                                 */
 } RocdecVideoFormatEx;
 
 /***************************************************************/
@@ -220,7 +224,11 @@ typedef struct _RocdecSeiMessageInfo {
  * \ Parser picks default operating point as 0 and outputAllLayers flag as 0 if PFNVIDOPPOINTCALLBACK is not set or return value is 
  * \ -1 or invalid operating point.
  * \ PFNVIDSEQUENCECALLBACK : 0: fail, 1: succeeded, > 1: override dpb size of parser (set by RocdecParserParams::max_num_decode_surfaces
- * \ while creating parser)
+ * \ while creating parser). The HEVC parser grows its DPB to the returned number of surfaces so that the frames held by
+ * \ the client are not decoded into; values below min_num_decode_surfaces are ignored. The AVC parser keeps the DPB size
+ * \ of the SPS, which also drives its bumping process. The RocdecVideoFormat passed to it
+ * \ is always the format member of a RocdecVideoFormatEx, which carries RocdecVideoFormatEx::max_dpb_frames and
+ * \ RocdecVideoFormatEx::max_num_reorder_frames.
  * \ PFNVIDDECODECALLBACK   : 0: fail, >=1: succeeded
  * \ PFNVIDDISPLAYCALLBACK  : 0: fail, >=1: succeeded
  * \ PFNVIDOPPOINTCALLBACK  : <0: fail, >=0: succeeded (bit 0-9: OperatingPoint, bit 10-10: outputAllLayers, bit 11-30: reserved)
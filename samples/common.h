@@ -23,6 +23,7 @@ THE SOFTWARE.
 #pragma once
 
 #include "roc_video_dec.h"
+#include "video_demuxer.h"
 
 typedef enum ReconfigFlushMode_enum {
     RECONFIG_FLUSH_MODE_NONE = 0,               /**<  Just flush to get the frame count */
@@ -70,14 +71,16 @@ int ReconfigureFlushCallback(void *p_viddec_obj, uint32_t flush_mode, void *p_us
     return n_frames_flushed;
 }
 
-int GetEnvVar(const char *name, int &dev_count) {
-    char *v = std::getenv(name);
-    if (v) {
-        char* p_tkn = std::strtok(v, ",");
-        while (p_tkn != nullptr) {
-            dev_count++;
-            p_tkn = strtok(nullptr, ",");
-        }
-    }
-    return dev_count;
+// fills the placement info rocDecAcquireDevice() uses to pick the device for the stream of the demuxer
+RocdecDevicePlacementInfo GetDevicePlacementInfo(VideoDemuxer *demuxer) {
+    RocdecDevicePlacementInfo placement_info = {};
+    placement_info.codec_type = AVCodec2RocDecVideoCodec(demuxer->GetCodecID());
+    placement_info.chroma_format = rocDecVideoChromaFormat_420;
+    placement_info.bit_depth_minus_8 = demuxer->GetBitDepth() - 8;
+    placement_info.width = demuxer->GetWidth();
+    placement_info.height = demuxer->GetHeight();
+    // the frame rate is passed in 1/1000 units to keep fractional rates such as 29.97
+    placement_info.frame_rate_numerator = static_cast<uint32_t>(demuxer->GetFrameRate() * 1000);
+    placement_info.frame_rate_denominator = 1000;
+    return placement_info;
 }
\ No newline at end of file
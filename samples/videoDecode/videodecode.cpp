@@ -38,6 +38,8 @@ THE SOFTWARE.
 #endif
 #include "video_demuxer.h"
 #include "roc_video_dec.h"
+#include "roc_video_dec_pipeline.h"
+#include "roc_video_dec_parallel.h"
 #include "common.h"
 
 void ShowHelpAndExit(const char *option = NULL) {
@@ -56,7 +58,10 @@ void ShowHelpAndExit(const char *option = NULL) {
     << "-seek_criteria - Demux seek criteria & value - optional; default - 0,0; "
     << "[0: no seek; 1: SEEK_CRITERIA_FRAME_NUM, frame number; 2: SEEK_CRITERIA_TIME_STAMP, frame number (time calculated internally)]" << std::endl
     << "-seek_mode - Seek to previous key frame or exact - optional; default - 0"
-    << "[0: SEEK_MODE_PREV_KEY_FRAME; 1: SEEK_MODE_EXACT_FRAME]" << std::endl;
+    << "[0: SEEK_MODE_PREV_KEY_FRAME; 1: SEEK_MODE_EXACT_FRAME]" << std::endl
+    << "-pipeline - demux, decode and consume the frames on separate threads with RocVideoDecoderPipeline; optional; seeking is not supported with it" << std::endl
+    << "-parallel Number of sessions - decode segments of the stream on several sessions placed with rocDecAcquireDevice(), using RocVideoDecoderParallel; optional; "
+    << "the frames are checked for presentation order; seeking, -o and -md5 are not supported with it" << std::endl;
     exit(0);
 }
 
@@ -80,6 +85,8 @@ int main(int argc, char **argv) {
     // seek options
     uint64_t seek_to_frame = 0;
     int seek_criteria = 0, seek_mode = 0;
+    bool b_use_pipeline = false;
+    uint32_t num_parallel_sessions = 0;
 
     // Parse command-line arguments
     if(argc <= 1) {
@@ -187,9 +194,23 @@ int main(int argc, char **argv) {
                 ShowHelpAndExit("-seek_mode");
             continue;
         }
+        if (!strcmp(argv[i], "-pipeline")) {
+            b_use_pipeline = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "-parallel")) {
+            if (++i == argc || atoi(argv[i]) < 1) {
+                ShowHelpAndExit("-parallel");
+            }
+            num_parallel_sessions = atoi(argv[i]);
+            continue;
+        }
 
         ShowHelpAndExit(argv[i]);
     }
+    if (num_parallel_sessions && (b_generate_md5 || !output_file_path.empty() || seek_criteria)) {
+        ShowHelpAndExit("-parallel");
+    }
 
     try {
         std::size_t found_file = input_file_path.find_last_of('/');
@@ -236,61 +257,116 @@ int main(int argc, char **argv) {
         if (b_md5_check) {
             ref_md5_file.open(md5_file_path.c_str(), std::ios::in);
         }
-        viddec.SetReconfigParams(&reconfig_params);
-
-        do {
+        if (b_use_pipeline) {
+            // the frames are taken out as DecodedFrame handles by the parser stage, not by the reconfigure flush callback.
+            // The non-blocking output depth makes the parser stage wait for the frames released below instead of
+            // stalling in DecodeFrame().
+            viddec.SetMaxOutputDepth(8, false);
+            RocVideoDecoderPipeline pipeline(viddec);
             auto start_time = std::chrono::high_resolution_clock::now();
-            if (seek_criteria == 1 && first_frame) {
-                // use VideoSeekContext class to seek to given frame number
-                video_seek_ctx.seek_frame_ = seek_to_frame;
-                video_seek_ctx.seek_crit_ = SEEK_CRITERIA_FRAME_NUM;
-                video_seek_ctx.seek_mode_ = (seek_mode ? SEEK_MODE_EXACT_FRAME : SEEK_MODE_PREV_KEY_FRAME);
-                demuxer.Seek(video_seek_ctx, &pvideo, &n_video_bytes);
-                pts = video_seek_ctx.out_frame_pts_;
-                std::cout << "info: Number of frames that were decoded during seek - " << video_seek_ctx.num_frames_decoded_ << std::endl;
-                first_frame = false;
-            } else if (seek_criteria == 2 && first_frame) {
-                // use VideoSeekContext class to seek to given timestamp
-                video_seek_ctx.seek_frame_ = seek_to_frame;
-                video_seek_ctx.seek_crit_ = SEEK_CRITERIA_TIME_STAMP;
-                video_seek_ctx.seek_mode_ = (seek_mode ? SEEK_MODE_EXACT_FRAME : SEEK_MODE_PREV_KEY_FRAME);
-                demuxer.Seek(video_seek_ctx, &pvideo, &n_video_bytes);
-                pts = video_seek_ctx.out_frame_pts_;
-                std::cout << "info: Duration of frame found after seek - " << video_seek_ctx.out_frame_duration_ << " ms" << std::endl;
-                first_frame = false;
-            } else {
-                demuxer.Demux(&pvideo, &n_video_bytes, &pts);
-            }
-            // Treat 0 bitstream size as end of stream indicator
-            if (n_video_bytes == 0) {
-                pkg_flags |= ROCDEC_PKT_ENDOFSTREAM;
-            }
-            n_frame_returned = viddec.DecodeFrame(pvideo, n_video_bytes, pkg_flags, pts);
-
-            if (!n_frame && !viddec.GetOutputSurfaceInfo(&surf_info)) {
-                std::cerr << "Error: Failed to get Output Surface Info!" << std::endl;
-                break;
-            }
-            for (int i = 0; i < n_frame_returned; i++) {
-                pframe = viddec.GetFrame(&pts);
+            pipeline.Start([&demuxer](uint8_t **data, int *size, int64_t *pts) { return demuxer.Demux(data, size, pts); });
+            for (DecodedFrame frame = pipeline.GetFrame(); frame; frame = pipeline.GetFrame()) {
+                if (!n_frame && !viddec.GetOutputSurfaceInfo(&surf_info)) {
+                    std::cerr << "Error: Failed to get Output Surface Info!" << std::endl;
+                    break;
+                }
                 if (b_generate_md5) {
-                    viddec.UpdateMd5ForFrame(pframe, surf_info);
+                    viddec.UpdateMd5ForFrame(frame.GetData(), surf_info);
                 }
                 if (dump_output_frames && mem_type != OUT_SURFACE_MEM_NOT_MAPPED) {
-                    viddec.SaveFrameToFile(output_file_path, pframe, surf_info);
+                    viddec.SaveFrameToFile(output_file_path, frame.GetData(), surf_info);
+                }
+                n_frame++;
+                if (num_decoded_frames && num_decoded_frames <= n_frame) {
+                    break;
                 }
-                // release frame
-                viddec.ReleaseFrame(pts);
             }
+            pipeline.Stop();
             auto end_time = std::chrono::high_resolution_clock::now();
-            auto time_per_decode = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-            total_dec_time += time_per_decode;
-            n_frame += n_frame_returned;
-            if (num_decoded_frames && num_decoded_frames <= n_frame) {
-                break;
+            total_dec_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        } else if (num_parallel_sessions) {
+            // every session has its own decoder, so the frames are only counted and checked for presentation order here.
+            // The non-blocking output depth makes a session wait for the frames released below instead of stalling in
+            // DecodeFrame().
+            ParallelDecoderFactory decoder_factory = [&](int session_device_id) {
+                auto session_decoder = std::make_unique<RocVideoDecoder>(session_device_id, mem_type, rocdec_codec_id, b_force_zero_latency,
+                    p_crop_rect, b_extract_sei_messages);
+                session_decoder->SetMaxOutputDepth(8, false);
+                return session_decoder;
+            };
+            RocVideoDecoderParallel parallel_decoder(num_parallel_sessions, GetDevicePlacementInfo(&demuxer), decoder_factory);
+            auto start_time = std::chrono::high_resolution_clock::now();
+            parallel_decoder.Start([&demuxer](uint8_t **data, int *size, int64_t *pts) { return demuxer.Demux(data, size, pts); });
+            int64_t last_pts = 0;
+            for (DecodedFrame frame = parallel_decoder.GetFrame(); frame; frame = parallel_decoder.GetFrame()) {
+                if (n_frame && frame.GetPts() <= last_pts) {
+                    THROW("frame " + std::to_string(n_frame) + " of the parallel sessions is out of presentation order");
+                }
+                last_pts = frame.GetPts();
+                n_frame++;
+                if (num_decoded_frames && num_decoded_frames <= n_frame) {
+                    break;
+                }
             }
+            parallel_decoder.Stop();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            total_dec_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        } else {
+            viddec.SetReconfigParams(&reconfig_params);
+            do {
+                auto start_time = std::chrono::high_resolution_clock::now();
+                if (seek_criteria == 1 && first_frame) {
+                    // use VideoSeekContext class to seek to given frame number
+                    video_seek_ctx.seek_frame_ = seek_to_frame;
+                    video_seek_ctx.seek_crit_ = SEEK_CRITERIA_FRAME_NUM;
+                    video_seek_ctx.seek_mode_ = (seek_mode ? SEEK_MODE_EXACT_FRAME : SEEK_MODE_PREV_KEY_FRAME);
+                    demuxer.Seek(video_seek_ctx, &pvideo, &n_video_bytes);
+                    pts = video_seek_ctx.out_frame_pts_;
+                    std::cout << "info: Number of frames that were decoded during seek - " << video_seek_ctx.num_frames_decoded_ << std::endl;
+                    first_frame = false;
+                } else if (seek_criteria == 2 && first_frame) {
+                    // use VideoSeekContext class to seek to given timestamp
+                    video_seek_ctx.seek_frame_ = seek_to_frame;
+                    video_seek_ctx.seek_crit_ = SEEK_CRITERIA_TIME_STAMP;
+                    video_seek_ctx.seek_mode_ = (seek_mode ? SEEK_MODE_EXACT_FRAME : SEEK_MODE_PREV_KEY_FRAME);
+                    demuxer.Seek(video_seek_ctx, &pvideo, &n_video_bytes);
+                    pts = video_seek_ctx.out_frame_pts_;
+                    std::cout << "info: Duration of frame found after seek - " << video_seek_ctx.out_frame_duration_ << " ms" << std::endl;
+                    first_frame = false;
+                } else {
+                    demuxer.Demux(&pvideo, &n_video_bytes, &pts);
+                }
+                // Treat 0 bitstream size as end of stream indicator
+                if (n_video_bytes == 0) {
+                    pkg_flags |= ROCDEC_PKT_ENDOFSTREAM;
+                }
+                n_frame_returned = viddec.DecodeFrame(pvideo, n_video_bytes, pkg_flags, pts);
+
+                if (!n_frame && !viddec.GetOutputSurfaceInfo(&surf_info)) {
+                    std::cerr << "Error: Failed to get Output Surface Info!" << std::endl;
+                    break;
+                }
+                for (int i = 0; i < n_frame_returned; i++) {
+                    pframe = viddec.GetFrame(&pts);
+                    if (b_generate_md5) {
+                        viddec.UpdateMd5ForFrame(pframe, surf_info);
+                    }
+                    if (dump_output_frames && mem_type != OUT_SURFACE_MEM_NOT_MAPPED) {
+                        viddec.SaveFrameToFile(output_file_path, pframe, surf_info);
+                    }
+                    // release frame
+                    viddec.ReleaseFrame(pts);
+                }
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto time_per_decode = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                total_dec_time += time_per_decode;
+                n_frame += n_frame_returned;
+                if (num_decoded_frames && num_decoded_frames <= n_frame) {
+                    break;
+                }
 
-        } while (n_video_bytes);
+            } while (n_video_bytes);
+        }
         
         n_frame += viddec.GetNumOfFlushedFrames();
         std::cout << "info: Total frame decoded: " << n_frame << std::endl;
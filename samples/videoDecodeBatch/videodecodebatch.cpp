@@ -41,6 +41,7 @@ THE SOFTWARE.
 #endif
 #include "video_demuxer.h"
 #include "roc_video_dec.h"
+#include "roc_video_dec_pool.h"
 #include "common.h"
 
 class ThreadPool {
@@ -109,8 +110,9 @@ struct DecoderInfo {
     std::uint32_t bit_depth;
     rocDecVideoCodec rocdec_codec_id;
     std::atomic_bool decoding_complete;
+    RocdecDevicePlacementInfo placement_info;
 
-    DecoderInfo() : dec_device_id(0), viddec(nullptr), bit_depth(8) , decoding_complete(false) {}
+    DecoderInfo() : dec_device_id(0), viddec(nullptr), bit_depth(8) , decoding_complete(false), placement_info{} {}
 };
 
 void DecProc(RocVideoDecoder *p_dec, VideoDemuxer *demuxer, int *pn_frame, double *pn_fps, std::atomic_bool &decoding_complete, bool &b_dump_output_frames, std::string &output_file_name, OutputSurfaceMemoryType mem_type) {
@@ -156,7 +158,7 @@ void ShowHelpAndExit(const char *option = NULL) {
     std::cout << "Options:" << std::endl
     << "-i <directory containing input video files [required]> " << std::endl
     << "-t Number of threads ( 1 >= n_thread <= 64) - optional; default: 4" << std::endl
-    << "-d Device ID (>= 0)  - optional; default: 0" << std::endl
+    << "-d Device ID (>= 0)  - optional; default: each file is placed on the device with the most decode headroom" << std::endl
     << "-o Directory for output YUV files - optional" << std::endl
     << "-m output_surface_memory_type - decoded surface memory; optional; default - 3" << std::endl;
     exit(0);
@@ -231,7 +233,7 @@ void ParseCommandLine(std::string &input_folder_path, std::string &output_folder
 int main(int argc, char **argv) {
 
     std::string input_folder_path, output_folder_path;
-    int device_id = 0, num_files = 0;
+    int device_id = -1, num_files = 0;
     int n_thread = 4;
     Rect *p_crop_rect = nullptr;
     OutputSurfaceMemoryType mem_type = OUT_SURFACE_MEM_DEV_INTERNAL;        // set to decode only for performance
@@ -251,36 +253,7 @@ int main(int argc, char **argv) {
 
         std::vector<std::string> output_file_names(num_files);
         n_thread = ((n_thread > num_files) ? num_files : n_thread);
-        int num_devices = 0, sd = 0;
-        hipError_t hip_status = hipSuccess;
-        hipDeviceProp_t hip_dev_prop;
-        std::string gcn_arch_name;
-        hip_status = hipGetDeviceCount(&num_devices);
-        if (hip_status != hipSuccess) {
-            std::cout << "ERROR: hipGetDeviceCount failed! (" << hip_status << ")" << std::endl;
-            return -1;
-        }
-        if (num_devices < 1) {
-            ERR("ERROR: didn't find any GPU!");
-            return -1;
-        }
-
-        hip_status = hipGetDeviceProperties(&hip_dev_prop, device_id);
-        if (hip_status != hipSuccess) {
-            ERR("ERROR: hipGetDeviceProperties for device (" +TOSTR(device_id) + " ) failed! (" + hipGetErrorName(hip_status) + ")" );
-            return -1;
-        }
-
-        gcn_arch_name = hip_dev_prop.gcnArchName;
-        std::size_t pos = gcn_arch_name.find_first_of(":");
-        std::string gcn_arch_name_base = (pos != std::string::npos) ? gcn_arch_name.substr(0, pos) : gcn_arch_name;
-
-        // gfx90a has two GCDs as two separate devices 
-        if (!gcn_arch_name_base.compare("gfx90a") && num_devices > 1) {
-            sd = 1;
-        }
-
-        std::string device_name;
+        std::string device_name, gcn_arch_name;
         int pci_bus_id, pci_domain_id, pci_device_id;
         double total_fps = 0;
         int n_total = 0;
@@ -288,13 +261,10 @@ int main(int argc, char **argv) {
         std::vector<int> v_frame;
         v_fps.resize(num_files, 0);
         v_frame.resize(num_files, 0);
-        int hip_vis_dev_count = 0;
-        GetEnvVar("HIP_VISIBLE_DEVICES", hip_vis_dev_count);
-
         std::cout << "info: Number of threads: " << n_thread << std::endl;
 
         std::vector<std::unique_ptr<VideoDemuxer>> v_demuxer(num_files);
-        std::unique_ptr<RocVideoDecoder> dec_8bit_avc(nullptr), dec_8bit_hevc(nullptr), dec_10bit_hevc(nullptr);
+        RocVideoDecoderPool decoder_pool(mem_type, b_force_zero_latency, p_crop_rect);
         std::vector<std::unique_ptr<DecoderInfo>> v_dec_info;
         ThreadPool thread_pool(n_thread);
 
@@ -323,36 +293,35 @@ int main(int argc, char **argv) {
             }
         }
 
-        for (int i = 0; i < n_thread; i++) {
-            v_dec_info.emplace_back(std::make_unique<DecoderInfo>());
-            if (!hip_vis_dev_count) {
-                if (device_id % 2 == 0) {
-                    v_dec_info[i]->dec_device_id = (i % 2 == 0) ? device_id : device_id + sd;
-                } else
-                    v_dec_info[i]->dec_device_id = (i % 2 == 0) ? device_id - sd : device_id;
-            } else {
-                v_dec_info[i]->dec_device_id = i % hip_vis_dev_count;
-            }
-
-            v_dec_info[i]->rocdec_codec_id = AVCodec2RocDecVideoCodec(v_demuxer[i]->GetCodecID());
-            v_dec_info[i]->bit_depth = v_demuxer[i]->GetBitDepth();
-            if (v_dec_info[i]->bit_depth == 8) {
-                if (v_dec_info[i]->rocdec_codec_id == rocDecVideoCodec_AVC) {
-                    std::unique_ptr<RocVideoDecoder> dec_8bit_avc(new RocVideoDecoder(v_dec_info[i]->dec_device_id, mem_type, v_dec_info[i]->rocdec_codec_id, b_force_zero_latency, p_crop_rect));
-                    v_dec_info[i]->viddec = std::move(dec_8bit_avc);
-                } else if (v_dec_info[i]->rocdec_codec_id == rocDecVideoCodec_HEVC){
-                    std::unique_ptr<RocVideoDecoder> dec_8bit_hevc(new RocVideoDecoder(v_dec_info[i]->dec_device_id, mem_type, v_dec_info[i]->rocdec_codec_id, b_force_zero_latency, p_crop_rect));
-                    v_dec_info[i]->viddec = std::move(dec_8bit_hevc);
+        // places file_idx on a device and takes a warm decoder for it from the pool
+        auto assign_file = [&](DecoderInfo *dec_info, int file_idx) {
+            if (device_id < 0) {
+                dec_info->placement_info = GetDevicePlacementInfo(v_demuxer[file_idx].get());
+                if (rocDecAcquireDevice(&dec_info->placement_info, &dec_info->dec_device_id) != ROCDEC_SUCCESS) {
+                    THROW("no device supports " + input_file_names[file_idx]);
                 }
             } else {
-                std::unique_ptr<RocVideoDecoder> dec_10bit_hevc(new RocVideoDecoder(v_dec_info[i]->dec_device_id, mem_type, v_dec_info[i]->rocdec_codec_id, b_force_zero_latency, p_crop_rect));
-                v_dec_info[i]->viddec = std::move(dec_10bit_hevc);
+                dec_info->dec_device_id = device_id;
             }
-
-            v_dec_info[i]->viddec->GetDeviceinfo(device_name, gcn_arch_name, pci_bus_id, pci_domain_id, pci_device_id);
-            std::cout << "info: decoding " << input_file_names[i] << " using GPU device " << v_dec_info[i]->dec_device_id << " - " << device_name << "[" << gcn_arch_name << "] on PCI bus " <<
+            dec_info->rocdec_codec_id = AVCodec2RocDecVideoCodec(v_demuxer[file_idx]->GetCodecID());
+            dec_info->bit_depth = v_demuxer[file_idx]->GetBitDepth();
+            dec_info->viddec = decoder_pool.Acquire(dec_info->dec_device_id, dec_info->rocdec_codec_id);
+            dec_info->viddec->GetDeviceinfo(device_name, gcn_arch_name, pci_bus_id, pci_domain_id, pci_device_id);
+            std::cout << "info: decoding " << input_file_names[file_idx] << " using GPU device " << dec_info->dec_device_id << " - " << device_name << "[" << gcn_arch_name << "] on PCI bus " <<
             std::setfill('0') << std::setw(2) << std::right << std::hex << pci_bus_id << ":" << std::setfill('0') << std::setw(2) <<
             std::right << std::hex << pci_domain_id << "." << pci_device_id << std::dec << std::endl;
+        };
+        // hands the decoder of a finished file back to the pool and returns the file's load to the scheduler
+        auto release_file = [&](DecoderInfo *dec_info) {
+            decoder_pool.Release(dec_info->dec_device_id, std::move(dec_info->viddec));
+            if (device_id < 0) {
+                rocDecReleaseDevice(&dec_info->placement_info, dec_info->dec_device_id);
+            }
+        };
+
+        for (int i = 0; i < n_thread; i++) {
+            v_dec_info.emplace_back(std::make_unique<DecoderInfo>());
+            assign_file(v_dec_info[i].get(), i);
         }
 
         std::mutex mutex;
@@ -365,45 +334,17 @@ int main(int argc, char **argv) {
                     while (!v_dec_info[thread_idx]->decoding_complete);
                     v_dec_info[thread_idx]->decoding_complete = false;
                 }
-                uint32_t bit_depth = v_demuxer[j]->GetBitDepth();
-                rocDecVideoCodec codec_id = AVCodec2RocDecVideoCodec(v_demuxer[j]->GetCodecID());
-                if (v_dec_info[thread_idx]->bit_depth != bit_depth || v_dec_info[thread_idx]->rocdec_codec_id != codec_id) {
-                    if (bit_depth == 8) { // can be HEVC or H.264
-                        if (dec_8bit_avc == nullptr && codec_id == rocDecVideoCodec_AVC) {
-                            std::unique_ptr<RocVideoDecoder> dec_8bit_avc(new RocVideoDecoder(v_dec_info[thread_idx]->dec_device_id, mem_type, codec_id, b_force_zero_latency, p_crop_rect));
-                            v_dec_info[thread_idx]->viddec = std::move(dec_8bit_avc);
-                        } else if (dec_8bit_hevc == nullptr && codec_id == rocDecVideoCodec_HEVC) {
-                            std::unique_ptr<RocVideoDecoder> dec_8bit_hevc(new RocVideoDecoder(v_dec_info[thread_idx]->dec_device_id, mem_type, codec_id, b_force_zero_latency, p_crop_rect));
-                            v_dec_info[thread_idx]->viddec = std::move(dec_8bit_hevc);
-                        } else {
-                            if (codec_id == rocDecVideoCodec_AVC) {
-                                v_dec_info[thread_idx]->viddec.swap(dec_8bit_avc);
-                            }  else {
-                                v_dec_info[thread_idx]->viddec.swap(dec_8bit_hevc);
-                            }
-                        }
-                        v_dec_info[thread_idx]->bit_depth = bit_depth;
-                        v_dec_info[thread_idx]->rocdec_codec_id = codec_id;
-                    } else { // bit_depth = 10bit; only HEVC
-                        if (dec_10bit_hevc == nullptr) {
-                            std::unique_ptr<RocVideoDecoder> dec_10bit_hevc(new RocVideoDecoder(v_dec_info[thread_idx]->dec_device_id, mem_type, codec_id, b_force_zero_latency, p_crop_rect));
-                            v_dec_info[thread_idx]->viddec = std::move(dec_10bit_hevc);
-                        } else {
-                            v_dec_info[thread_idx]->viddec.swap(dec_10bit_hevc);
-                        }
-                        v_dec_info[thread_idx]->bit_depth = bit_depth;
-                        v_dec_info[thread_idx]->rocdec_codec_id = codec_id;
-                    }
-                }
-                v_dec_info[thread_idx]->viddec->GetDeviceinfo(device_name, gcn_arch_name, pci_bus_id, pci_domain_id, pci_device_id);
-                std::cout << "info: decoding " << input_file_names[j] << " using GPU device " << v_dec_info[thread_idx]->dec_device_id << " - " << device_name << "[" << gcn_arch_name << "] on PCI bus " <<
-                std::setfill('0') << std::setw(2) << std::right << std::hex << pci_bus_id << ":" << std::setfill('0') << std::setw(2) <<
-                std::right << std::hex << pci_domain_id << "." << pci_device_id << std::dec << std::endl;
+                // take a warm decoder for the next file instead of creating a new one
+                release_file(v_dec_info[thread_idx].get());
+                assign_file(v_dec_info[thread_idx].get(), j);
             }
             thread_pool.ExecuteJob(std::bind(DecProc, v_dec_info[thread_idx]->viddec.get(), v_demuxer[j].get(), &v_frame[j], &v_fps[j], std::ref(v_dec_info[thread_idx]->decoding_complete), b_dump_output_frames, output_file_names[j], mem_type));
         }
 
         thread_pool.JoinThreads();
+        for (int i = 0; i < n_thread; i++) {
+            release_file(v_dec_info[i].get());
+        }
         for (int i = 0; i < num_files; i++) {
             total_fps += v_fps[i] * static_cast<double>(n_thread) / static_cast<double>(num_files);
             n_total += v_frame[i];
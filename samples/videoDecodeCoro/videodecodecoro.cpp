@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include "video_demuxer.h"
+#include "roc_video_dec.h"
+#include "roc_video_dec_coro.h"
+#include "common.h"
+
+#if !defined(__cpp_impl_coroutine)
+#error "videodecodecoro needs a C++20 compiler with coroutine support"
+#endif
+
+#define OUTPUT_DEPTH 4   // frames a session may have in flight before its packets are refused with ROCDEC_DECODE_WOULD_BLOCK
+
+typedef struct SessionInfo {
+    std::unique_ptr<VideoDemuxer> demuxer;
+    std::unique_ptr<RocVideoDecoder> viddec;
+    std::unique_ptr<AsyncRocVideoDecoder> async_dec;
+    int device_id = 0;
+    RocdecDevicePlacementInfo placement_info = {};
+    bool is_device_acquired = false;
+    int n_frame = 0;
+    uint8_t digest[16] = {};
+} SessionInfo;
+
+/**
+ * @brief decodes the whole stream of one session on the workers of the executor. The coroutine only holds a worker while a
+ *        packet is decoded or a frame is consumed, and is suspended while its frames are still being decoded.
+ */
+DecodeTask DecodeSession(SessionInfo &session, DecodeExecutor &executor, bool b_generate_md5) {
+    co_await executor.Schedule();
+    AsyncRocVideoDecoder &async_dec = *session.async_dec;
+    RocVideoDecoder &viddec = async_dec.GetDecoder();
+    OutputSurfaceInfo *surf_info = nullptr;
+    uint8_t *p_video = nullptr;
+    int n_video_bytes = 0, n_frame_returned = 0;
+    int64_t pts = 0;
+    bool is_end_of_stream = false;
+
+    if (b_generate_md5) {
+        viddec.InitMd5();
+    }
+    do {
+        if (!is_end_of_stream) {
+            session.demuxer->Demux(&p_video, &n_video_bytes, &pts);
+            is_end_of_stream = !n_video_bytes;
+        }
+        // a packet refused with ROCDEC_DECODE_WOULD_BLOCK is submitted again once the frames of the session are consumed
+        do {
+            n_frame_returned = co_await async_dec.Submit(is_end_of_stream ? nullptr : p_video, is_end_of_stream ? 0 : n_video_bytes, pts);
+            while (DecodedFrame frame = co_await async_dec.NextFrame()) {
+                if (!surf_info && !viddec.GetOutputSurfaceInfo(&surf_info)) {
+                    THROW("Failed to get Output Surface Info!");
+                }
+                if (b_generate_md5) {
+                    viddec.UpdateMd5ForFrame(frame.GetData(), surf_info);
+                }
+                session.n_frame++;
+            }
+        } while (n_frame_returned == ROCDEC_DECODE_WOULD_BLOCK);
+    } while (!is_end_of_stream || n_frame_returned > 0);
+
+    if (b_generate_md5) {
+        uint8_t *digest;
+        viddec.FinalizeMd5(&digest);
+        memcpy(session.digest, digest, sizeof(session.digest));
+    }
+}
+
+void ShowHelpAndExit(const char *option = NULL) {
+    std::cout << "Options:" << std::endl
+    << "-i Input File Path - required" << std::endl
+    << "-s Number of decode sessions (>= 1) - optional; default: 4" << std::endl
+    << "-t Number of executor threads (>= 1) - optional; default: 2" << std::endl
+    << "-d Device ID (>= 0)  - optional; default: each session is placed on the device with the most decode headroom" << std::endl
+    << "-md5 generate MD5 message digest on the decoded YUV image sequence of each session and check that they all match; optional;" << std::endl
+    << "-z force_zero_latency (force_zero_latency, Decoded frames will be flushed out for display immediately); optional;" << std::endl;
+    exit(0);
+}
+
+int main(int argc, char **argv) {
+
+    std::string input_file_path;
+    int device_id = -1;
+    int n_session = 4;
+    int n_thread = 2;
+    Rect *p_crop_rect = nullptr;
+    OutputSurfaceMemoryType mem_type = OUT_SURFACE_MEM_DEV_INTERNAL;      // required by AsyncRocVideoDecoder
+    bool b_force_zero_latency = false;
+    bool b_generate_md5 = false;
+    // Parse command-line arguments
+    if(argc <= 1) {
+        ShowHelpAndExit();
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h")) {
+            ShowHelpAndExit();
+        }
+        if (!strcmp(argv[i], "-i")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-i");
+            }
+            input_file_path = argv[i];
+            continue;
+        }
+        if (!strcmp(argv[i], "-s")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-s");
+            }
+            n_session = atoi(argv[i]);
+            if (n_session <= 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-t")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-t");
+            }
+            n_thread = atoi(argv[i]);
+            if (n_thread <= 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-d")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-d");
+            }
+            device_id = atoi(argv[i]);
+            if (device_id < 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-md5")) {
+            b_generate_md5 = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "-z")) {
+            b_force_zero_latency = true;
+            continue;
+        }
+        ShowHelpAndExit(argv[i]);
+    }
+
+    // the sessions are destroyed before the executor their frame-ready callbacks post to
+    DecodeExecutor executor(n_thread);
+    std::vector<SessionInfo> v_session(n_session);
+    int ret = 0;
+    try {
+        std::size_t found_file = input_file_path.find_last_of('/');
+        std::cout << "info: Input file: " << input_file_path.substr(found_file + 1) << std::endl;
+        std::cout << "info: Number of sessions: " << n_session << ", number of executor threads: " << n_thread << std::endl;
+
+        std::string device_name, gcn_arch_name;
+        int pci_bus_id, pci_domain_id, pci_device_id;
+
+        for (int i = 0; i < n_session; i++) {
+            SessionInfo &session = v_session[i];
+            session.demuxer.reset(new VideoDemuxer(input_file_path.c_str()));
+            rocDecVideoCodec rocdec_codec_id = AVCodec2RocDecVideoCodec(session.demuxer->GetCodecID());
+            if (device_id < 0) {
+                // let rocDecode place the session on the device with the most decode headroom
+                session.placement_info = GetDevicePlacementInfo(session.demuxer.get());
+                if (rocDecAcquireDevice(&session.placement_info, &session.device_id) != ROCDEC_SUCCESS) {
+                    THROW("no device supports the stream!");
+                }
+                session.is_device_acquired = true;
+            } else {
+                session.device_id = device_id;
+            }
+            session.viddec.reset(new RocVideoDecoder(session.device_id, mem_type, rocdec_codec_id, b_force_zero_latency, p_crop_rect));
+            session.viddec->SetMaxOutputDepth(OUTPUT_DEPTH, false);
+            session.async_dec.reset(new AsyncRocVideoDecoder(*session.viddec, executor));
+
+            session.viddec->GetDeviceinfo(device_name, gcn_arch_name, pci_bus_id, pci_domain_id, pci_device_id);
+            std::cout << "info: session " << i << " using GPU device " << session.device_id << " - " << device_name << "[" << gcn_arch_name << "] on PCI bus " <<
+            std::setfill('0') << std::setw(2) << std::right << std::hex << pci_bus_id << ":" << std::setfill('0') << std::setw(2) <<
+            std::right << std::hex << pci_domain_id << "." << pci_device_id << std::dec << std::endl;
+        }
+
+        std::cout << "info: decoding started, please wait!" << std::endl;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        std::vector<DecodeTask> v_task;
+        for (int i = 0; i < n_session; i++) {
+            v_task.push_back(DecodeSession(v_session[i], executor, b_generate_md5));
+        }
+        // wait for every session before reporting a failed one, the others still decode into their sessions
+        std::exception_ptr session_exception;
+        for (auto &task : v_task) {
+            try {
+                task.Wait();
+            } catch (...) {
+                if (!session_exception) session_exception = std::current_exception();
+            }
+        }
+        if (session_exception) {
+            std::rethrow_exception(session_exception);
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double total_dec_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+        int n_total = 0;
+        for (int i = 0; i < n_session; i++) {
+            n_total += v_session[i].n_frame;
+            std::cout << "info: session " << i << " decoded " << v_session[i].n_frame << " frames";
+            if (b_generate_md5) {
+                std::cout << ", MD5 message digest: ";
+                for (int j = 0; j < 16; j++) {
+                    std::cout << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(v_session[i].digest[j]);
+                }
+                std::cout << std::dec;
+            }
+            std::cout << std::endl;
+            // every session decodes the same stream, so they all have to return the same frames
+            if (v_session[i].n_frame != v_session[0].n_frame ||
+                (b_generate_md5 && memcmp(v_session[i].digest, v_session[0].digest, sizeof(v_session[i].digest)))) {
+                std::cerr << "ERROR: session " << i << " does not match session 0!" << std::endl;
+                ret = 1;
+            }
+        }
+        std::cout << "info: Total frame decoded: " << n_total << std::endl;
+        if (n_total) {
+            std::cout << "info: avg decoding time per frame: " << total_dec_time / n_total << " ms" << std::endl;
+            std::cout << "info: avg FPS: " << (n_total / total_dec_time) * 1000 << std::endl;
+        }
+    } catch (const std::exception &ex) {
+        std::cout << ex.what() << std::endl;
+        ret = 1;
+    }
+
+    for (auto &session : v_session) {
+        session.async_dec.reset();
+        session.viddec.reset();
+        if (session.is_device_acquired) {
+            rocDecReleaseDevice(&session.placement_info, session.device_id);
+        }
+    }
+
+    return ret;
+}
@@ -68,8 +68,8 @@ void ShowHelpAndExit(const char *option = NULL) {
     << "...." << std::endl
     << "...." << std::endl
     << "-d GPU device ID (0 for the first device, 1 for the second, etc.); optional; default: 0" << std::endl
-    << "-use_reconfigure flag (bool - 0/1); optional; default: 1; set 0 to disable reconfigure api for decoding multiple files; "
-    << "only resolution changes between files are supported when reconfigure is enabled. The codec, bit_depth, and the chroma_format must be the same between files." << std::endl;
+    << "-use_reconfigure flag (bool - 0/1); optional; default: 1; set 0 to create a new decoder for every file; "
+    << "when enabled, the decoder is reset between files and reconfigured on resolution changes. A change of the codec, bit_depth, or chroma_format between files recreates the decoder session only." << std::endl;
     exit(0);
 }
 
@@ -188,6 +188,9 @@ int main(int argc, char **argv) {
 
                 if (!viddec) {
                     viddec = new RocVideoDecoder(device_id, file_data.mem_type, rocdec_codec_id, file_data.b_force_zero_latency, file_data.p_crop_rect, file_data.b_extract_sei_messages);
+                } else {
+                    // re-arm the existing decoder for the next file; a codec change only recreates the parser and the decoder session
+                    viddec->Reset(rocdec_codec_id);
                 }
             } else {
                 viddec = new RocVideoDecoder(device_id, file_data.mem_type, rocdec_codec_id, file_data.b_force_zero_latency, file_data.p_crop_rect, file_data.b_extract_sei_messages);
@@ -65,7 +65,7 @@ void ShowHelpAndExit(const char *option = NULL) {
     std::cout << "Options:" << std::endl
     << "-i Input File Path - required" << std::endl
     << "-t Number of threads (>= 1) - optional; default: 4" << std::endl
-    << "-d Device ID (>= 0)  - optional; default: 0" << std::endl
+    << "-d Device ID (>= 0)  - optional; default: each stream is placed on the device with the most decode headroom" << std::endl
     << "-z force_zero_latency (force_zero_latency, Decoded frames will be flushed out for display immediately); optional;" << std::endl;
     exit(0);
 }
@@ -73,7 +73,7 @@ void ShowHelpAndExit(const char *option = NULL) {
 int main(int argc, char **argv) {
 
     std::string input_file_path;
-    int device_id = 0;
+    int device_id = -1;
     int n_thread = 4;
     Rect *p_crop_rect = nullptr;
     OutputSurfaceMemoryType mem_type = OUT_SURFACE_MEM_NOT_MAPPED;        // set to decode only for performance
@@ -124,43 +124,10 @@ int main(int argc, char **argv) {
     }
     
     try {
-        // TODO: Change this block to use VCN query API 
-        int num_devices = 0, sd = 0;
-        hipError_t hip_status = hipSuccess;
-        hipDeviceProp_t hip_dev_prop;
-        std::string gcn_arch_name;
-        hip_status = hipGetDeviceCount(&num_devices);
-        if (hip_status != hipSuccess) {
-            std::cout << "ERROR: hipGetDeviceCount failed! (" << hip_status << ")" << std::endl;
-            return -1;
-        }
-
-        if (num_devices < 1) {
-            ERR("ERROR: didn't find any GPU!");
-            return -1;
-        }
-
-        hip_status = hipGetDeviceProperties(&hip_dev_prop, device_id);
-        if (hip_status != hipSuccess) {
-            ERR("ERROR: hipGetDeviceProperties for device (" +TOSTR(device_id) + " ) failed! (" + hipGetErrorName(hip_status) + ")" );
-            return -1;
-        }
-
-        gcn_arch_name = hip_dev_prop.gcnArchName;
-        std::size_t pos = gcn_arch_name.find_first_of(":");
-        std::string gcn_arch_name_base = (pos != std::string::npos) ? gcn_arch_name.substr(0, pos) : gcn_arch_name;
-
-        // gfx90a has two GCDs as two separate devices 
-        if (!gcn_arch_name_base.compare("gfx90a") && num_devices > 1) {
-            sd = 1;
-        }
-
         std::vector<std::unique_ptr<VideoDemuxer>> v_demuxer;
         std::vector<std::unique_ptr<RocVideoDecoder>> v_viddec;
         std::vector<int> v_device_id(n_thread);
-
-        int hip_vis_dev_count = 0;
-        GetEnvVar("HIP_VISIBLE_DEVICES", hip_vis_dev_count);
+        std::vector<RocdecDevicePlacementInfo> v_placement_info(n_thread);
 
         std::size_t found_file = input_file_path.find_last_of('/');
         std::cout << "info: Input file: " << input_file_path.substr(found_file + 1) << std::endl;
@@ -169,13 +136,15 @@ int main(int argc, char **argv) {
         for (int i = 0; i < n_thread; i++) {
             std::unique_ptr<VideoDemuxer> demuxer(new VideoDemuxer(input_file_path.c_str()));
             rocDecVideoCodec rocdec_codec_id = AVCodec2RocDecVideoCodec(demuxer->GetCodecID());
-            if (!hip_vis_dev_count) {
-                if (device_id % 2 == 0)
-                    v_device_id[i] = (i % 2 == 0) ? device_id : device_id + sd;
-                else
-                    v_device_id[i] = (i % 2 == 0) ? device_id - sd : device_id;
+            if (device_id < 0) {
+                // let rocDecode place the stream on the device with the most decode headroom
+                v_placement_info[i] = GetDevicePlacementInfo(demuxer.get());
+                if (rocDecAcquireDevice(&v_placement_info[i], &v_device_id[i]) != ROCDEC_SUCCESS) {
+                    std::cerr << "ERROR: no device supports the stream!" << std::endl;
+                    return -1;
+                }
             } else {
-                v_device_id[i] = i % hip_vis_dev_count;
+                v_device_id[i] = device_id;
             }
             std::unique_ptr<RocVideoDecoder> dec(new RocVideoDecoder(v_device_id[i], mem_type, rocdec_codec_id, b_force_zero_latency, p_crop_rect));
             v_demuxer.push_back(std::move(demuxer));
@@ -191,7 +160,7 @@ int main(int argc, char **argv) {
         int n_total = 0;
         OutputSurfaceInfo *p_surf_info;
 
-        std::string device_name;
+        std::string device_name, gcn_arch_name;
         int pci_bus_id, pci_domain_id, pci_device_id;
 
         for (int i = 0; i < n_thread; i++) {
@@ -210,6 +179,9 @@ int main(int argc, char **argv) {
             v_thread[i].join();
             total_fps += v_fps[i];
             n_total += v_frame[i];
+            if (device_id < 0) {
+                rocDecReleaseDevice(&v_placement_info[i], v_device_id[i]);
+            }
         }
 
         std::cout << "info: Total frame decoded: " << n_total  << std::endl;
@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include "video_demuxer.h"
+#include "roc_video_dec.h"
+#include "roc_video_dec_reactor.h"
+#include "common.h"
+
+typedef struct SessionInfo {
+    std::unique_ptr<VideoDemuxer> demuxer;
+    uint32_t session_id = 0;
+    int device_id = 0;
+    RocdecDevicePlacementInfo placement_info = {};
+    bool is_device_acquired = false;
+    OutputSurfaceInfo *surf_info = nullptr;
+    int n_frame = 0;
+    int64_t last_pts = 0;
+    bool is_done = false;
+    uint8_t digest[16] = {};
+} SessionInfo;
+
+/**
+ * @brief demuxes the packets of all the sessions round robin and pushes them to the reactor, waiting for a session that has
+ *        too many packets queued
+ */
+void FeedProc(RocVideoDecoderReactor *reactor, std::vector<SessionInfo> *v_session) {
+    uint8_t *p_video = nullptr;
+    int n_video_bytes = 0;
+    int64_t pts = 0;
+    size_t n_fed = 0;
+    std::vector<bool> v_is_fed(v_session->size(), false);
+    while (n_fed < v_session->size()) {
+        for (size_t i = 0; i < v_session->size(); i++) {
+            if (v_is_fed[i]) {
+                continue;
+            }
+            SessionInfo &session = (*v_session)[i];
+            session.demuxer->Demux(&p_video, &n_video_bytes, &pts);
+            if (!reactor->PushPacket(session.session_id, p_video, n_video_bytes, pts, true)) {
+                return;   // the reactor is stopped
+            }
+            if (!n_video_bytes) {
+                v_is_fed[i] = true;
+                n_fed++;
+            }
+        }
+    }
+}
+
+void ShowHelpAndExit(const char *option = NULL) {
+    std::cout << "Options:" << std::endl
+    << "-i Input File Path - required" << std::endl
+    << "-s Number of decode sessions (>= 1) - optional; default: 8" << std::endl
+    << "-t Number of reactor threads (>= 1) - optional; default: 2" << std::endl
+    << "-d Device ID (>= 0)  - optional; default: each session is placed on the device with the most decode headroom" << std::endl
+    << "-md5 generate MD5 message digest on the decoded YUV image sequence of each session and check that they all match; optional;" << std::endl
+    << "-z force_zero_latency (force_zero_latency, Decoded frames will be flushed out for display immediately); optional;" << std::endl;
+    exit(0);
+}
+
+int main(int argc, char **argv) {
+
+    std::string input_file_path;
+    int device_id = -1;
+    int n_session = 8;
+    int n_thread = 2;
+    Rect *p_crop_rect = nullptr;
+    OutputSurfaceMemoryType mem_type = OUT_SURFACE_MEM_DEV_INTERNAL;      // the reactor delivers the frames as DecodedFrame handles
+    bool b_force_zero_latency = false;
+    bool b_generate_md5 = false;
+    // Parse command-line arguments
+    if(argc <= 1) {
+        ShowHelpAndExit();
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h")) {
+            ShowHelpAndExit();
+        }
+        if (!strcmp(argv[i], "-i")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-i");
+            }
+            input_file_path = argv[i];
+            continue;
+        }
+        if (!strcmp(argv[i], "-s")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-s");
+            }
+            n_session = atoi(argv[i]);
+            if (n_session <= 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-t")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-t");
+            }
+            n_thread = atoi(argv[i]);
+            if (n_thread <= 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-d")) {
+            if (++i == argc) {
+                ShowHelpAndExit("-d");
+            }
+            device_id = atoi(argv[i]);
+            if (device_id < 0) {
+                ShowHelpAndExit(argv[i]);
+            }
+            continue;
+        }
+        if (!strcmp(argv[i], "-md5")) {
+            b_generate_md5 = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "-z")) {
+            b_force_zero_latency = true;
+            continue;
+        }
+        ShowHelpAndExit(argv[i]);
+    }
+
+    std::vector<SessionInfo> v_session(n_session);
+    std::unique_ptr<RocVideoDecoderReactor> reactor(new RocVideoDecoderReactor(n_thread));
+    std::thread feed_thread;
+    int ret = 0;
+    try {
+        std::size_t found_file = input_file_path.find_last_of('/');
+        std::cout << "info: Input file: " << input_file_path.substr(found_file + 1) << std::endl;
+        std::cout << "info: Number of sessions: " << n_session << ", number of reactor threads: " << n_thread << std::endl;
+
+        std::string device_name, gcn_arch_name;
+        int pci_bus_id, pci_domain_id, pci_device_id;
+
+        for (int i = 0; i < n_session; i++) {
+            SessionInfo &session = v_session[i];
+            session.demuxer.reset(new VideoDemuxer(input_file_path.c_str()));
+            rocDecVideoCodec rocdec_codec_id = AVCodec2RocDecVideoCodec(session.demuxer->GetCodecID());
+            if (device_id < 0) {
+                // let rocDecode place the session on the device with the most decode headroom
+                session.placement_info = GetDevicePlacementInfo(session.demuxer.get());
+                if (rocDecAcquireDevice(&session.placement_info, &session.device_id) != ROCDEC_SUCCESS) {
+                    THROW("no device supports the stream!");
+                }
+                session.is_device_acquired = true;
+            } else {
+                session.device_id = device_id;
+            }
+            std::unique_ptr<RocVideoDecoder> dec(new RocVideoDecoder(session.device_id, mem_type, rocdec_codec_id, b_force_zero_latency, p_crop_rect));
+            dec->GetDeviceinfo(device_name, gcn_arch_name, pci_bus_id, pci_domain_id, pci_device_id);
+            if (b_generate_md5) {
+                dec->InitMd5();
+            }
+            session.session_id = reactor->AddSession(std::move(dec));
+            std::cout << "info: session " << i << " using GPU device " << session.device_id << " - " << device_name << "[" << gcn_arch_name << "] on PCI bus " <<
+            std::setfill('0') << std::setw(2) << std::right << std::hex << pci_bus_id << ":" << std::setfill('0') << std::setw(2) <<
+            std::right << std::hex << pci_domain_id << "." << pci_device_id << std::dec << std::endl;
+        }
+
+        std::cout << "info: decoding started, please wait!" << std::endl;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        feed_thread = std::thread(FeedProc, reactor.get(), &v_session);
+
+        // the completions of all the sessions are interleaved, the frames of each session have to come in display order
+        int n_done = 0;
+        ReactorCompletion completion;
+        while (n_done < n_session && reactor->GetCompletion(completion)) {
+            SessionInfo &session = v_session[completion.session_id];
+            if (completion.error) {
+                std::rethrow_exception(completion.error);
+            }
+            if (completion.is_end_of_stream) {
+                session.is_done = true;
+                n_done++;
+                continue;
+            }
+            RocVideoDecoder &viddec = reactor->GetDecoder(completion.session_id);
+            if (session.n_frame && completion.frame.GetPts() < session.last_pts) {
+                std::cerr << "ERROR: session " << completion.session_id << " returned pts " << completion.frame.GetPts() << " after " << session.last_pts << "!" << std::endl;
+                ret = 1;
+            }
+            if (!session.surf_info && !viddec.GetOutputSurfaceInfo(&session.surf_info)) {
+                THROW("Failed to get Output Surface Info!");
+            }
+            if (b_generate_md5) {
+                viddec.UpdateMd5ForFrame(completion.frame.GetData(), session.surf_info);
+            }
+            session.last_pts = completion.frame.GetPts();
+            session.n_frame++;
+            // the frame is released here, which lets the reactor resume its session if it was parked on the output depth
+            completion.frame.Reset();
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double total_dec_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        feed_thread.join();
+
+        int n_total = 0;
+        for (int i = 0; i < n_session; i++) {
+            SessionInfo &session = v_session[i];
+            n_total += session.n_frame;
+            std::cout << "info: session " << i << " decoded " << session.n_frame << " frames";
+            if (b_generate_md5) {
+                uint8_t *digest;
+                reactor->GetDecoder(session.session_id).FinalizeMd5(&digest);
+                memcpy(session.digest, digest, sizeof(session.digest));
+                std::cout << ", MD5 message digest: ";
+                for (int j = 0; j < 16; j++) {
+                    std::cout << std::setfill('0') << std::setw(2) << std::hex << static_cast<int>(session.digest[j]);
+                }
+                std::cout << std::dec;
+            }
+            std::cout << std::endl;
+            // every session decodes the same stream, so they all have to return the same frames in the same order
+            if (!session.is_done || session.n_frame != v_session[0].n_frame ||
+                (b_generate_md5 && memcmp(session.digest, v_session[0].digest, sizeof(session.digest)))) {
+                std::cerr << "ERROR: session " << i << " does not match session 0!" << std::endl;
+                ret = 1;
+            }
+        }
+        std::cout << "info: Total frame decoded: " << n_total << std::endl;
+        if (n_total) {
+            std::cout << "info: avg decoding time per frame: " << total_dec_time / n_total << " ms" << std::endl;
+            std::cout << "info: avg FPS: " << (n_total / total_dec_time) * 1000 << std::endl;
+        }
+    } catch (const std::exception &ex) {
+        std::cout << ex.what() << std::endl;
+        ret = 1;
+    }
+
+    // stopping the reactor wakes the feed thread if it's still waiting to push a packet
+    reactor->Stop();
+    if (feed_thread.joinable()) {
+        feed_thread.join();
+    }
+    reactor.reset();
+    for (auto &session : v_session) {
+        if (session.is_device_acquired) {
+            rocDecReleaseDevice(&session.placement_info, session.device_id);
+        }
+    }
+
+    return ret;
+}
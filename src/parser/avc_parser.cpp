@@ -61,6 +61,7 @@ rocDecStatus AvcVideoParser::ParseVideoData(RocdecSourceDataPacket *p_data) {
     if (p_data->payload && p_data->payload_size) {
         // Clear DPB output/display buffer number
         dpb_buffer_.num_output_pics = 0;
+        SavePacketTimestamp(p_data);
 
         if (ParsePictureData(p_data->payload, p_data->payload_size) != PARSER_OK) {
             ERR(STR("Parser failed!"));
@@ -300,6 +301,12 @@ ParserResult AvcVideoParser::NotifyNewSps(AvcSeqParameterSet *p_sps) {
     video_format_params_.bit_depth_chroma_minus8 = p_sps->bit_depth_chroma_minus8;
     video_format_params_.progressive_sequence = p_sps->frame_mbs_only_flag ? 1 : 0;
     video_format_params_.min_num_decode_surfaces = dpb_buffer_.dpb_size;
+    video_format_ex_.max_dpb_frames = p_sps->max_num_ref_frames + 1;
+    if (p_sps->vui_parameters_present_flag && p_sps->vui_seq_parameters.bitstream_restriction_flag) {
+        video_format_ex_.max_num_reorder_frames = p_sps->vui_seq_parameters.num_reorder_frames;
+    } else {
+        video_format_ex_.max_num_reorder_frames = video_format_ex_.max_dpb_frames;
+    }
     video_format_params_.coded_width = pic_width_;
     video_format_params_.coded_height = pic_height_;
     video_format_params_.chroma_format = static_cast<rocDecVideoChromaFormat>(p_sps->chroma_format_idc);
@@ -438,6 +445,7 @@ ParserResult AvcVideoParser::SendPicForDecode() {
     AvcPicParameterSet *p_pps = &pps_list_[active_pps_id_];
     AvcSliceHeader *p_slice_header = &slice_info_list_[0].slice_header;
     dec_pic_params_ = {0};
+    FillPicTimingParams();
 
     dec_pic_params_.pic_width = pic_width_;
     dec_pic_params_.pic_height = pic_height_;
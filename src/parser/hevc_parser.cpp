@@ -80,6 +80,7 @@ rocDecStatus HevcVideoParser::ParseVideoData(RocdecSourceDataPacket *p_data) {
     if (p_data->payload && p_data->payload_size) {
         // Clear DPB output/display buffer number
         dpb_buffer_.num_output_pics = 0;
+        SavePacketTimestamp(p_data);
 
         if (ParsePictureData(p_data->payload, p_data->payload_size) != PARSER_OK) {
             ERR(STR("Parser failed!"));
@@ -145,6 +146,8 @@ int HevcVideoParser::FillSeqCallbackFn(HevcSeqParamSet* sps_data) {
     else // default value
         video_format_params_.progressive_sequence = 1;
     video_format_params_.min_num_decode_surfaces = dpb_buffer_.dpb_size;
+    video_format_ex_.max_dpb_frames = sps_data->sps_max_dec_pic_buffering_minus1[sps_data->sps_max_sub_layers_minus1] + 1;
+    video_format_ex_.max_num_reorder_frames = sps_data->sps_max_num_reorder_pics[sps_data->sps_max_sub_layers_minus1];
     video_format_params_.coded_width = sps_data->pic_width_in_luma_samples;
     video_format_params_.coded_height = sps_data->pic_height_in_luma_samples;
     video_format_params_.chroma_format = static_cast<rocDecVideoChromaFormat>(sps_data->chroma_format_idc);
@@ -225,12 +228,17 @@ int HevcVideoParser::FillSeqCallbackFn(HevcSeqParamSet* sps_data) {
     video_format_params_.seqhdr_data_length = 0;
 
     // callback function with RocdecVideoFormat params filled out
-    if (pfn_sequece_cb_(parser_params_.user_data, &video_format_params_) == 0) {
+    int num_decode_surfaces = pfn_sequece_cb_(parser_params_.user_data, &video_format_params_);
+    if (num_decode_surfaces == 0) {
         ERR("Sequence callback function failed.");
         return PARSER_FAIL;
-    } else {
-        return PARSER_OK;
     }
+    // The client asks for more surfaces than the parser needs to keep the frames it holds from being decoded into. Since
+    // free buffers are picked by the longest decode history, the extra ones delay the reuse of the frames just output.
+    if (num_decode_surfaces > static_cast<int>(dpb_buffer_.dpb_size)) {
+        dpb_buffer_.dpb_size = num_decode_surfaces > HEVC_MAX_DPB_FRAMES ? HEVC_MAX_DPB_FRAMES : num_decode_surfaces;
+    }
+    return PARSER_OK;
 }
 
 void HevcVideoParser::SendSeiMsgPayload() {
@@ -248,6 +256,7 @@ int HevcVideoParser::SendPicForDecode() {
     HevcSeqParamSet *sps_ptr = &m_sps_[m_active_sps_id_];
     HevcPicParamSet *pps_ptr = &m_pps_[m_active_pps_id_];
     dec_pic_params_ = {0};
+    FillPicTimingParams();
 
     dec_pic_params_.pic_width = sps_ptr->pic_width_in_luma_samples;
     dec_pic_params_.pic_height = sps_ptr->pic_height_in_luma_samples;
@@ -29,6 +29,8 @@ RocVideoParser::RocVideoParser() {
     new_sps_activated_ = false;
     frame_rate_.numerator = 0;
     frame_rate_.denominator = 0;
+    curr_pts_ = 0;
+    is_curr_pts_valid_ = false;
 
     sei_rbsp_buf_ = nullptr;
     sei_rbsp_buf_size_ = 0;
@@ -67,6 +69,19 @@ rocDecStatus RocVideoParser::Initialize(RocdecParserParams *pParams) {
     return ROCDEC_SUCCESS;
 }
 
+void RocVideoParser::SavePacketTimestamp(RocdecSourceDataPacket *p_data) {
+    is_curr_pts_valid_ = (p_data->flags & ROCDEC_PKT_TIMESTAMP) != 0;
+    curr_pts_ = is_curr_pts_valid_ ? p_data->pts : 0;
+}
+
+void RocVideoParser::FillPicTimingParams() {
+    // a packet carries one picture, so the picture takes the time stamp of the packet being parsed
+    dec_pic_params_.pts = curr_pts_;
+    dec_pic_params_.clock_rate = is_curr_pts_valid_ ? (parser_params_.clock_rate ? parser_params_.clock_rate : 10000000) : 0;
+    dec_pic_params_.frame_rate_numerator = frame_rate_.numerator;
+    dec_pic_params_.frame_rate_denominator = frame_rate_.denominator;
+}
+
 ParserResult RocVideoParser::GetNalUnit() {
     bool start_code_found = false;
 
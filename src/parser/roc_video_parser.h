@@ -110,8 +110,11 @@ protected:
     bool new_sps_activated_;
 
     Rational frame_rate_;
+    int64_t curr_pts_;       // time stamp of the packet being parsed
+    bool is_curr_pts_valid_;
 
-    RocdecVideoFormat video_format_params_;
+    RocdecVideoFormatEx video_format_ex_ = {}; // handed to the sequence callback, for the fields appended to RocdecVideoFormatEx
+    RocdecVideoFormat &video_format_params_ = video_format_ex_.format;
     RocdecSeiMessageInfo sei_message_info_params_;
     RocdecPicParams dec_pic_params_;
 
@@ -161,6 +164,17 @@ protected:
      * \return No return value
      */
     void ParseSeiMessage(uint8_t *nalu, size_t size);
+
+    /*! \brief Function to save the time stamp of the packet being parsed
+     * \param [in] p_data A pointer of <tt>RocdecSourceDataPacket</tt> for the packet
+     * \return No return value
+     */
+    void SavePacketTimestamp(RocdecSourceDataPacket *p_data);
+
+    /*! \brief Function to fill the time stamp and the frame rate of the picture sent for decode
+     * \return No return value
+     */
+    void FillPicTimingParams();
 };
 
 // helpers
@@ -23,6 +23,7 @@ THE SOFTWARE.
 
 #include <memory>
 #include <string>
+#include <mutex>
 
 #include "roc_decoder.h"
 
@@ -35,11 +36,14 @@ struct DecHandle {
     explicit DecHandle(RocDecoderCreateInfo& decoder_create_info) : roc_decoder_(std::make_shared<RocDecoder>(decoder_create_info)) {};   //constructor
     ~DecHandle() { ClearErrors(); }
     std::shared_ptr<RocDecoder> roc_decoder_;
-    bool NoError() { return error_.empty(); }
-    const char* ErrorMsg() { return error_.c_str(); }
-    void CaptureError(const std::string& err_msg) { error_ = err_msg; }
+    bool NoError() { std::lock_guard<std::mutex> lock(error_mutex_); return error_.empty(); }
+    // a copy, the message may be replaced by another thread as soon as the lock is released
+    std::string ErrorMsg() { std::lock_guard<std::mutex> lock(error_mutex_); return error_; }
+    // the submitting and the output threads of a handle may fail at the same time
+    void CaptureError(const std::string& err_msg) { std::lock_guard<std::mutex> lock(error_mutex_); error_ = err_msg; }
 
 private:
-    void ClearErrors() { error_ = "";}
+    void ClearErrors() { std::lock_guard<std::mutex> lock(error_mutex_); error_ = "";}
+    std::mutex error_mutex_;
     std::string error_;
 };
\ No newline at end of file
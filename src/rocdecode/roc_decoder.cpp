@@ -22,23 +22,33 @@ THE SOFTWARE.
 
 #include "../commons.h"
 #include "roc_decoder.h"
+#include "roc_decoder_scheduler.h"
+#include "roc_decoder_memory_budget.h"
 
 RocDecoder::RocDecoder(RocDecoderCreateInfo& decoder_create_info): va_video_decoder_{decoder_create_info}, decoder_create_info_{decoder_create_info} {}
 
  RocDecoder::~RocDecoder() {
-    // clean up the VA-API/HIP interop memories
-    for(auto i = 0; i < hip_interop_.size(); i++) {
-        if (hip_interop_[i].hip_mapped_device_mem != nullptr) {
-            hipError_t hip_status = hipFree(hip_interop_[i].hip_mapped_device_mem);
-            if (hip_status != hipSuccess) {
-                ERR("hipFree failed for picture idx = " + TOSTR(i));
-            }
+    // stop the surface sync thread before tearing down the surfaces it may be waiting on
+    if (sync_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(sync_mutex_);
+            stop_sync_thread_ = true;
         }
-        if (hip_interop_[i].hip_ext_mem != nullptr) {
-            hipError_t hip_status = hipDestroyExternalMemory(hip_interop_[i].hip_ext_mem);
-            if (hip_status != hipSuccess) {
-                ERR("hipDestroyExternalMemory failed for picture idx = " + TOSTR(i));
-            }
+        sync_cv_.notify_all();
+        sync_thread_.join();
+    }
+    StopPremapThread();
+    if (is_session_registered_) {
+        RocDecoderScheduler::GetInstance().RemoveSession(decoder_create_info_.device_id, this);
+    }
+    RocDecoderMemoryBudget::GetInstance().Release(decoder_create_info_.device_id, this);
+    // clean up the VA-API/HIP interop memories
+    for (auto i = 0; i < hip_interop_.size(); i++) {
+        FreeInteropMem(i);
+    }
+    for (auto &exported_frame : exported_frames_) {
+        for (uint32_t i = 0; i < exported_frame.second.num_fds; i++) {
+            close(exported_frame.second.fds[i]);
         }
     }
  }
@@ -54,9 +64,15 @@ RocDecoder::RocDecoder(RocDecoderCreateInfo& decoder_create_info): va_video_deco
         ERR("Invalid number of decode surfaces.");
         return ROCDEC_INVALID_PARAMETER;
     }
-    hip_interop_.resize(decoder_create_info_.num_decode_surfaces);
-    for (auto i = 0; i < hip_interop_.size(); i++) {
-        memset((void *)&hip_interop_[i], 0, sizeof(hip_interop_[i]));
+    // check the session against the surface memory budget of the device before any surface is allocated. Dropping the
+    // reconfigure headroom is left to the client, which lays out its frames by the max_width x max_height it asked for.
+    uint32_t surface_width = std::max(decoder_create_info_.width, decoder_create_info_.max_width);
+    uint32_t surface_height = std::max(decoder_create_info_.height, decoder_create_info_.max_height);
+    uint32_t num_pool_surfaces = va_video_decoder_.GetNumPoolSurfaces(decoder_create_info_.num_decode_surfaces);
+    rocdec_status = ReserveSurfaceMemory(surface_width, surface_height, num_pool_surfaces);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("The decode surfaces of the session do not fit into the decode memory budget of the device.");
+        return rocdec_status;
     }
 
     rocdec_status = va_video_decoder_.InitializeDecoder(hip_dev_prop_.name, hip_dev_prop_.gcnArchName);
@@ -64,18 +80,66 @@ RocDecoder::RocDecoder(RocDecoderCreateInfo& decoder_create_info): va_video_deco
         ERR("Failed to initilize the VAAPI Video decoder.");
         return rocdec_status;
     }
+    // the HIP interop memories follow the surfaces, which are fewer than the picture indices with intra_decode_only
+    ResetInteropMem(0);
+    surface_hold_counts_.assign(va_video_decoder_.GetNumSurfaces(), 0);
+    StartPremapThread();
+    RocDecoderScheduler::GetInstance().AddSession(decoder_create_info_.device_id, this);
+    is_session_registered_ = true;
+    rate_window_start_ = std::chrono::steady_clock::now();
 
      return rocdec_status;
  }
 
 rocDecStatus RocDecoder::DecodeFrame(RocdecPicParams *pic_params) {
+    return DecodeFrames(pic_params, 1);
+}
+
+rocDecStatus RocDecoder::DecodeFrames(RocdecPicParams *pic_params, uint32_t num_pictures) {
+    uint32_t num_submitted = 0;
+    // exported and held surfaces are kept out of the decode pool, a picture to be decoded into one is refused
+    auto is_surface_held = [this](int surface_idx) { return IsSurfaceHeld(surface_idx); };
+    auto submit_pictures = [&] {
+        for (; num_submitted < num_pictures; num_submitted++) {
+            rocDecStatus rocdec_status = va_video_decoder_.SubmitDecode(&pic_params[num_submitted], is_surface_held);
+            if (rocdec_status != ROCDEC_SUCCESS) {
+                return rocdec_status;
+            }
+            if (decoder_create_info_.decoder_flags & rocDecDecoderFlags_CompletionQueue) {
+                QueueFrameSync({pic_params[num_submitted].curr_pic_idx, nullptr, nullptr, -1, num_submitted_pictures_});
+            }
+            num_submitted_pictures_++;
+        }
+        return ROCDEC_SUCCESS;
+    };
     rocDecStatus rocdec_status = ROCDEC_SUCCESS;
-    rocdec_status = va_video_decoder_.SubmitDecode(pic_params);
+    if (decoder_create_info_.decoder_flags & rocDecDecoderFlags_DeadlineScheduling) {
+        // a run of pictures is dispatched as a whole, with the earliest deadline of its pictures
+        auto deadline = deadline_tracker_.GetDeadline(pic_params[0]);
+        for (uint32_t i = 1; i < num_pictures; i++) {
+            deadline = std::min(deadline, deadline_tracker_.GetDeadline(pic_params[i]));
+        }
+        rocdec_status = RocDecoderSubmitScheduler::GetInstance(decoder_create_info_.device_id).Submit(decoder_create_info_.priority_class,
+            deadline, submit_pictures);
+    } else {
+        rocdec_status = submit_pictures();
+    }
     if (rocdec_status != ROCDEC_SUCCESS) {
-        ERR("Decode submission is not successful.");
+        ERR("Decode submission is not successful for picture " + TOSTR(num_submitted) + " of the " + TOSTR(num_pictures) + " submitted.");
+    }
+    if (num_submitted > 0) {
+        // the decode rate of the session feeds the device placement of new streams
+        rate_window_pixels_ += static_cast<double>(decoder_create_info_.width) * decoder_create_info_.height * num_submitted;
+        auto now = std::chrono::steady_clock::now();
+        double elapsed_sec = std::chrono::duration<double>(now - rate_window_start_).count();
+        if (elapsed_sec >= 1.0) {
+            RocDecoderScheduler::GetInstance().ReportDecodeRate(decoder_create_info_.device_id, this, rate_window_pixels_ / elapsed_sec);
+            rate_window_pixels_ = 0;
+            rate_window_start_ = now;
+        }
     }
 
-     return rocdec_status;
+    return rocdec_status;
 }
 
 rocDecStatus RocDecoder::GetDecodeStatus(int pic_idx, RocdecDecodeStatus* decode_status) {
@@ -87,15 +151,55 @@ rocDecStatus RocDecoder::GetDecodeStatus(int pic_idx, RocdecDecodeStatus* decode
     return rocdec_status;
 }
 
+rocDecStatus RocDecoder::GetDecodeCompletions(RocdecDecodeCompletion *completions, uint32_t max_completions, uint32_t *num_completions) {
+    if (completions == nullptr || num_completions == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    *num_completions = 0;
+    if (!(decoder_create_info_.decoder_flags & rocDecDecoderFlags_CompletionQueue)) {
+        return ROCDEC_NOT_SUPPORTED;
+    }
+    std::lock_guard<std::mutex> lock(completion_mutex_);
+    while (*num_completions < max_completions && !completion_queue_.empty()) {
+        completions[(*num_completions)++] = completion_queue_.front();
+        completion_queue_.pop_front();
+    }
+    if (*num_completions > 0) {
+        completions[0].num_dropped = num_dropped_completions_;
+        num_dropped_completions_ = 0;
+    }
+    return ROCDEC_SUCCESS;
+}
+
 rocDecStatus RocDecoder::ReconfigureDecoder(RocdecReconfigureDecoderInfo *reconfig_params) {
     if (reconfig_params == nullptr) {
         return ROCDEC_INVALID_PARAMETER;
     }
     rocDecStatus rocdec_status;
-    for (int pic_idx = 0; pic_idx < hip_interop_.size(); pic_idx++) {
-        rocdec_status = ReleaseVideoFrame(pic_idx);
+    uint32_t num_reusable_surfaces = va_video_decoder_.GetNumReusableSurfaces(reconfig_params);
+    uint32_t num_pool_surfaces = va_video_decoder_.GetNumPoolSurfaces(reconfig_params->num_decode_surfaces);
+    if (num_reusable_surfaces < num_pool_surfaces) {
+        // surfaces are added or reallocated: the new size is checked against the budget while the session is intact
+        uint32_t surface_width = va_video_decoder_.GetSurfaceWidth();
+        uint32_t surface_height = va_video_decoder_.GetSurfaceHeight();
+        if (num_reusable_surfaces == 0) {
+            surface_width = std::max({reconfig_params->width, decoder_create_info_.max_width, surface_width});
+            surface_height = std::max({reconfig_params->height, decoder_create_info_.max_height, surface_height});
+        }
+        rocdec_status = ReserveSurfaceMemory(surface_width, surface_height, num_pool_surfaces);
         if (rocdec_status != ROCDEC_SUCCESS) {
-            ERR("Releasing the video frame for picture idx = " + TOSTR(pic_idx) + " failed during reconfiguration.");
+            ERR("The decode surfaces of the reconfigured session do not fit into the decode memory budget of the device.");
+            return rocdec_status;
+        }
+    }
+    WaitForPendingSyncs();
+    StopPremapThread();
+    // keep the mappings of the surfaces that survive the reconfiguration. The post-processing surfaces follow the decode
+    // surfaces and are always recreated.
+    for (int surface_idx = num_reusable_surfaces; surface_idx < hip_interop_.size(); surface_idx++) {
+        rocdec_status = ReleaseVideoFrame(surface_idx);
+        if (rocdec_status != ROCDEC_SUCCESS) {
+            ERR("Releasing the video frame for surface idx = " + TOSTR(surface_idx) + " failed during reconfiguration.");
             return rocdec_status;
         }
     }
@@ -104,11 +208,47 @@ rocDecStatus RocDecoder::ReconfigureDecoder(RocdecReconfigureDecoderInfo *reconf
         ERR("Reconfiguration of the decoder failed.");
         return rocdec_status;
     }
+    decoder_create_info_.width = reconfig_params->width;
+    decoder_create_info_.height = reconfig_params->height;
+    ResetInteropMem(num_reusable_surfaces);
+    DetachExportedFrames(num_reusable_surfaces);
+    StartPremapThread();
+    return rocdec_status;
+}
+
+rocDecStatus RocDecoder::ReserveSurfaceMemory(uint32_t surface_width, uint32_t surface_height, uint32_t num_surfaces) {
+    uint32_t pitch, aligned_height;
+    uint64_t surface_size_in_bytes;
+    rocDecStatus rocdec_status = RocDecoderMemoryBudget::GetSurfaceSize(decoder_create_info_.chroma_format, decoder_create_info_.bit_depth_minus_8,
+        surface_width, surface_height, pitch, aligned_height, surface_size_in_bytes);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    if (!RocDecoderMemoryBudget::GetInstance().Reserve(decoder_create_info_.device_id, this, surface_size_in_bytes * num_surfaces)) {
+        return ROCDEC_OUTOF_MEMORY;
+    }
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoder::ResetDecoder() {
+    // surfaces, their HIP mappings and the decoding context stay in place, only the state of the previous stream is dropped
+    WaitForPendingSyncs();
+    rocDecStatus rocdec_status = va_video_decoder_.ResetDecoder();
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Reset of the VAAPI video decoder failed.");
+        return rocdec_status;
+    }
+    deadline_tracker_.Reset();
+    num_submitted_pictures_ = 0;
+    std::lock_guard<std::mutex> lock(completion_mutex_);
+    completion_queue_.clear();
+    num_dropped_completions_ = 0;
     return rocdec_status;
 }
 
 rocDecStatus RocDecoder::GetVideoFrame(int pic_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3], RocdecProcParams *vid_postproc_params) {
-    if (pic_idx >= hip_interop_.size() || &dev_mem_ptr[0] == nullptr || vid_postproc_params == nullptr) {
+    int surface_idx = va_video_decoder_.GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0 || &dev_mem_ptr[0] == nullptr || vid_postproc_params == nullptr) {
         return ROCDEC_INVALID_PARAMETER;
     }
     rocDecStatus rocdec_status = ROCDEC_SUCCESS;
@@ -119,74 +259,450 @@ rocDecStatus RocDecoder::GetVideoFrame(int pic_idx, void *dev_mem_ptr[3], uint32
         ERR("Failed to export surface for picture idx = " + TOSTR(pic_idx));
         return rocdec_status;
     }
+    if (va_video_decoder_.IsPostProcessing()) {
+        rocdec_status = va_video_decoder_.PostProcess(surface_idx);
+        if (rocdec_status != ROCDEC_SUCCESS) {
+            ERR("Failed to post-process the surface for picture idx = " + TOSTR(pic_idx));
+            return rocdec_status;
+        }
+    }
 
-    // do the VA-API/HIP interop once per surface and save it for reusing
-    if (hip_interop_[pic_idx].hip_mapped_device_mem == nullptr) {
-        hipExternalMemoryHandleDesc external_mem_handle_desc = {};
-        hipExternalMemoryBufferDesc external_mem_buffer_desc = {};
-        VADRMPRIMESurfaceDescriptor va_drm_prime_surface_desc = {};
+    // the mapping returned by this call stays out of the eviction of num_output_surfaces until the next call, so the
+    // one returned by the previous call may be evicted from here on
+    int output_surface_idx = va_video_decoder_.GetOutputSurfaceIdx(surface_idx);
+    returned_surface_idx_.store(output_surface_idx);
+    rocdec_status = MapVideoFrame(output_surface_idx, dev_mem_ptr, horizontal_pitch);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        returned_surface_idx_.store(-1);
+        return rocdec_status;
+    }
+    va_video_decoder_.MarkPictureOutput(pic_idx);
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoder::GetVideoFrameAsync(int pic_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3], RocdecProcParams *vid_postproc_params) {
+    int surface_idx = va_video_decoder_.GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0 || &dev_mem_ptr[0] == nullptr || vid_postproc_params == nullptr || vid_postproc_params->pfn_frame_ready == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    // exporting and mapping the surface does not depend on the decode being complete, so only the wait and the
+    // post-processing are deferred. The surface is kept from the eviction of num_output_surfaces until the callback
+    // has returned, as the mapping is only usable from then on.
+    int output_surface_idx = va_video_decoder_.GetOutputSurfaceIdx(surface_idx);
+    hip_interop_[output_surface_idx]->num_pending_outputs++;
+    rocDecStatus rocdec_status = MapVideoFrame(output_surface_idx, dev_mem_ptr, horizontal_pitch);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        hip_interop_[output_surface_idx]->num_pending_outputs--;
+        return rocdec_status;
+    }
+    QueueFrameSync({pic_idx, vid_postproc_params->pfn_frame_ready, vid_postproc_params->frame_ready_user_data, output_surface_idx});
+    va_video_decoder_.MarkPictureOutput(pic_idx);
+    return ROCDEC_SUCCESS;
+}
 
-        rocdec_status = va_video_decoder_.ExportSurface(pic_idx, va_drm_prime_surface_desc);
+rocDecStatus RocDecoder::ExportVideoFrame(int pic_idx, RocdecExportedFrame *exported_frame) {
+    int surface_idx = va_video_decoder_.GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0 || exported_frame == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    rocDecStatus rocdec_status = va_video_decoder_.SyncSurface(pic_idx);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Failed to sync surface for picture idx = " + TOSTR(pic_idx));
+        return rocdec_status;
+    }
+    // with rocDecDecoderFlags_PostProcess the cropped and scaled picture is exported, as with rocDecGetVideoFrame. The
+    // hold is kept on the decode surface, which covers its post-processed surface as well.
+    if (va_video_decoder_.IsPostProcessing()) {
+        rocdec_status = va_video_decoder_.PostProcess(surface_idx);
         if (rocdec_status != ROCDEC_SUCCESS) {
-            ERR("Failed to export surface for picture idx = " + TOSTR(pic_idx));
+            ERR("Failed to post-process the surface for picture idx = " + TOSTR(pic_idx));
             return rocdec_status;
         }
+    }
+    int output_surface_idx = va_video_decoder_.GetOutputSurfaceIdx(surface_idx);
+    VADRMPRIMESurfaceDescriptor va_drm_prime_surface_desc = {};
+    rocdec_status = va_video_decoder_.ExportSurface(output_surface_idx, va_drm_prime_surface_desc);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Failed to export surface idx = " + TOSTR(output_surface_idx));
+        return rocdec_status;
+    }
 
-        external_mem_handle_desc.type = hipExternalMemoryHandleTypeOpaqueFd;
-        external_mem_handle_desc.handle.fd = va_drm_prime_surface_desc.objects[0].fd;
-        external_mem_handle_desc.size = va_drm_prime_surface_desc.objects[0].size;
+    *exported_frame = {};
+    exported_frame->fourcc = va_drm_prime_surface_desc.fourcc;
+    exported_frame->width = va_drm_prime_surface_desc.width;
+    exported_frame->height = va_drm_prime_surface_desc.height;
+    exported_frame->num_objects = std::min(va_drm_prime_surface_desc.num_objects, 4u);
+    ExportedFrame held_frame = {surface_idx, {-1, -1, -1, -1}, exported_frame->num_objects};
+    for (uint32_t i = 0; i < exported_frame->num_objects; i++) {
+        exported_frame->objects[i].fd = va_drm_prime_surface_desc.objects[i].fd;
+        exported_frame->objects[i].size = va_drm_prime_surface_desc.objects[i].size;
+        exported_frame->objects[i].drm_format_modifier = va_drm_prime_surface_desc.objects[i].drm_format_modifier;
+        held_frame.fds[i] = va_drm_prime_surface_desc.objects[i].fd;
+    }
+    // the surface is exported with separate layers, each holding one plane
+    exported_frame->num_planes = std::min(va_drm_prime_surface_desc.num_layers, 4u);
+    for (uint32_t i = 0; i < exported_frame->num_planes; i++) {
+        exported_frame->planes[i].drm_format = va_drm_prime_surface_desc.layers[i].drm_format;
+        exported_frame->planes[i].object_index = va_drm_prime_surface_desc.layers[i].object_index[0];
+        exported_frame->planes[i].offset = va_drm_prime_surface_desc.layers[i].offset[0];
+        exported_frame->planes[i].pitch = va_drm_prime_surface_desc.layers[i].pitch[0];
+    }
 
-        CHECK_HIP(hipImportExternalMemory(&hip_interop_[pic_idx].hip_ext_mem, &external_mem_handle_desc));
+    std::lock_guard<std::mutex> lock(export_mutex_);
+    exported_frame->frame_id = next_frame_id_++;
+    exported_frames_[exported_frame->frame_id] = held_frame;
+    surface_hold_counts_[surface_idx]++;
+    va_video_decoder_.MarkPictureOutput(pic_idx);
+    return ROCDEC_SUCCESS;
+}
 
-        external_mem_buffer_desc.size = va_drm_prime_surface_desc.objects[0].size;
-        CHECK_HIP(hipExternalMemoryGetMappedBuffer((void**)&hip_interop_[pic_idx].hip_mapped_device_mem, hip_interop_[pic_idx].hip_ext_mem, &external_mem_buffer_desc));
+rocDecStatus RocDecoder::HoldVideoFrame(int pic_idx, uint64_t *frame_id) {
+    int surface_idx = va_video_decoder_.GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0 || frame_id == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    std::lock_guard<std::mutex> lock(export_mutex_);
+    *frame_id = next_frame_id_++;
+    exported_frames_[*frame_id] = {surface_idx, {-1, -1, -1, -1}, 0};
+    surface_hold_counts_[surface_idx]++;
+    return ROCDEC_SUCCESS;
+}
 
-        hip_interop_[pic_idx].width = va_drm_prime_surface_desc.width;
-        hip_interop_[pic_idx].height = va_drm_prime_surface_desc.height;
+rocDecStatus RocDecoder::ReleaseExportedFrame(uint64_t frame_id) {
+    std::unique_lock<std::mutex> lock(export_mutex_);
+    auto it = exported_frames_.find(frame_id);
+    if (it == exported_frames_.end()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    ExportedFrame held_frame = it->second;
+    exported_frames_.erase(it);
+    if (held_frame.surface_idx >= 0) {
+        surface_hold_counts_[held_frame.surface_idx]--;
+    }
+    lock.unlock();
+    for (uint32_t i = 0; i < held_frame.num_fds; i++) {
+        close(held_frame.fds[i]);
+    }
+    return ROCDEC_SUCCESS;
+}
 
-        hip_interop_[pic_idx].offset[0] = va_drm_prime_surface_desc.layers[0].offset[0];
-        hip_interop_[pic_idx].offset[1] = va_drm_prime_surface_desc.layers[1].offset[0];
-        hip_interop_[pic_idx].offset[2] = va_drm_prime_surface_desc.layers[2].offset[0];
+void RocDecoder::DetachExportedFrames(uint32_t first_surface_idx) {
+    // the reallocated surfaces live on in the DMA-BUFs of their exports, but no longer block the new surfaces
+    std::lock_guard<std::mutex> lock(export_mutex_);
+    for (auto &exported_frame : exported_frames_) {
+        if (exported_frame.second.surface_idx >= static_cast<int>(first_surface_idx)) {
+            exported_frame.second.surface_idx = -1;
+        }
+    }
+    surface_hold_counts_.resize(va_video_decoder_.GetNumSurfaces());
+    std::fill(surface_hold_counts_.begin() + std::min<size_t>(first_surface_idx, surface_hold_counts_.size()), surface_hold_counts_.end(), 0);
+}
 
-        hip_interop_[pic_idx].pitch[0] = va_drm_prime_surface_desc.layers[0].pitch[0];
-        hip_interop_[pic_idx].pitch[1] = va_drm_prime_surface_desc.layers[1].pitch[0];
-        hip_interop_[pic_idx].pitch[2] = va_drm_prime_surface_desc.layers[2].pitch[0];
+bool RocDecoder::IsSurfaceHeld(int surface_idx) {
+    // the post-processed surface N + i is only rewritten after decode surface i, so the hold of i covers both
+    uint32_t num_surfaces = va_video_decoder_.GetNumSurfaces();
+    std::lock_guard<std::mutex> lock(export_mutex_);
+    int decode_surface_idx = num_surfaces ? surface_idx % num_surfaces : surface_idx;
+    return decode_surface_idx < surface_hold_counts_.size() && surface_hold_counts_[decode_surface_idx] > 0;
+}
 
-        hip_interop_[pic_idx].num_layers = va_drm_prime_surface_desc.num_layers;
+rocDecStatus RocDecoder::MapVideoFrame(int surface_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3]) {
+    HipInteropDeviceMem &interop = *hip_interop_[surface_idx];
+    while (!ReadMapping(surface_idx, dev_mem_ptr, horizontal_pitch)) {
+        // do the VA-API/HIP interop once per surface and save it for reusing. The thread that claims the surface maps
+        // it, the others wait for the mapping to appear.
+        uint32_t map_state = kSurfaceUnmapped;
+        if (!interop.map_state.compare_exchange_strong(map_state, kSurfaceMapping)) {
+            std::this_thread::yield();
+            continue;
+        }
+        num_mapped_surfaces_++;
+        rocDecStatus rocdec_status = EvictLeastRecentlyUsed(surface_idx);
+        if (rocdec_status == ROCDEC_SUCCESS) {
+            rocdec_status = ImportSurface(surface_idx);
+        }
+        if (rocdec_status != ROCDEC_SUCCESS) {
+            FreeInteropMem(surface_idx);
+            num_mapped_surfaces_--;
+            interop.map_state.store(kSurfaceUnmapped, std::memory_order_release);
+            return rocdec_status;
+        }
+        interop.map_state.store(kSurfaceMapped, std::memory_order_release);
+    }
+    return ROCDEC_SUCCESS;
+}
 
-        for (auto i = 0; i < va_drm_prime_surface_desc.num_objects; ++i) {
-            close(va_drm_prime_surface_desc.objects[i].fd);
+bool RocDecoder::ReadMapping(int surface_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3]) {
+    HipInteropDeviceMem &interop = *hip_interop_[surface_idx];
+    // the read is announced before the state is checked, so a thread unmapping the surface either makes the check fail
+    // or waits for num_readers to drop before it frees the mapping
+    interop.num_readers++;
+    bool is_mapped = interop.map_state.load() == kSurfaceMapped;
+    if (is_mapped) {
+        *&dev_mem_ptr[0] = interop.hip_mapped_device_mem;
+        horizontal_pitch[0] = interop.pitch[0];
+        if (interop.num_layers == 2) {
+            *&dev_mem_ptr[1] = interop.hip_mapped_device_mem + interop.offset[1];
+            horizontal_pitch[1] = interop.pitch[1];
+        } else if (interop.num_layers == 3) {
+            *&dev_mem_ptr[1] = interop.hip_mapped_device_mem + interop.offset[1];
+            horizontal_pitch[1] = interop.pitch[1];
+            *&dev_mem_ptr[2] = interop.hip_mapped_device_mem + interop.offset[2];
+            horizontal_pitch[2] = interop.pitch[2];
         }
+        interop.last_use.store(++map_tick_, std::memory_order_relaxed);
     }
+    interop.num_readers--;
+    return is_mapped;
+}
 
-    *&dev_mem_ptr[0] = hip_interop_[pic_idx].hip_mapped_device_mem;
-    horizontal_pitch[0] = hip_interop_[pic_idx].pitch[0];
-    if (hip_interop_[pic_idx].num_layers == 2) {
-        *&dev_mem_ptr[1] = hip_interop_[pic_idx].hip_mapped_device_mem + hip_interop_[pic_idx].offset[1];
-        horizontal_pitch[1] = hip_interop_[pic_idx].pitch[1];
-    } else if (hip_interop_[pic_idx].num_layers == 3) {
-        *&dev_mem_ptr[2] = hip_interop_[pic_idx].hip_mapped_device_mem + hip_interop_[pic_idx].offset[2];
-        horizontal_pitch[2] = hip_interop_[pic_idx].pitch[2];
+rocDecStatus RocDecoder::ImportSurface(int surface_idx) {
+    HipInteropDeviceMem &interop = *hip_interop_[surface_idx];
+    hipExternalMemoryHandleDesc external_mem_handle_desc = {};
+    hipExternalMemoryBufferDesc external_mem_buffer_desc = {};
+    VADRMPRIMESurfaceDescriptor va_drm_prime_surface_desc = {};
+
+    rocDecStatus rocdec_status = va_video_decoder_.ExportSurface(surface_idx, va_drm_prime_surface_desc);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Failed to export surface idx = " + TOSTR(surface_idx));
+        return rocdec_status;
     }
 
-    return rocdec_status;
+    external_mem_handle_desc.type = hipExternalMemoryHandleTypeOpaqueFd;
+    external_mem_handle_desc.handle.fd = va_drm_prime_surface_desc.objects[0].fd;
+    external_mem_handle_desc.size = va_drm_prime_surface_desc.objects[0].size;
+
+    CHECK_HIP(hipImportExternalMemory(&interop.hip_ext_mem, &external_mem_handle_desc));
+
+    external_mem_buffer_desc.size = va_drm_prime_surface_desc.objects[0].size;
+    CHECK_HIP(hipExternalMemoryGetMappedBuffer((void**)&interop.hip_mapped_device_mem, interop.hip_ext_mem, &external_mem_buffer_desc));
+
+    interop.width = va_drm_prime_surface_desc.width;
+    interop.height = va_drm_prime_surface_desc.height;
+
+    interop.offset[0] = va_drm_prime_surface_desc.layers[0].offset[0];
+    interop.offset[1] = va_drm_prime_surface_desc.layers[1].offset[0];
+    interop.offset[2] = va_drm_prime_surface_desc.layers[2].offset[0];
+
+    interop.pitch[0] = va_drm_prime_surface_desc.layers[0].pitch[0];
+    interop.pitch[1] = va_drm_prime_surface_desc.layers[1].pitch[0];
+    interop.pitch[2] = va_drm_prime_surface_desc.layers[2].pitch[0];
+
+    interop.num_layers = va_drm_prime_surface_desc.num_layers;
+
+    for (auto i = 0; i < va_drm_prime_surface_desc.num_objects; ++i) {
+        close(va_drm_prime_surface_desc.objects[i].fd);
+    }
+    return ROCDEC_SUCCESS;
 }
 
-rocDecStatus RocDecoder::ReleaseVideoFrame(int pic_idx) {
-    if (pic_idx >= hip_interop_.size()) {
-        return ROCDEC_INVALID_PARAMETER;
+rocDecStatus RocDecoder::EvictLeastRecentlyUsed(int surface_idx) {
+    // with num_output_surfaces set, the least recently used mappings make room for the new one. The surfaces held with
+    // rocDecHoldVideoFrame or rocDecExportVideoFrame, those still waiting for their frame ready callback and the one
+    // returned by the latest rocDecGetVideoFrame are skipped (see RocDecoderCreateInfo::num_output_surfaces).
+    if (!decoder_create_info_.num_output_surfaces) {
+        return ROCDEC_SUCCESS;
+    }
+    std::lock_guard<std::mutex> lock(evict_mutex_);
+    while (num_mapped_surfaces_ > decoder_create_info_.num_output_surfaces) {
+        int victim_idx = -1;
+        uint64_t oldest_use = UINT64_MAX;
+        for (int i = 0; i < hip_interop_.size(); i++) {
+            if (i != surface_idx && hip_interop_[i]->map_state.load() == kSurfaceMapped && hip_interop_[i]->last_use.load(std::memory_order_relaxed) < oldest_use &&
+                hip_interop_[i]->num_pending_outputs.load() == 0 && !IsSurfaceHeld(i) && i != returned_surface_idx_.load()) {
+                victim_idx = i;
+                oldest_use = hip_interop_[i]->last_use.load(std::memory_order_relaxed);
+            }
+        }
+        if (victim_idx < 0) {
+            // the other surfaces are still being mapped, held or waiting for their callback: the limit is exceeded
+            // until a later eviction pass finds them released
+            break;
+        }
+        uint32_t map_state = kSurfaceMapped;
+        if (hip_interop_[victim_idx]->map_state.compare_exchange_strong(map_state, kSurfaceUnmapping)) {
+            if (victim_idx == returned_surface_idx_.load()) {
+                // returned by a rocDecGetVideoFrame call since the victim was chosen, which either sees this check
+                // fail or its lookup of the mapping retried until the mapping is back
+                hip_interop_[victim_idx]->map_state.store(kSurfaceMapped, std::memory_order_release);
+                continue;
+            }
+            rocDecStatus rocdec_status = UnmapSurface(victim_idx);
+            if (rocdec_status != ROCDEC_SUCCESS) {
+                return rocdec_status;
+            }
+        }
+    }
+    return ROCDEC_SUCCESS;
+}
+
+void RocDecoder::ResetInteropMem(uint32_t first_surface_idx) {
+    // only called while no output thread is using the session
+    hip_interop_.resize(va_video_decoder_.GetNumExportableSurfaces());
+    for (auto i = first_surface_idx; i < hip_interop_.size(); i++) {
+        hip_interop_[i] = std::make_unique<HipInteropDeviceMem>();
+    }
+    if (returned_surface_idx_.load() >= static_cast<int>(first_surface_idx)) {
+        returned_surface_idx_.store(-1);
     }
+}
 
-    if (hip_interop_[pic_idx].hip_mapped_device_mem != nullptr)
-        CHECK_HIP(hipFree(hip_interop_[pic_idx].hip_mapped_device_mem));
-    if (hip_interop_[pic_idx].hip_ext_mem != nullptr)
-        CHECK_HIP(hipDestroyExternalMemory(hip_interop_[pic_idx].hip_ext_mem));
+void RocDecoder::StartPremapThread() {
+    if (decoder_create_info_.decoder_flags & rocDecDecoderFlags_PremapSurfaces) {
+        stop_premap_thread_ = false;
+        premap_thread_ = std::thread(&RocDecoder::PremapThreadFunc, this);
+    }
+}
 
-    memset((void *)&hip_interop_[pic_idx], 0, sizeof(hip_interop_[pic_idx]));
+void RocDecoder::StopPremapThread() {
+    if (premap_thread_.joinable()) {
+        stop_premap_thread_ = true;
+        premap_thread_.join();
+    }
+}
 
-    return ROCDEC_SUCCESS;
+void RocDecoder::PremapThreadFunc() {
+    // the surfaces do not need to hold decoded content to be exported, so all of them can be mapped up front and
+    // the first GetVideoFrame() call of each surface only has to look up the saved mapping
+    if (hipSetDevice(decoder_create_info_.device_id) != hipSuccess) {
+        ERR("Failed to set the HIP device for premapping the surfaces.");
+        return;
+    }
+    size_t num_premapped_surfaces = va_video_decoder_.GetNumSurfaces();
+    if (decoder_create_info_.num_output_surfaces) {
+        num_premapped_surfaces = std::min(num_premapped_surfaces, static_cast<size_t>(decoder_create_info_.num_output_surfaces));
+    }
+    for (int surface_idx = 0; surface_idx < num_premapped_surfaces && !stop_premap_thread_; surface_idx++) {
+        void *dev_mem_ptr[3] = {};
+        uint32_t horizontal_pitch[3] = {};
+        if (MapVideoFrame(va_video_decoder_.GetOutputSurfaceIdx(surface_idx), dev_mem_ptr, horizontal_pitch) != ROCDEC_SUCCESS) {
+            ERR("Failed to premap surface idx = " + TOSTR(surface_idx));
+            break;
+        }
+    }
+}
+
+void RocDecoder::QueueFrameSync(const PendingFrameSync &pending_sync) {
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        if (!sync_thread_.joinable()) {
+            sync_thread_ = std::thread(&RocDecoder::SyncThreadFunc, this);
+        }
+        pending_syncs_.push_back(pending_sync);
+    }
+    sync_cv_.notify_one();
+}
+
+void RocDecoder::SyncThreadFunc() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (true) {
+        sync_cv_.wait(lock, [this] { return stop_sync_thread_ || !pending_syncs_.empty(); });
+        if (stop_sync_thread_) {
+            // the decoder is being destroyed: fail the frames still waiting so that no caller waits on their callback forever
+            std::deque<PendingFrameSync> dropped_syncs;
+            dropped_syncs.swap(pending_syncs_);
+            lock.unlock();
+            for (auto &dropped_sync : dropped_syncs) {
+                if (dropped_sync.pfn_frame_ready != nullptr) {
+                    dropped_sync.pfn_frame_ready(dropped_sync.user_data, dropped_sync.pic_idx, ROCDEC_NOT_INITIALIZED);
+                    hip_interop_[dropped_sync.output_surface_idx]->num_pending_outputs--;
+                }
+            }
+            lock.lock();
+            sync_done_cv_.notify_all();
+            break;
+        }
+        PendingFrameSync pending_sync = pending_syncs_.front();
+        pending_syncs_.pop_front();
+        sync_in_progress_ = true;
+        lock.unlock();
+
+        if (pending_sync.pfn_frame_ready != nullptr) {
+            rocDecStatus rocdec_status = va_video_decoder_.SyncSurface(pending_sync.pic_idx);
+            if (rocdec_status != ROCDEC_SUCCESS) {
+                ERR("Failed to sync surface for picture idx = " + TOSTR(pending_sync.pic_idx));
+            } else if (va_video_decoder_.IsPostProcessing()) {
+                rocdec_status = va_video_decoder_.PostProcess(va_video_decoder_.GetSurfaceIdx(pending_sync.pic_idx));
+                if (rocdec_status != ROCDEC_SUCCESS) {
+                    ERR("Failed to post-process the surface for picture idx = " + TOSTR(pending_sync.pic_idx));
+                }
+            }
+            pending_sync.pfn_frame_ready(pending_sync.user_data, pending_sync.pic_idx, rocdec_status);
+            hip_interop_[pending_sync.output_surface_idx]->num_pending_outputs--;
+        } else {
+            RocdecDecodeCompletion completion = {};
+            completion.pic_idx = pending_sync.pic_idx;
+            completion.decode_order = pending_sync.decode_order;
+            if (va_video_decoder_.WaitForDecode(pending_sync.pic_idx, completion.decode_status) != ROCDEC_SUCCESS) {
+                completion.decode_status = rocDecodeStatus_Invalid;
+            }
+            std::lock_guard<std::mutex> completion_lock(completion_mutex_);
+            if (completion_queue_.size() >= kMaxDecodeCompletions) {
+                completion_queue_.pop_front();
+                num_dropped_completions_++;
+            }
+            completion_queue_.push_back(completion);
+        }
+
+        lock.lock();
+        sync_in_progress_ = false;
+        if (pending_syncs_.empty()) {
+            sync_done_cv_.notify_all();
+        }
+    }
+}
+
+void RocDecoder::WaitForPendingSyncs() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    sync_done_cv_.wait(lock, [this] { return pending_syncs_.empty() && !sync_in_progress_; });
 }
 
+rocDecStatus RocDecoder::ReleaseVideoFrame(int surface_idx) {
+    if (surface_idx >= hip_interop_.size()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    uint32_t map_state = kSurfaceMapped;
+    while (!hip_interop_[surface_idx]->map_state.compare_exchange_weak(map_state, kSurfaceUnmapping)) {
+        if (map_state == kSurfaceUnmapped) {
+            return ROCDEC_SUCCESS;
+        }
+        // mapped or unmapped by another thread right now
+        map_state = kSurfaceMapped;
+        std::this_thread::yield();
+    }
+    int returned_surface_idx = surface_idx;
+    returned_surface_idx_.compare_exchange_strong(returned_surface_idx, -1);
+    return UnmapSurface(surface_idx);
+}
+
+rocDecStatus RocDecoder::UnmapSurface(int surface_idx) {
+    // the caller has moved the surface to kSurfaceUnmapping, the lookups that started before still read the mapping
+    HipInteropDeviceMem &interop = *hip_interop_[surface_idx];
+    while (interop.num_readers.load() > 0) {
+        std::this_thread::yield();
+    }
+    rocDecStatus rocdec_status = FreeInteropMem(surface_idx);
+    num_mapped_surfaces_--;
+    interop.map_state.store(kSurfaceUnmapped, std::memory_order_release);
+    return rocdec_status;
+}
+
+rocDecStatus RocDecoder::FreeInteropMem(int surface_idx) {
+    HipInteropDeviceMem &interop = *hip_interop_[surface_idx];
+    rocDecStatus rocdec_status = ROCDEC_SUCCESS;
+    if (interop.hip_mapped_device_mem != nullptr && hipFree(interop.hip_mapped_device_mem) != hipSuccess) {
+        ERR("hipFree failed for surface idx = " + TOSTR(surface_idx));
+        rocdec_status = ROCDEC_RUNTIME_ERROR;
+    }
+    if (interop.hip_ext_mem != nullptr && hipDestroyExternalMemory(interop.hip_ext_mem) != hipSuccess) {
+        ERR("hipDestroyExternalMemory failed for surface idx = " + TOSTR(surface_idx));
+        rocdec_status = ROCDEC_RUNTIME_ERROR;
+    }
+    interop.hip_mapped_device_mem = nullptr;
+    interop.hip_ext_mem = nullptr;
+    interop.num_layers = 0;
+    return rocdec_status;
+}
 
 rocDecStatus RocDecoder::InitHIP(int device_id) {
     CHECK_HIP(hipGetDeviceCount(&num_devices_));
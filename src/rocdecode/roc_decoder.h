@@ -30,9 +30,19 @@ THE SOFTWARE.
 #include <sstream>
 #include <string.h>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <memory>
 #include "../api/rocdecode.h"
 #include <hip/hip_runtime.h>
 #include "vaapi/vaapi_videodecoder.h"
+#include "roc_decoder_submit_scheduler.h"
 
 #define CHECK_HIP(call) {\
     hipError_t hip_status = call;\
@@ -42,14 +52,44 @@ THE SOFTWARE.
     }\
 }
 
+// Mapping state of a surface. Only the thread that moves a surface out of kSurfaceUnmapped or kSurfaceMapped owns it
+// until it stores the next stable state, so the fields of HipInteropDeviceMem are written by one thread at a time.
+enum SurfaceMapState : uint32_t {
+    kSurfaceUnmapped = 0,
+    kSurfaceMapping = 1, // being imported into HIP
+    kSurfaceMapped = 2,
+    kSurfaceUnmapping = 3, // being released, waits for the readers of the mapping to leave
+};
+
 struct HipInteropDeviceMem {
-    hipExternalMemory_t hip_ext_mem; // Interface to the vaapi-hip interop
-    uint8_t* hip_mapped_device_mem; // Mapped device memory for the YUV plane
-    uint32_t width; // Width of the surface in pixels.
-    uint32_t height; // Height of the surface in pixels.
-    uint32_t offset[3]; // Offset of each plane
-    uint32_t pitch[3]; // Pitch of each plane
-    uint32_t num_layers; // Number of layers making up the surface
+    hipExternalMemory_t hip_ext_mem = nullptr; // Interface to the vaapi-hip interop
+    uint8_t* hip_mapped_device_mem = nullptr; // Mapped device memory for the YUV plane
+    uint32_t width = 0; // Width of the surface in pixels.
+    uint32_t height = 0; // Height of the surface in pixels.
+    uint32_t offset[3] = {}; // Offset of each plane
+    uint32_t pitch[3] = {}; // Pitch of each plane
+    uint32_t num_layers = 0; // Number of layers making up the surface
+    std::atomic<uint32_t> map_state = kSurfaceUnmapped; // SurfaceMapState of the surface
+    std::atomic<uint32_t> num_readers = 0; // threads copying the mapping out of the fields above
+    std::atomic<uint64_t> last_use = 0; // map tick of the latest lookup, orders the evictions of num_output_surfaces
+    std::atomic<uint32_t> num_pending_outputs = 0; // frames of rocDecGetVideoFrameAsync whose callback has not returned yet
+};
+
+// entries kept by the completion queue of rocDecDecoderFlags_CompletionQueue when the application doesn't drain it
+static constexpr size_t kMaxDecodeCompletions = 1024;
+
+struct PendingFrameSync {
+    int pic_idx; // Picture index of the surface to wait on
+    PFNVIDFRAMEREADYCALLBACK pfn_frame_ready; // Callback to signal the readiness of the surface, nullptr for completion queue entries
+    void *user_data; // User data passed to the callback
+    int output_surface_idx = -1; // surface mapped for the callback, kept from the eviction until the callback returns
+    uint32_t decode_order = 0; // submission number of the picture, reported with its completion queue entry
+};
+
+struct ExportedFrame {
+    int surface_idx; // surface held out of the decode pool, -1 once the surface has been reallocated by a reconfigure
+    int fds[4]; // DMA-BUF file descriptors handed out with the frame
+    uint32_t num_fds; // 0 for the frames held by rocDecHoldVideoFrame
 };
 
 class RocDecoder {
@@ -58,16 +98,73 @@ public:
     ~RocDecoder();
     rocDecStatus InitializeDecoder();
     rocDecStatus DecodeFrame(RocdecPicParams *pic_params);
+    rocDecStatus DecodeFrames(RocdecPicParams *pic_params, uint32_t num_pictures);
     rocDecStatus GetDecodeStatus(int pic_idx, RocdecDecodeStatus* decode_status);
+    rocDecStatus GetDecodeCompletions(RocdecDecodeCompletion *completions, uint32_t max_completions, uint32_t *num_completions);
     rocDecStatus ReconfigureDecoder(RocdecReconfigureDecoderInfo *reconfig_params);
+    rocDecStatus ResetDecoder();
     rocDecStatus GetVideoFrame(int pic_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3], RocdecProcParams *vid_postproc_params);
+    rocDecStatus GetVideoFrameAsync(int pic_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3], RocdecProcParams *vid_postproc_params);
+    rocDecStatus ExportVideoFrame(int pic_idx, RocdecExportedFrame *exported_frame);
+    rocDecStatus HoldVideoFrame(int pic_idx, uint64_t *frame_id);
+    rocDecStatus ReleaseExportedFrame(uint64_t frame_id);
 
 private:
     rocDecStatus InitHIP(int device_id);
-    rocDecStatus ReleaseVideoFrame(int pic_idx);
+    rocDecStatus MapVideoFrame(int surface_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3]);
+    rocDecStatus ReleaseVideoFrame(int surface_idx);
+    rocDecStatus UnmapSurface(int surface_idx);
+    bool ReadMapping(int surface_idx, void *dev_mem_ptr[3], uint32_t horizontal_pitch[3]);
+    rocDecStatus ImportSurface(int surface_idx);
+    rocDecStatus FreeInteropMem(int surface_idx);
+    rocDecStatus EvictLeastRecentlyUsed(int surface_idx);
+    void ResetInteropMem(uint32_t first_surface_idx);
+    void StartPremapThread();
+    void StopPremapThread();
+    void PremapThreadFunc();
+    void QueueFrameSync(const PendingFrameSync &pending_sync);
+    void SyncThreadFunc();
+    void WaitForPendingSyncs();
+    void DetachExportedFrames(uint32_t first_surface_idx);
+    bool IsSurfaceHeld(int surface_idx);
+    rocDecStatus ReserveSurfaceMemory(uint32_t surface_width, uint32_t surface_height, uint32_t num_surfaces);
     int num_devices_;
     RocDecoderCreateInfo decoder_create_info_;
     VaapiVideoDecoder va_video_decoder_;
     hipDeviceProp_t hip_dev_prop_;
-    std::vector<HipInteropDeviceMem> hip_interop_;
+    // indexed by the surface index of VaapiVideoDecoder. The vector itself only changes while no output thread uses
+    // the session, the mappings are looked up without locking through the per-surface map_state.
+    std::vector<std::unique_ptr<HipInteropDeviceMem>> hip_interop_;
+    std::atomic<uint64_t> map_tick_ = 0;
+    std::atomic<uint32_t> num_mapped_surfaces_ = 0; // surfaces in kSurfaceMapping or kSurfaceMapped
+    std::mutex evict_mutex_; // serializes the choice of eviction victims with num_output_surfaces
+    std::atomic<int> returned_surface_idx_ = -1; // mapping of the latest rocDecGetVideoFrame, not evicted until the next call
+    // with rocDecDecoderFlags_PremapSurfaces, premap_thread_ maps all surfaces right after they are created
+    std::thread premap_thread_;
+    std::atomic<bool> stop_premap_thread_ = false;
+    // surfaces handed out by GetVideoFrameAsync() and, with rocDecDecoderFlags_CompletionQueue, every submitted
+    // picture are waited on by sync_thread_, which is started on first use
+    std::thread sync_thread_;
+    std::mutex sync_mutex_;
+    std::condition_variable sync_cv_;
+    std::condition_variable sync_done_cv_;
+    std::deque<PendingFrameSync> pending_syncs_;
+    bool sync_in_progress_ = false;
+    bool stop_sync_thread_ = false;
+    std::mutex completion_mutex_;
+    std::deque<RocdecDecodeCompletion> completion_queue_; // at most kMaxDecodeCompletions entries
+    uint32_t num_dropped_completions_ = 0; // oldest entries dropped from the full completion queue since the last drain
+    uint32_t num_submitted_pictures_ = 0; // pictures submitted since the creation or the last reset, by the submitting thread
+    // live session state reported to RocDecoderScheduler
+    bool is_session_registered_ = false;
+    std::chrono::steady_clock::time_point rate_window_start_;
+    double rate_window_pixels_ = 0;
+    // frames exported with rocDecExportVideoFrame or held with rocDecHoldVideoFrame, their surfaces are not decoded into
+    // nor unmapped by the eviction of num_output_surfaces until they are released
+    std::mutex export_mutex_;
+    std::unordered_map<uint64_t, ExportedFrame> exported_frames_;
+    std::vector<uint32_t> surface_hold_counts_; // outstanding exports of each surface
+    uint64_t next_frame_id_ = 1;
+    // submission deadlines of the pictures with rocDecDecoderFlags_DeadlineScheduling
+    PictureDeadlineTracker deadline_tracker_;
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include "roc_decoder_memory_budget.h"
+
+static inline uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// The surface layout follows the allocation of the VA-API driver: rows are aligned to 256 bytes and the luma height to 16.
+rocDecStatus RocDecoderMemoryBudget::GetSurfaceSize(rocDecVideoChromaFormat chroma_format, uint32_t bit_depth_minus_8, uint32_t width,
+    uint32_t height, uint32_t &pitch, uint32_t &aligned_height, uint64_t &size_in_bytes) {
+    uint32_t bytes_per_sample = bit_depth_minus_8 > 0 ? 2 : 1;
+    uint64_t num_planes_x2; // luma plane plus chroma planes, in halves of the luma plane size
+    switch (chroma_format) {
+        case rocDecVideoChromaFormat_Monochrome:
+            num_planes_x2 = 2;
+            break;
+        case rocDecVideoChromaFormat_420:
+            num_planes_x2 = 3;
+            break;
+        case rocDecVideoChromaFormat_422:
+            num_planes_x2 = 4;
+            break;
+        case rocDecVideoChromaFormat_444:
+            num_planes_x2 = 6;
+            break;
+        default:
+            return ROCDEC_NOT_SUPPORTED;
+    }
+    if (bit_depth_minus_8 > 8) {
+        return ROCDEC_NOT_SUPPORTED;
+    }
+    pitch = AlignUp(width * bytes_per_sample, 256);
+    aligned_height = AlignUp(height, 16);
+    size_in_bytes = static_cast<uint64_t>(pitch) * aligned_height * num_planes_x2 / 2;
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoderMemoryBudget::GetMemoryInfo(RocdecDecoderMemoryInfo &memory_info) {
+    if (memory_info.width == 0 || memory_info.height == 0 || memory_info.max_dpb_frames == 0) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    rocDecStatus rocdec_status = GetSurfaceSize(memory_info.chroma_format, memory_info.bit_depth_minus_8, memory_info.width, memory_info.height,
+        memory_info.surface_pitch, memory_info.surface_height, memory_info.surface_size_in_bytes);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    // the reference and reorder frames of the DPB, the picture being decoded, the picture being output and the frames
+    // the client holds on to
+    uint32_t num_dpb_frames = std::max(memory_info.max_dpb_frames, memory_info.max_num_reorder_frames + 1);
+    memory_info.num_decode_surfaces = num_dpb_frames + 2 + memory_info.output_queue_depth;
+    memory_info.total_size_in_bytes = memory_info.surface_size_in_bytes * memory_info.num_decode_surfaces;
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoderMemoryBudget::SetBudget(int device_id, uint64_t budget_in_bytes) {
+    if (device_id < 0) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_[device_id].budget_in_bytes = budget_in_bytes;
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoderMemoryBudget::GetBudget(int device_id, uint64_t &budget_in_bytes, uint64_t &used_in_bytes) {
+    if (device_id < 0) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device_id);
+    budget_in_bytes = it != devices_.end() ? it->second.budget_in_bytes : 0;
+    used_in_bytes = it != devices_.end() ? it->second.used_in_bytes : 0;
+    return ROCDEC_SUCCESS;
+}
+
+bool RocDecoderMemoryBudget::Reserve(int device_id, const void *session, uint64_t size_in_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DeviceBudget &device_budget = devices_[device_id];
+    uint64_t prev_size_in_bytes = device_budget.session_sizes.count(session) ? device_budget.session_sizes[session] : 0;
+    uint64_t used_in_bytes = device_budget.used_in_bytes - prev_size_in_bytes + size_in_bytes;
+    if (device_budget.budget_in_bytes && used_in_bytes > device_budget.budget_in_bytes && size_in_bytes > prev_size_in_bytes) {
+        return false;
+    }
+    device_budget.used_in_bytes = used_in_bytes;
+    device_budget.session_sizes[session] = size_in_bytes;
+    return true;
+}
+
+void RocDecoderMemoryBudget::Release(int device_id, const void *session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device_id);
+    if (it == devices_.end()) {
+        return;
+    }
+    auto session_it = it->second.session_sizes.find(session);
+    if (session_it != it->second.session_sizes.end()) {
+        it->second.used_in_bytes -= session_it->second;
+        it->second.session_sizes.erase(session_it);
+    }
+}
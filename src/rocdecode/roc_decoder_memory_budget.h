@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include "../commons.h"
+#include "../../api/rocdecode.h"
+
+// The RocDecoderMemoryBudget singleton class keeps the decode surfaces of the sessions on each device within a
+// process-wide budget
+class RocDecoderMemoryBudget {
+public:
+    static RocDecoderMemoryBudget& GetInstance() {
+        static RocDecoderMemoryBudget instance;
+        return instance;
+    }
+    static rocDecStatus GetMemoryInfo(RocdecDecoderMemoryInfo &memory_info);
+    static rocDecStatus GetSurfaceSize(rocDecVideoChromaFormat chroma_format, uint32_t bit_depth_minus_8, uint32_t width, uint32_t height,
+        uint32_t &pitch, uint32_t &aligned_height, uint64_t &size_in_bytes);
+    rocDecStatus SetBudget(int device_id, uint64_t budget_in_bytes);
+    rocDecStatus GetBudget(int device_id, uint64_t &budget_in_bytes, uint64_t &used_in_bytes);
+    // replaces the reservation of the session; returns false and keeps the previous one if the new size doesn't fit
+    bool Reserve(int device_id, const void *session, uint64_t size_in_bytes);
+    void Release(int device_id, const void *session);
+
+private:
+    struct DeviceBudget {
+        uint64_t budget_in_bytes = 0; // 0: no limit
+        uint64_t used_in_bytes = 0;
+        std::unordered_map<const void*, uint64_t> session_sizes;
+    };
+    RocDecoderMemoryBudget() {}
+    std::unordered_map<int, DeviceBudget> devices_;
+    std::mutex mutex_;
+    RocDecoderMemoryBudget(const RocDecoderMemoryBudget&) = delete;
+    RocDecoderMemoryBudget& operator = (const RocDecoderMemoryBudget) = delete;
+};
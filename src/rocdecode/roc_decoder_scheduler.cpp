@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <hip/hip_runtime.h>
+#include "roc_decoder_scheduler.h"
+#include "roc_decoder_caps.h"
+
+// Nominal decode rate of a single VCN instance in pixels per second, per codec. Neither HIP nor VA-API report the decode
+// throughput of a device, so the table holds conservative real-time targets rather than queried figures: 4K at 60 fps for
+// HEVC and AV1, and half of it for AVC. They are only used until a higher aggregate rate is measured on the device with
+// ReportDecodeRate().
+static const std::unordered_map<rocDecVideoCodec, double> kVcnNominalPixelRates = {
+    {rocDecVideoCodec_AVC, 3840.0 * 2160.0 * 30.0},
+    {rocDecVideoCodec_HEVC, 3840.0 * 2160.0 * 60.0},
+    {rocDecVideoCodec_AV1, 3840.0 * 2160.0 * 60.0},
+};
+// nominal rate of the codecs missing from kVcnNominalPixelRates
+static const double kVcnDefaultNominalPixelRate = 3840.0 * 2160.0 * 60.0;
+
+static double GetNominalPixelRate(rocDecVideoCodec codec_type) {
+    auto it = kVcnNominalPixelRates.find(codec_type);
+    return it != kVcnNominalPixelRates.end() ? it->second : kVcnDefaultNominalPixelRate;
+}
+
+int HipDeviceModel::GetNumDevices() {
+    int num_devices = 0;
+    hipError_t hip_status = hipGetDeviceCount(&num_devices);
+    if (hip_status != hipSuccess) {
+        ERR("ERROR: hipGetDeviceCount failed!" + TOSTR(hip_status));
+        return 0;
+    }
+    return num_devices;
+}
+
+std::string HipDeviceModel::GetGcnArchName(int device_id) {
+    hipDeviceProp_t hip_dev_prop;
+    hipError_t hip_status = hipGetDeviceProperties(&hip_dev_prop, device_id);
+    if (hip_status != hipSuccess) {
+        ERR("ERROR: hipGetDeviceProperties for device (" + TOSTR(device_id) + " ) failed! (" + TOSTR(hip_status) + ")");
+        return "";
+    }
+    return hip_dev_prop.gcnArchName;
+}
+
+void RocDecoderScheduler::InitDevices() {
+    if (devices_initialized_) {
+        return;
+    }
+    devices_.resize(device_model_->GetNumDevices());
+    for (size_t i = 0; i < devices_.size(); i++) {
+        devices_[i].gcn_arch_name = device_model_->GetGcnArchName(i);
+    }
+    devices_initialized_ = true;
+}
+
+double RocDecoderScheduler::GetPixelRate(const RocdecDevicePlacementInfo &placement_info) {
+    double frame_rate = 30.0;
+    if (placement_info.frame_rate_numerator && placement_info.frame_rate_denominator) {
+        frame_rate = static_cast<double>(placement_info.frame_rate_numerator) / placement_info.frame_rate_denominator;
+    }
+    return static_cast<double>(placement_info.width) * placement_info.height * frame_rate;
+}
+
+double RocDecoderScheduler::GetHeadroom(const DeviceLoad &device_load, const RocdecDecodeCaps &decode_caps, double pixel_rate) {
+    double capacity = std::max(decode_caps.num_decoders * GetNominalPixelRate(decode_caps.codec_type), device_load.peak_pixel_rate);
+    double measured_pixel_rate = 0;
+    for (auto &session : device_load.session_pixel_rates) {
+        measured_pixel_rate += session.second;
+    }
+    // sessions that were not placed through the scheduler and haven't been measured yet are assumed to be like the new stream
+    uint32_t num_unplaced_sessions = device_load.sessions.size() > device_load.num_placements ? static_cast<uint32_t>(device_load.sessions.size()) - device_load.num_placements : 0;
+    double load = std::max(device_load.placed_pixel_rate + num_unplaced_sessions * pixel_rate, measured_pixel_rate);
+    return capacity - load - pixel_rate;
+}
+
+rocDecStatus RocDecoderScheduler::AcquireDevice(const RocdecDevicePlacementInfo &placement_info, int &device_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InitDevices();
+    double pixel_rate = GetPixelRate(placement_info);
+    int best_device_id = -1;
+    double best_headroom = 0, best_sessions_per_decoder = 0;
+    for (size_t i = 0; i < devices_.size(); i++) {
+        RocdecDecodeCaps decode_caps = {};
+        decode_caps.codec_type = placement_info.codec_type;
+        decode_caps.chroma_format = placement_info.chroma_format;
+        decode_caps.bit_depth_minus_8 = placement_info.bit_depth_minus_8;
+        if (RocDecVcnCodecSpec::GetInstance().GetDecoderCaps(devices_[i].gcn_arch_name, &decode_caps) != ROCDEC_SUCCESS || !decode_caps.is_supported ||
+            !decode_caps.num_decoders || placement_info.width > decode_caps.max_width || placement_info.height > decode_caps.max_height) {
+            continue;
+        }
+        double headroom = GetHeadroom(devices_[i], decode_caps, pixel_rate);
+        double sessions_per_decoder = static_cast<double>(std::max(static_cast<uint32_t>(devices_[i].sessions.size()), devices_[i].num_placements) + 1) / decode_caps.num_decoders;
+        // most headroom first, then the fewest sessions sharing a VCN instance, then the lowest device id
+        if (best_device_id < 0 || headroom > best_headroom || (headroom == best_headroom && sessions_per_decoder < best_sessions_per_decoder)) {
+            best_device_id = static_cast<int>(i);
+            best_headroom = headroom;
+            best_sessions_per_decoder = sessions_per_decoder;
+        }
+    }
+    if (best_device_id < 0) {
+        ERR("No device supports the codec config of the stream.");
+        return ROCDEC_NOT_SUPPORTED;
+    }
+    devices_[best_device_id].num_placements++;
+    devices_[best_device_id].placed_pixel_rate += pixel_rate;
+    device_id = best_device_id;
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus RocDecoderScheduler::ReleaseDevice(const RocdecDevicePlacementInfo &placement_info, int device_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (device_id < 0 || static_cast<size_t>(device_id) >= devices_.size() || !devices_[device_id].num_placements) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    DeviceLoad &device_load = devices_[device_id];
+    device_load.num_placements--;
+    device_load.placed_pixel_rate = device_load.num_placements ? std::max(device_load.placed_pixel_rate - GetPixelRate(placement_info), 0.0) : 0;
+    return ROCDEC_SUCCESS;
+}
+
+void RocDecoderScheduler::AddSession(int device_id, const void *session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InitDevices();
+    if (device_id >= 0 && static_cast<size_t>(device_id) < devices_.size()) {
+        devices_[device_id].sessions.insert(session);
+    }
+}
+
+void RocDecoderScheduler::RemoveSession(int device_id, const void *session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (device_id >= 0 && static_cast<size_t>(device_id) < devices_.size() && devices_[device_id].sessions.erase(session)) {
+        devices_[device_id].session_pixel_rates.erase(session);
+    }
+}
+
+void RocDecoderScheduler::ReportDecodeRate(int device_id, const void *session, double pixel_rate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a rate reported for a session that is not live would be kept forever
+    if (device_id < 0 || static_cast<size_t>(device_id) >= devices_.size() || !devices_[device_id].sessions.count(session)) {
+        return;
+    }
+    DeviceLoad &device_load = devices_[device_id];
+    device_load.session_pixel_rates[session] = pixel_rate;
+    double measured_pixel_rate = 0;
+    for (auto &session_rate : device_load.session_pixel_rates) {
+        measured_pixel_rate += session_rate.second;
+    }
+    device_load.peak_pixel_rate = std::max(device_load.peak_pixel_rate, measured_pixel_rate);
+}
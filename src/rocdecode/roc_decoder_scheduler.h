@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../commons.h"
+#include "../../api/rocdecode.h"
+
+// The RocDecDeviceModel interface describes the devices the scheduler places streams on. HipDeviceModel is used by the
+// library; other models make the placement logic usable without GPUs.
+class RocDecDeviceModel {
+public:
+    virtual ~RocDecDeviceModel() = default;
+    virtual int GetNumDevices() = 0;
+    virtual std::string GetGcnArchName(int device_id) = 0;
+};
+
+class HipDeviceModel : public RocDecDeviceModel {
+public:
+    int GetNumDevices() override;
+    std::string GetGcnArchName(int device_id) override;
+};
+
+// The DeviceLoad struct contains the live state of a device as seen by the scheduler
+struct DeviceLoad {
+    std::string gcn_arch_name;
+    std::unordered_set<const void*> sessions; // live decoder sessions
+    uint32_t num_placements = 0; // streams booked by AcquireDevice and not released yet
+    double placed_pixel_rate = 0; // sum of the pixel rates of the booked streams
+    double peak_pixel_rate = 0; // highest aggregate decode rate measured on the device
+    std::unordered_map<const void*, double> session_pixel_rates; // latest measured decode rate of each live session
+};
+
+// The RocDecoderScheduler singleton class places new streams on the device with the most decode headroom
+class RocDecoderScheduler {
+public:
+    static RocDecoderScheduler& GetInstance() {
+        static RocDecoderScheduler instance(std::make_unique<HipDeviceModel>());
+        return instance;
+    }
+    explicit RocDecoderScheduler(std::unique_ptr<RocDecDeviceModel> device_model) : device_model_{std::move(device_model)} {}
+    rocDecStatus AcquireDevice(const RocdecDevicePlacementInfo &placement_info, int &device_id);
+    rocDecStatus ReleaseDevice(const RocdecDevicePlacementInfo &placement_info, int device_id);
+    void AddSession(int device_id, const void *session);
+    void RemoveSession(int device_id, const void *session);
+    void ReportDecodeRate(int device_id, const void *session, double pixel_rate);
+    static double GetPixelRate(const RocdecDevicePlacementInfo &placement_info);
+
+private:
+    void InitDevices();
+    double GetHeadroom(const DeviceLoad &device_load, const RocdecDecodeCaps &decode_caps, double pixel_rate);
+    std::unique_ptr<RocDecDeviceModel> device_model_;
+    std::vector<DeviceLoad> devices_;
+    bool devices_initialized_ = false;
+    std::mutex mutex_;
+    RocDecoderScheduler(const RocDecoderScheduler&) = delete;
+    RocDecoderScheduler& operator = (const RocDecoderScheduler) = delete;
+};
@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include "roc_decoder_submit_scheduler.h"
+
+std::chrono::steady_clock::time_point PictureDeadlineTracker::GetDeadline(const RocdecPicParams &pic_params) {
+    double frame_duration = 1.0 / 30.0;
+    if (pic_params.frame_rate_numerator && pic_params.frame_rate_denominator) {
+        frame_duration = static_cast<double>(pic_params.frame_rate_denominator) / pic_params.frame_rate_numerator;
+    }
+    if (num_pictures_ == 0) {
+        start_time_ = std::chrono::steady_clock::now();
+        first_pts_ = pic_params.pts;
+    }
+    double presentation_time;
+    if (pic_params.clock_rate) {
+        presentation_time = static_cast<double>(pic_params.pts - first_pts_) / pic_params.clock_rate;
+    } else {
+        presentation_time = num_pictures_ * frame_duration;
+    }
+    num_pictures_++;
+    return start_time_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(presentation_time + frame_duration));
+}
+
+RocDecoderSubmitScheduler& RocDecoderSubmitScheduler::GetInstance(int device_id) {
+    static std::mutex instances_mutex;
+    static std::map<int, std::unique_ptr<RocDecoderSubmitScheduler>> instances;
+    std::lock_guard<std::mutex> lock(instances_mutex);
+    auto &instance = instances[device_id];
+    if (!instance) {
+        instance = std::make_unique<RocDecoderSubmitScheduler>();
+    }
+    return *instance;
+}
+
+bool RocDecoderSubmitScheduler::Precedes(const PendingSubmission &a, const PendingSubmission &b) {
+    if (a.priority_class != b.priority_class) {
+        return a.priority_class == rocDecPriorityClass_Realtime;
+    }
+    if (a.deadline != b.deadline) {
+        return a.deadline < b.deadline;
+    }
+    return a.seq_num < b.seq_num;
+}
+
+const RocDecoderSubmitScheduler::PendingSubmission* RocDecoderSubmitScheduler::GetNextSubmission() {
+    const PendingSubmission *next_submission = nullptr;
+    for (auto submission : pending_submissions_) {
+        if (next_submission == nullptr || Precedes(*submission, *next_submission)) {
+            next_submission = submission;
+        }
+    }
+    return next_submission;
+}
+
+rocDecStatus RocDecoderSubmitScheduler::Submit(rocDecPriorityClass priority_class, std::chrono::steady_clock::time_point deadline,
+    const std::function<rocDecStatus()> &submit_fn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    PendingSubmission submission = {priority_class, deadline, next_seq_num_++};
+    pending_submissions_.push_back(&submission);
+    dispatch_cv_.wait(lock, [&] { return !is_dispatching_ && GetNextSubmission() == &submission; });
+    pending_submissions_.erase(std::find(pending_submissions_.begin(), pending_submissions_.end(), &submission));
+    is_dispatching_ = true;
+    num_dispatched_[priority_class]++;
+    if (std::chrono::steady_clock::now() > deadline) {
+        num_missed_deadlines_[priority_class]++;
+    }
+    lock.unlock();
+
+    rocDecStatus rocdec_status;
+    try {
+        rocdec_status = submit_fn();
+    } catch (...) {
+        lock.lock();
+        is_dispatching_ = false;
+        lock.unlock();
+        dispatch_cv_.notify_all();
+        throw;
+    }
+
+    lock.lock();
+    is_dispatching_ = false;
+    lock.unlock();
+    dispatch_cv_.notify_all();
+    return rocdec_status;
+}
+
+uint64_t RocDecoderSubmitScheduler::GetNumDispatched(rocDecPriorityClass priority_class) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_dispatched_[priority_class];
+}
+
+uint64_t RocDecoderSubmitScheduler::GetNumMissedDeadlines(rocDecPriorityClass priority_class) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_missed_deadlines_[priority_class];
+}
+
+size_t RocDecoderSubmitScheduler::GetNumPending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_submissions_.size();
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../commons.h"
+#include "../../api/rocdecode.h"
+
+// The PictureDeadlineTracker class derives the submission deadline of the pictures of a session. The timeline starts
+// with the first picture: a picture is due one frame duration after its presentation time, taken from its time stamp
+// when it has one and from the frame rate (30 fps if unknown) otherwise.
+class PictureDeadlineTracker {
+public:
+    std::chrono::steady_clock::time_point GetDeadline(const RocdecPicParams &pic_params);
+    void Reset() { num_pictures_ = 0; }
+
+private:
+    std::chrono::steady_clock::time_point start_time_;
+    int64_t first_pts_ = 0;
+    uint64_t num_pictures_ = 0;
+};
+
+// The RocDecoderSubmitScheduler class orders the picture submissions of the sessions on a device that opted in with
+// rocDecDecoderFlags_DeadlineScheduling. One submission is dispatched at a time, earliest deadline first within a
+// priority class. Batch submissions are held back while a realtime submission waits, which stalls the submitting
+// thread of batch sessions instead of queueing their pictures ahead of the realtime ones. The submissions are
+// callables, so the scheduler can be driven by a simulated backend as well as by VaapiVideoDecoder.
+class RocDecoderSubmitScheduler {
+public:
+    static RocDecoderSubmitScheduler& GetInstance(int device_id);
+    RocDecoderSubmitScheduler() = default;
+    // blocks until the submission is dispatched and returns the status of submit_fn
+    rocDecStatus Submit(rocDecPriorityClass priority_class, std::chrono::steady_clock::time_point deadline, const std::function<rocDecStatus()> &submit_fn);
+    uint64_t GetNumDispatched(rocDecPriorityClass priority_class);
+    uint64_t GetNumMissedDeadlines(rocDecPriorityClass priority_class);
+    size_t GetNumPending(); // submissions waiting to be dispatched
+
+private:
+    struct PendingSubmission {
+        rocDecPriorityClass priority_class;
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t seq_num; // arrival order, breaks deadline ties
+    };
+    static bool Precedes(const PendingSubmission &a, const PendingSubmission &b);
+    const PendingSubmission* GetNextSubmission();
+    std::vector<const PendingSubmission*> pending_submissions_;
+    bool is_dispatching_ = false;
+    uint64_t next_seq_num_ = 0;
+    std::map<rocDecPriorityClass, uint64_t> num_dispatched_;
+    std::map<rocDecPriorityClass, uint64_t> num_missed_deadlines_;
+    std::mutex mutex_;
+    std::condition_variable dispatch_cv_;
+    RocDecoderSubmitScheduler(const RocDecoderSubmitScheduler&) = delete;
+    RocDecoderSubmitScheduler& operator = (const RocDecoderSubmitScheduler &) = delete;
+};
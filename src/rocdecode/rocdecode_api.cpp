@@ -22,6 +22,8 @@ THE SOFTWARE.
 #include "dec_handle.h"
 #include "rocdecode.h"
 #include "roc_decoder_caps.h"
+#include "roc_decoder_scheduler.h"
+#include "roc_decoder_memory_budget.h"
 #include "../commons.h"
 
 
@@ -98,6 +100,63 @@ rocDecGetDecoderCaps(RocdecDecodeCaps *pdc) {
     return vcn_codec_spec.GetDecoderCaps(hip_dev_prop.gcnArchName, pdc);
 }
 
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecAcquireDevice(RocdecDevicePlacementInfo *placement_info, int *device_id)
+//! Picks the device with the most decode headroom for a new stream and books the stream's load on it
+/**********************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecAcquireDevice(RocdecDevicePlacementInfo *placement_info, int *device_id) {
+    if (placement_info == nullptr || device_id == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    return RocDecoderScheduler::GetInstance().AcquireDevice(*placement_info, *device_id);
+}
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecReleaseDevice(RocdecDevicePlacementInfo *placement_info, int device_id)
+//! Returns the load booked by rocDecAcquireDevice() for a stream
+/**********************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecReleaseDevice(RocdecDevicePlacementInfo *placement_info, int device_id) {
+    if (placement_info == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    return RocDecoderScheduler::GetInstance().ReleaseDevice(*placement_info, device_id);
+}
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecoderMemoryInfo(RocdecDecoderMemoryInfo *memory_info)
+//! Reports the number of decode surfaces and the surface memory a session needs before it is created
+/**********************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecGetDecoderMemoryInfo(RocdecDecoderMemoryInfo *memory_info) {
+    if (memory_info == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    return RocDecoderMemoryBudget::GetMemoryInfo(*memory_info);
+}
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecSetDecoderMemoryBudget(int device_id, uint64_t budget_in_bytes)
+//! Sets the process-wide budget for the decode surfaces of all sessions on a device
+/**********************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecSetDecoderMemoryBudget(int device_id, uint64_t budget_in_bytes) {
+    return RocDecoderMemoryBudget::GetInstance().SetBudget(device_id, budget_in_bytes);
+}
+
+/**********************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecoderMemoryBudget(int device_id, uint64_t *budget_in_bytes, uint64_t *used_in_bytes)
+//! Returns the decode surface memory budget of a device and the surface memory reserved by its live sessions
+/**********************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecGetDecoderMemoryBudget(int device_id, uint64_t *budget_in_bytes, uint64_t *used_in_bytes) {
+    if (budget_in_bytes == nullptr || used_in_bytes == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    return RocDecoderMemoryBudget::GetInstance().GetBudget(device_id, *budget_in_bytes, *used_in_bytes);
+}
+
 /*****************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecDecodeFrame(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params)
 //! Decodes a single picture
@@ -121,6 +180,29 @@ rocDecDecodeFrame(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_param
     return ret;
 }
 
+/*****************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecDecodeFrames(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params, uint32_t num_pictures)
+//! Decodes a run of pictures
+//! Submits the pictures for HW decoding back to back in a single call
+/*****************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecDecodeFrames(rocDecDecoderHandle decoder_handle, RocdecPicParams *pic_params, uint32_t num_pictures) {
+    if (decoder_handle == nullptr || pic_params == nullptr || num_pictures == 0) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->DecodeFrames(pic_params, num_pictures);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
 /************************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI RocdecGetDecodeStatus(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecDecodeStatus* decode_status);
 //! Get the decode status for frame corresponding to pic_idx
@@ -145,6 +227,29 @@ rocDecGetDecodeStatus(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecDec
     return ret;
 }
 
+/************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetDecodeCompletions(rocDecDecoderHandle decoder_handle, RocdecDecodeCompletion *completions,
+//!                                                       uint32_t max_completions, uint32_t *num_completions);
+//! Drain up to max_completions finished pictures from the completion queue of the decoder without blocking
+/************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecGetDecodeCompletions(rocDecDecoderHandle decoder_handle, RocdecDecodeCompletion *completions, uint32_t max_completions, uint32_t *num_completions) {
+    if (decoder_handle == nullptr || completions == nullptr || num_completions == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->GetDecodeCompletions(completions, max_completions, num_completions);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
 /*********************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecReconfigureDecoder(rocDecDecoderHandle decoder_handle, RocdecReconfigureDecoderInfo *reconfig_params)
 //! Used to reuse single decoder for multiple clips. Currently supports resolution change, resize params
@@ -168,6 +273,28 @@ rocDecReconfigureDecoder(rocDecDecoderHandle decoder_handle, RocdecReconfigureDe
     return ret;
 }
 
+/*********************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecResetDecoder(rocDecDecoderHandle decoder_handle)
+//! Waits for the outstanding decodes and drops the per-stream state so the session can decode a new stream
+/*********************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecResetDecoder(rocDecDecoderHandle decoder_handle) {
+    if (decoder_handle == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->ResetDecoder();
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
 /************************************************************************************************************************/
 //! \fn rocDecStatus ROCDECAPI rocDecGetVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, unsigned int *dev_mem_ptr,
 //!         unsigned int *horizontal_pitch, RocdecProcParams *vid_postproc_params);
@@ -193,6 +320,98 @@ rocDecGetVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx,
     return ret;
 }
 
+/************************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecGetVideoFrameAsync(rocDecDecoderHandle decoder_handle, int pic_idx, void *dev_mem_ptr[3],
+//!         uint32_t (&horizontal_pitch)[3], RocdecProcParams *vid_postproc_params);
+//! Map video frame corresponding to pic_idx for use in HIP without waiting for the decode to complete. The readiness of
+//! the frame is signalled through vid_postproc_params->pfn_frame_ready
+/************************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecGetVideoFrameAsync(rocDecDecoderHandle decoder_handle, int pic_idx,
+                    void *dev_mem_ptr[3], uint32_t (&horizontal_pitch)[3], RocdecProcParams *vid_postproc_params) {
+    if (decoder_handle == nullptr || dev_mem_ptr == nullptr || horizontal_pitch == nullptr || vid_postproc_params == nullptr ||
+        vid_postproc_params->pfn_frame_ready == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->GetVideoFrameAsync(pic_idx, dev_mem_ptr, horizontal_pitch, vid_postproc_params);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
+/************************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecExportVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecExportedFrame *exported_frame);
+//! Export the surface corresponding to pic_idx as DMA-BUF file descriptors, held until rocDecReleaseVideoFrame()
+/************************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecExportVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, RocdecExportedFrame *exported_frame) {
+    if (decoder_handle == nullptr || exported_frame == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->ExportVideoFrame(pic_idx, exported_frame);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
+/************************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecHoldVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, uint64_t *frame_id);
+//! Keep the surface corresponding to pic_idx out of the decode pool until rocDecReleaseVideoFrame()
+/************************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecHoldVideoFrame(rocDecDecoderHandle decoder_handle, int pic_idx, uint64_t *frame_id) {
+    if (decoder_handle == nullptr || frame_id == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->HoldVideoFrame(pic_idx, frame_id);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
+/************************************************************************************************************************/
+//! \fn rocDecStatus ROCDECAPI rocDecReleaseVideoFrame(rocDecDecoderHandle decoder_handle, uint64_t frame_id);
+//! Close the file descriptors of an exported or held frame and return its surface to the decode pool
+/************************************************************************************************************************/
+rocDecStatus ROCDECAPI
+rocDecReleaseVideoFrame(rocDecDecoderHandle decoder_handle, uint64_t frame_id) {
+    if (decoder_handle == nullptr) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    auto handle = static_cast<DecHandle *>(decoder_handle);
+    rocDecStatus ret;
+    try {
+        ret = handle->roc_decoder_->ReleaseExportedFrame(frame_id);
+    }
+    catch(const std::exception& e) {
+        handle->CaptureError(e.what());
+        ERR(e.what())
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ret;
+}
+
 /*****************************************************************************************************/
 //! \fn const char* ROCDECAPI rocDecGetErrorName(rocDecStatus rocdec_status)
 //! \ingroup group_amd_rocdecode
@@ -216,6 +435,8 @@ const char* ROCDECAPI rocDecGetErrorName(rocDecStatus rocdec_status) {
             return "ROCDEC_NOT_INITIALIZED";
         case ROCDEC_NOT_SUPPORTED:
             return "ROCDEC_NOT_SUPPORTED";
+        case ROCDEC_SURFACE_BUSY:
+            return "ROCDEC_SURFACE_BUSY";
         default:
             return "UNKNOWN_ERROR";
     }
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#if __cplusplus >= 201703L && __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+#include "drm_device_topology.h"
+
+DrmDeviceTopology::DrmDeviceTopology(const std::string &sysfs_root, const char *visible_devices_env) : sysfs_root_{sysfs_root},
+    compute_partitions_read_{false} {
+    ParseVisibleDevices(visible_devices_env);
+}
+
+std::string DrmDeviceTopology::GetRenderNode(int device_id, const std::string &device_name, const std::string &gcn_arch_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = render_nodes_.find(device_id);
+    if (it != render_nodes_.end()) {
+        return it->second;
+    }
+
+    std::size_t pos = gcn_arch_name.find_first_of(":");
+    std::string gcn_arch_name_base = (pos != std::string::npos) ? gcn_arch_name.substr(0, pos) : gcn_arch_name;
+    int offset = 0;
+    if (gcn_arch_name_base.compare("gfx940") == 0 ||
+        gcn_arch_name_base.compare("gfx941") == 0 ||
+        gcn_arch_name_base.compare("gfx942") == 0) {
+        offset = GetDrmNodeOffset(device_name, device_id);
+    }
+
+    std::string drm_node = "/dev/dri/renderD";
+    if (static_cast<size_t>(device_id) < visible_devices_.size()) {
+        drm_node += std::to_string(128 + offset + visible_devices_[device_id]);
+    } else {
+        drm_node += std::to_string(128 + offset + device_id);
+    }
+    render_nodes_[device_id] = drm_node;
+    return drm_node;
+}
+
+std::vector<ComputePartition> DrmDeviceTopology::GetComputePartitions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReadComputePartitions();
+    return compute_partitions_;
+}
+
+std::map<int, std::string> DrmDeviceTopology::GetResolvedRenderNodes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return render_nodes_;
+}
+
+void DrmDeviceTopology::ParseVisibleDevices(const char *visible_devices_env) {
+    if (visible_devices_env != nullptr) {
+        // tokenize a copy, the environment string itself must not be modified
+        std::stringstream visible_devices(visible_devices_env);
+        std::string token;
+        while (std::getline(visible_devices, token, ',')) {
+            if (!token.empty()) {
+                visible_devices_.push_back(std::atoi(token.c_str()));
+            }
+        }
+        std::sort(visible_devices_.begin(), visible_devices_.end());
+    }
+}
+
+void DrmDeviceTopology::ReadComputePartitions() {
+    if (compute_partitions_read_) {
+        return;
+    }
+    compute_partitions_read_ = true;
+    // the partition mode is an attribute of the GPU device, which each render node links to. Only the render nodes are
+    // visited instead of walking all of /sys/devices.
+    std::vector<fs::path> render_node_paths;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(sysfs_root_ + "/class/drm", ec)) {
+        if (entry.path().filename().string().compare(0, 7, "renderD") == 0) {
+            render_node_paths.push_back(entry.path());
+        }
+    }
+    std::sort(render_node_paths.begin(), render_node_paths.end());
+    for (const auto& render_node_path : render_node_paths) {
+        std::ifstream file(render_node_path / "device" / "current_compute_partition");
+        if (file.is_open()) {
+            std::string partition;
+            std::getline(file, partition);
+            if (partition.compare("SPX") == 0 || partition.compare("spx") == 0) {
+                compute_partitions_.push_back(kSpx);
+            } else if (partition.compare("DPX") == 0 || partition.compare("dpx") == 0) {
+                compute_partitions_.push_back(kDpx);
+            } else if (partition.compare("TPX") == 0 || partition.compare("tpx") == 0) {
+                compute_partitions_.push_back(kTpx);
+            } else if (partition.compare("QPX") == 0 || partition.compare("qpx") == 0) {
+                compute_partitions_.push_back(kQpx);
+            } else if (partition.compare("CPX") == 0 || partition.compare("cpx") == 0) {
+                compute_partitions_.push_back(kCpx);
+            }
+            file.close();
+        }
+    }
+}
+
+int DrmDeviceTopology::GetDrmNodeOffset(const std::string &device_name, int device_id) {
+    ReadComputePartitions();
+    // if no compute partition is reported, the default SPX mode is assumed
+    ComputePartition compute_partition = compute_partitions_.empty() ? kSpx : compute_partitions_[0];
+    int device_index = (static_cast<size_t>(device_id) < visible_devices_.size()) ? visible_devices_[device_id] : device_id;
+    int offset = 0;
+    switch (compute_partition) {
+        case kSpx:
+            offset = device_index * 7;
+            break;
+        case kDpx:
+            offset = (device_index / 2) * 6;
+            break;
+        case kTpx:
+            // Please note that although there are only 6 XCCs per socket on MI300A,
+            // there are two dummy render nodes added by the driver.
+            // This needs to be taken into account when creating drm_node on each socket in TPX mode.
+            offset = (device_index / 3) * 5;
+            break;
+        case kQpx:
+            offset = (device_index / 4) * 4;
+            break;
+        case kCpx:
+            // Please note that both MI300A and MI300X have the same gfx_arch_name which is
+            // gfx942. Therefore we cannot use the gfx942 to identify MI300A.
+            // instead use the device name and look for MI300A
+            // Also, as explained aboe in the TPX mode section, we need to be taken into account
+            // the extra two dummy nodes when creating drm_node on each socket in CPX mode as well.
+            if (device_name.find("MI300A") != std::string::npos) {
+                offset = (device_index / 6) * 2;
+            }
+            break;
+    }
+    return offset;
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include "../../commons.h"
+
+typedef enum {
+    kSpx = 0, // Single Partition Accelerator
+    kDpx = 1, // Dual Partition Accelerator
+    kTpx = 2, // Triple Partition Accelerator
+    kQpx = 3, // Quad Partition Accelerator
+    kCpx = 4, // Core Partition Accelerator
+} ComputePartition;
+
+// The DrmDeviceTopology class resolves the DRM render node used by the VCN decoder of a HIP device. HIP_VISIBLE_DEVICES and
+// the compute partition modes are read once, and resolved render nodes are cached, so only the first decoder created on a
+// device pays for the discovery. GetInstance() returns the process-wide topology of the live system; other instances can be
+// created against a different sysfs root and HIP_VISIBLE_DEVICES value (e.g., a fake sysfs tree).
+class DrmDeviceTopology {
+public:
+    static DrmDeviceTopology& GetInstance() {
+        static DrmDeviceTopology instance("/sys", std::getenv("HIP_VISIBLE_DEVICES"));
+        return instance;
+    }
+    DrmDeviceTopology(const std::string &sysfs_root, const char *visible_devices_env);
+    std::string GetRenderNode(int device_id, const std::string &device_name, const std::string &gcn_arch_name);
+    std::vector<int> GetVisibleDevices() { return visible_devices_; }
+    std::vector<ComputePartition> GetComputePartitions();
+    std::map<int, std::string> GetResolvedRenderNodes();
+private:
+    std::string sysfs_root_;
+    std::vector<int> visible_devices_;
+    std::vector<ComputePartition> compute_partitions_;
+    bool compute_partitions_read_;
+    std::map<int, std::string> render_nodes_; // device id -> render node path
+    std::mutex mutex_;
+    void ParseVisibleDevices(const char *visible_devices_env);
+    void ReadComputePartitions();
+    int GetDrmNodeOffset(const std::string &device_name, int device_id);
+};
@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "vaapi_videodecoder.h"
+
+rocDecStatus VaDisplayCache::AcquireDisplay(const std::string &drm_node, VADisplay &va_display) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = displays_.find(drm_node);
+    if (it != displays_.end()) {
+        it->second.ref_count++;
+        va_display = it->second.va_display;
+        return ROCDEC_SUCCESS;
+    }
+
+    VaDisplayEntry entry = {};
+    entry.drm_fd = open(drm_node.c_str(), O_RDWR);
+    if (entry.drm_fd < 0) {
+        ERR("Failed to open drm node." + drm_node);
+        return ROCDEC_NOT_INITIALIZED;
+    }
+    entry.va_display = vaGetDisplayDRM(entry.drm_fd);
+    if (!entry.va_display) {
+        ERR("Failed to create va_display.");
+        close(entry.drm_fd);
+        return ROCDEC_NOT_INITIALIZED;
+    }
+    vaSetInfoCallback(entry.va_display, NULL, NULL);
+    int major_version = 0, minor_version = 0;
+    VAStatus va_status = vaInitialize(entry.va_display, &major_version, &minor_version);
+    if (va_status != VA_STATUS_SUCCESS) {
+        ERR("vaInitialize failed with status: " + TOSTR(va_status) + " = '" + STR(vaErrorStr(va_status)) + "' for drm node " + drm_node);
+        vaTerminate(entry.va_display);
+        close(entry.drm_fd);
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    entry.slice_param_arrays = IsSliceParamArrayDriver(entry.va_display);
+    entry.ref_count = 1;
+    va_display = entry.va_display;
+    displays_.emplace(drm_node, entry);
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaDisplayCache::GetDecoderConfig(VADisplay va_display, VAProfile va_profile, VAConfigID &va_config_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &display : displays_) {
+        VaDisplayEntry &entry = display.second;
+        if (entry.va_display != va_display) {
+            continue;
+        }
+        auto it = entry.va_configs.find(va_profile);
+        if (it != entry.va_configs.end()) {
+            va_config_id = it->second;
+            return ROCDEC_SUCCESS;
+        }
+        VAConfigAttrib va_config_attrib = {};
+        va_config_attrib.type = VAConfigAttribRTFormat;
+        CHECK_VAAPI(vaGetConfigAttributes(va_display, va_profile, VAEntrypointVLD, &va_config_attrib, 1));
+        CHECK_VAAPI(vaCreateConfig(va_display, va_profile, VAEntrypointVLD, &va_config_attrib, 1, &va_config_id));
+        entry.va_configs[va_profile] = va_config_id;
+        return ROCDEC_SUCCESS;
+    }
+    ERR("The VA display has not been acquired from the display cache.");
+    return ROCDEC_INVALID_PARAMETER;
+}
+
+rocDecStatus VaDisplayCache::GetVideoProcConfig(VADisplay va_display, VAConfigID &va_config_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &display : displays_) {
+        VaDisplayEntry &entry = display.second;
+        if (entry.va_display != va_display) {
+            continue;
+        }
+        auto it = entry.va_configs.find(VAProfileNone);
+        if (it != entry.va_configs.end()) {
+            va_config_id = it->second;
+            return ROCDEC_SUCCESS;
+        }
+        std::vector<VAEntrypoint> va_entrypoints(vaMaxNumEntrypoints(va_display));
+        int num_entrypoints = 0;
+        VAStatus va_status = vaQueryConfigEntrypoints(va_display, VAProfileNone, va_entrypoints.data(), &num_entrypoints);
+        if (va_status != VA_STATUS_SUCCESS || std::find(va_entrypoints.begin(), va_entrypoints.begin() + num_entrypoints, VAEntrypointVideoProc) == va_entrypoints.begin() + num_entrypoints) {
+            ERR("VA video processing is not supported by the driver.");
+            return ROCDEC_NOT_SUPPORTED;
+        }
+        CHECK_VAAPI(vaCreateConfig(va_display, VAProfileNone, VAEntrypointVideoProc, nullptr, 0, &va_config_id));
+        entry.va_configs[VAProfileNone] = va_config_id;
+        return ROCDEC_SUCCESS;
+    }
+    ERR("The VA display has not been acquired from the display cache.");
+    return ROCDEC_INVALID_PARAMETER;
+}
+
+bool VaDisplayCache::SupportsSliceParamArrays(VADisplay va_display) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &display : displays_) {
+        if (display.second.va_display == va_display) {
+            return display.second.slice_param_arrays;
+        }
+    }
+    return false;
+}
+
+bool VaDisplayCache::IsSliceParamArrayDriver(VADisplay va_display) {
+    // the radeonsi VA driver reports "Mesa Gallium driver <major>.<minor>.<patch> for <device>"
+    const char *vendor_string = vaQueryVendorString(va_display);
+    const char *mesa_version = vendor_string ? std::strstr(vendor_string, "Mesa Gallium driver ") : nullptr;
+    int major_version = 0, minor_version = 0;
+    if (!mesa_version || std::sscanf(mesa_version, "Mesa Gallium driver %d.%d", &major_version, &minor_version) != 2) {
+        return false;
+    }
+    return major_version > MESA_SLICE_PARAM_ARRAY_MAJOR_VERSION ||
+        (major_version == MESA_SLICE_PARAM_ARRAY_MAJOR_VERSION && minor_version >= MESA_SLICE_PARAM_ARRAY_MINOR_VERSION);
+}
+
+void VaDisplayCache::ReleaseDisplay(VADisplay va_display) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = displays_.begin(); it != displays_.end(); ++it) {
+        if (it->second.va_display == va_display) {
+            if (--it->second.ref_count == 0) {
+                DestroyDisplay(it->second);
+                displays_.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+void VaDisplayCache::DestroyDisplay(VaDisplayEntry &entry) {
+    VAStatus va_status = VA_STATUS_SUCCESS;
+    for (auto &va_config : entry.va_configs) {
+        va_status = vaDestroyConfig(entry.va_display, va_config.second);
+        if (va_status != VA_STATUS_SUCCESS) {
+            ERR("vaDestroyConfig failed");
+        }
+    }
+    va_status = vaTerminate(entry.va_display);
+    if (va_status != VA_STATUS_SUCCESS) {
+        ERR("vaTerminate failed");
+    }
+    close(entry.drm_fd);
+}
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <va/va.h>
+#include <va/va_drm.h>
+#include "../../commons.h"
+
+// first Mesa release whose VA frontend walks all the elements of a slice parameter buffer of AVC and HEVC pictures.
+// Older Mesa and other drivers get one slice parameter buffer per slice.
+#define MESA_SLICE_PARAM_ARRAY_MAJOR_VERSION 24
+#define MESA_SLICE_PARAM_ARRAY_MINOR_VERSION 0
+#include "../../../api/rocdecode.h"
+
+// A VA display opened on a DRM render node, shared by all the decoder sessions of the process that use the same node
+struct VaDisplayEntry {
+    int drm_fd;
+    VADisplay va_display;
+    uint32_t ref_count;
+    std::map<VAProfile, VAConfigID> va_configs; // VLD decoder configs created on this display, one per profile, and the
+                                                // video processing config under VAProfileNone
+    bool slice_param_arrays; // the driver reads every element of a slice parameter buffer, not only the first one
+};
+
+// The VaDisplayCache singleton class shares the DRM file descriptors, VA displays and VA decoder configs between
+// decoder sessions. Displays are reference counted and torn down when the last session on a render node releases them.
+class VaDisplayCache {
+public:
+    static VaDisplayCache& GetInstance() {
+        static VaDisplayCache instance;
+        return instance;
+    }
+    rocDecStatus AcquireDisplay(const std::string &drm_node, VADisplay &va_display);
+    rocDecStatus GetDecoderConfig(VADisplay va_display, VAProfile va_profile, VAConfigID &va_config_id);
+    rocDecStatus GetVideoProcConfig(VADisplay va_display, VAConfigID &va_config_id);
+    bool SupportsSliceParamArrays(VADisplay va_display);
+    void ReleaseDisplay(VADisplay va_display);
+private:
+    std::unordered_map<std::string, VaDisplayEntry> displays_; // keyed by the render node path
+    std::mutex mutex_;
+    VaDisplayCache() = default;
+    VaDisplayCache(const VaDisplayCache&) = delete;
+    VaDisplayCache& operator = (const VaDisplayCache) = delete;
+    ~VaDisplayCache() = default;
+    void DestroyDisplay(VaDisplayEntry &entry);
+    static bool IsSliceParamArrayDriver(VADisplay va_display);
+};
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "vaapi_post_processor.h"
+#include "vaapi_videodecoder.h"
+
+VaapiPostProcessor::VaapiPostProcessor() : va_display_{0}, va_config_id_{0}, va_context_id_{0} {}
+
+VaapiPostProcessor::~VaapiPostProcessor() {
+    if (Release() != ROCDEC_SUCCESS) {
+        ERR("Failed to release the VA post-processing surfaces.");
+    }
+}
+
+rocDecStatus VaapiPostProcessor::Initialize(VADisplay va_display, uint32_t surface_format, uint32_t width, uint32_t height, uint32_t num_surfaces) {
+    rocDecStatus rocdec_status = VaDisplayCache::GetInstance().GetVideoProcConfig(va_display, va_config_id_);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    va_display_ = va_display;
+    va_surface_ids_.resize(num_surfaces);
+    CHECK_VAAPI(vaCreateSurfaces(va_display_, surface_format, width, height, va_surface_ids_.data(), va_surface_ids_.size(), nullptr, 0));
+    CHECK_VAAPI(vaCreateContext(va_display_, va_config_id_, width, height, VA_PROGRESSIVE, va_surface_ids_.data(), va_surface_ids_.size(), &va_context_id_));
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiPostProcessor::Release() {
+    if (va_context_id_) {
+        CHECK_VAAPI(vaDestroyContext(va_display_, va_context_id_));
+        va_context_id_ = 0;
+    }
+    if (!va_surface_ids_.empty()) {
+        CHECK_VAAPI(vaDestroySurfaces(va_display_, va_surface_ids_.data(), va_surface_ids_.size()));
+        va_surface_ids_.clear();
+    }
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiPostProcessor::Process(VASurfaceID src_surface_id, const VARectangle &src_region, const VARectangle &dst_region, int output_idx) {
+    if (output_idx < 0 || output_idx >= va_surface_ids_.size()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    VAProcPipelineParameterBuffer pipeline_params = {};
+    pipeline_params.surface = src_surface_id;
+    pipeline_params.surface_region = &src_region;
+    pipeline_params.output_region = &dst_region;
+    pipeline_params.output_background_color = 0xff000000; // the area outside of target_rect is black
+    pipeline_params.filter_flags = VA_FILTER_SCALING_DEFAULT;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    VABufferID pipeline_params_buf_id;
+    CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VAProcPipelineParameterBufferType, sizeof(VAProcPipelineParameterBuffer), 1, &pipeline_params, &pipeline_params_buf_id));
+    VAStatus va_status = vaBeginPicture(va_display_, va_context_id_, va_surface_ids_[output_idx]);
+    if (va_status == VA_STATUS_SUCCESS) {
+        va_status = vaRenderPicture(va_display_, va_context_id_, &pipeline_params_buf_id, 1);
+        VAStatus end_status = vaEndPicture(va_display_, va_context_id_);
+        va_status = va_status == VA_STATUS_SUCCESS ? end_status : va_status;
+    }
+    CHECK_VAAPI(vaDestroyBuffer(va_display_, pipeline_params_buf_id));
+    if (va_status != VA_STATUS_SUCCESS) {
+        ERR("VA post-processing failed with status: " + TOSTR(va_status) + " = '" + STR(vaErrorStr(va_status)) + "'");
+        return ROCDEC_RUNTIME_ERROR;
+    }
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiPostProcessor::SyncSurface(int output_idx) {
+    if (output_idx < 0 || output_idx >= va_surface_ids_.size()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    CHECK_VAAPI(vaSyncSurface(va_display_, va_surface_ids_[output_idx]));
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiPostProcessor::ExportSurface(int output_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc) {
+    if (output_idx < 0 || output_idx >= va_surface_ids_.size()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    CHECK_VAAPI(vaExportSurfaceHandle(va_display_, va_surface_ids_[output_idx],
+                VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                VA_EXPORT_SURFACE_READ_ONLY |
+                VA_EXPORT_SURFACE_SEPARATE_LAYERS,
+                &va_drm_prime_surface_desc));
+    return ROCDEC_SUCCESS;
+}
@@ -0,0 +1,52 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <va/va.h>
+#include <va/va_vpp.h>
+#include <va/va_drmcommon.h>
+#include "../../commons.h"
+#include "../../../api/rocdecode.h"
+
+// The VaapiPostProcessor class crops and scales decoded surfaces into a pool of target sized surfaces with VA video
+// processing. The pool holds one output surface per decode surface, so the output of a picture stays valid as long as
+// its decode surface does.
+class VaapiPostProcessor {
+public:
+    VaapiPostProcessor();
+    ~VaapiPostProcessor();
+    rocDecStatus Initialize(VADisplay va_display, uint32_t surface_format, uint32_t width, uint32_t height, uint32_t num_surfaces);
+    rocDecStatus Release();
+    rocDecStatus Process(VASurfaceID src_surface_id, const VARectangle &src_region, const VARectangle &dst_region, int output_idx);
+    rocDecStatus SyncSurface(int output_idx);
+    rocDecStatus ExportSurface(int output_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc);
+    uint32_t GetNumSurfaces() { return static_cast<uint32_t>(va_surface_ids_.size()); }
+private:
+    VADisplay va_display_;
+    VAConfigID va_config_id_; // owned by VaDisplayCache
+    VAContextID va_context_id_;
+    std::vector<VASurfaceID> va_surface_ids_;
+    std::mutex mutex_; // output threads post-process concurrently, the VA context takes one picture at a time
+};
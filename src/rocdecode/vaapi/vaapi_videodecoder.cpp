@@ -23,20 +23,20 @@ THE SOFTWARE.
 #include "vaapi_videodecoder.h"
 
 VaapiVideoDecoder::VaapiVideoDecoder(RocDecoderCreateInfo &decoder_create_info) : decoder_create_info_{decoder_create_info},
-    drm_fd_{-1}, va_display_{0}, va_config_attrib_{{}}, va_config_id_{0}, va_profile_ {VAProfileNone}, va_context_id_{0}, va_surface_ids_{{}},
-    pic_params_buf_id_{0}, iq_matrix_buf_id_{0}, num_slices_{0}, slice_data_buf_id_{0} {
+    va_display_{0}, va_config_id_{0}, va_profile_ {VAProfileNone}, va_context_id_{0}, va_surface_ids_{{}}, surface_width_{0}, surface_height_{0}, next_surface_idx_{0}, output_tick_{0},
+    pic_params_buf_id_{0}, iq_matrix_buf_id_{0}, slice_param_arrays_{false}, num_slice_params_buf_{0}, slice_data_buf_id_{0} {
 };
 
 VaapiVideoDecoder::~VaapiVideoDecoder() {
-    if (drm_fd_ != -1) {
-        close(drm_fd_);
-    }
     if (va_display_) {
         rocDecStatus rocdec_status = ROCDEC_SUCCESS;
         rocdec_status = DestroyDataBuffers();
         if (rocdec_status != ROCDEC_SUCCESS) {
             ERR("DestroyDataBuffers failed");
         }
+        if (post_processor_.Release() != ROCDEC_SUCCESS) {
+            ERR("Failed to release the VA post-processing surfaces.");
+        }
         VAStatus va_status = VA_STATUS_SUCCESS;
         va_status = vaDestroySurfaces(va_display_, va_surface_ids_.data(), va_surface_ids_.size());
         if (va_status != VA_STATUS_SUCCESS) {
@@ -47,15 +47,8 @@ VaapiVideoDecoder::~VaapiVideoDecoder() {
             if (va_status != VA_STATUS_SUCCESS) {
                 ERR("vaDestroyContext failed");
             }
-        if (va_config_id_)
-            va_status = vaDestroyConfig(va_display_, va_config_id_);
-            if (va_status != VA_STATUS_SUCCESS) {
-                ERR("vaDestroyConfig failed");
-            }
-        va_status = vaTerminate(va_display_);
-        if (va_status != VA_STATUS_SUCCESS) {
-            ERR("vaTerminate failed");
-        }
+        // the config and the display are shared with other sessions, the cache tears them down with the last one
+        VaDisplayCache::GetInstance().ReleaseDisplay(va_display_);
     }
 }
 
@@ -70,41 +63,14 @@ rocDecStatus VaapiVideoDecoder::InitializeDecoder(std::string device_name, std::
         return ROCDEC_NOT_SUPPORTED;
     }
 
-    std::size_t pos = gcn_arch_name.find_first_of(":");
-    std::string gcn_arch_name_base = (pos != std::string::npos) ? gcn_arch_name.substr(0, pos) : gcn_arch_name;
-
-    std::vector<int> visible_devices;
-    GetVisibleDevices(visible_devices);
-
-    int offset = 0;
-    if (gcn_arch_name_base.compare("gfx940") == 0 ||
-        gcn_arch_name_base.compare("gfx941") == 0 ||
-        gcn_arch_name_base.compare("gfx942") == 0) {
-            std::vector<ComputePartition> current_compute_partitions;
-            GetCurrentComputePartition(current_compute_partitions);
-            if (current_compute_partitions.empty()) {
-                //if the current_compute_partitions is empty then the default SPX mode is assumed.
-                if (decoder_create_info_.device_id < visible_devices.size()) {
-                    offset = visible_devices[decoder_create_info_.device_id] * 7;
-                } else {
-                    offset = decoder_create_info_.device_id * 7;
-                }
-            } else {
-                GetDrmNodeOffset(device_name, decoder_create_info_.device_id, visible_devices, current_compute_partitions, offset);
-            }
-        }
-
-    std::string drm_node = "/dev/dri/renderD";
-    if (decoder_create_info_.device_id < visible_devices.size()) {
-        drm_node += std::to_string(128 + offset + visible_devices[decoder_create_info_.device_id]);
-    } else {
-        drm_node += std::to_string(128 + offset + decoder_create_info_.device_id);
-    }
+    // the render node of the device is resolved once per process and cached
+    std::string drm_node = DrmDeviceTopology::GetInstance().GetRenderNode(decoder_create_info_.device_id, device_name, gcn_arch_name);
     rocdec_status = InitVAAPI(drm_node);
     if (rocdec_status != ROCDEC_SUCCESS) {
         ERR("Failed to initilize the VAAPI.");
         return rocdec_status;
     }
+    slice_param_arrays_ = VaDisplayCache::GetInstance().SupportsSliceParamArrays(va_display_);
     rocdec_status = CreateDecoderConfig();
     if (rocdec_status != ROCDEC_SUCCESS) {
         ERR("Failed to create a VAAPI decoder configuration.");
@@ -120,24 +86,16 @@ rocDecStatus VaapiVideoDecoder::InitializeDecoder(std::string device_name, std::
         ERR("Failed to create a VAAPI context.");
         return rocdec_status;
     }
+    rocdec_status = CreatePostProcSurfaces();
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Failed to create the VA post-processing surfaces.");
+        return rocdec_status;
+    }
     return rocdec_status;
 }
 
 rocDecStatus VaapiVideoDecoder::InitVAAPI(std::string drm_node) {
-    drm_fd_ = open(drm_node.c_str(), O_RDWR);
-    if (drm_fd_ < 0) {
-        ERR("Failed to open drm node." + drm_node);
-        return ROCDEC_NOT_INITIALIZED;
-    }
-    va_display_ = vaGetDisplayDRM(drm_fd_);
-    if (!va_display_) {
-        ERR("Failed to create va_display.");
-        return ROCDEC_NOT_INITIALIZED;
-    }
-    vaSetInfoCallback(va_display_, NULL, NULL);
-    int major_version = 0, minor_version = 0;
-    CHECK_VAAPI(vaInitialize(va_display_, &major_version, &minor_version));
-    return ROCDEC_SUCCESS;
+    return VaDisplayCache::GetInstance().AcquireDisplay(drm_node, va_display_);
 }
 
 rocDecStatus VaapiVideoDecoder::CreateDecoderConfig() {
@@ -156,10 +114,7 @@ rocDecStatus VaapiVideoDecoder::CreateDecoderConfig() {
             ERR("The codec type is not supported.");
             return ROCDEC_NOT_SUPPORTED;
     }
-    va_config_attrib_.type = VAConfigAttribRTFormat;
-    CHECK_VAAPI(vaGetConfigAttributes(va_display_, va_profile_, VAEntrypointVLD, &va_config_attrib_, 1));
-    CHECK_VAAPI(vaCreateConfig(va_display_, va_profile_, VAEntrypointVLD, &va_config_attrib_, 1, &va_config_id_));
-    return ROCDEC_SUCCESS;
+    return VaDisplayCache::GetInstance().GetDecoderConfig(va_display_, va_profile_, va_config_id_);
 }
 
 rocDecStatus VaapiVideoDecoder::CreateSurfaces() {
@@ -167,8 +122,33 @@ rocDecStatus VaapiVideoDecoder::CreateSurfaces() {
         ERR("Invalid number of decode surfaces.");
         return ROCDEC_INVALID_PARAMETER;
     }
-    va_surface_ids_.resize(decoder_create_info_.num_decode_surfaces);
+    // only the surfaces missing from va_surface_ids_ are created, the ones kept from a reconfiguration are reused
+    size_t num_existing_surfaces = va_surface_ids_.size();
+    uint32_t num_pool_surfaces = GetNumPoolSurfaces(decoder_create_info_.num_decode_surfaces);
+    InitSurfaceIdx();
+    if (num_existing_surfaces >= num_pool_surfaces) {
+        return ROCDEC_SUCCESS;
+    }
+    if (num_existing_surfaces == 0) {
+        // allocate for the largest size the session may reconfigure to, so that later resolution changes within it
+        // can keep the surfaces and the context in place. The size never shrinks across reallocations.
+        surface_width_ = std::max({decoder_create_info_.width, decoder_create_info_.max_width, surface_width_});
+        surface_height_ = std::max({decoder_create_info_.height, decoder_create_info_.max_height, surface_height_});
+    }
+    va_surface_ids_.resize(num_pool_surfaces);
     uint32_t surface_format;
+    rocDecStatus rocdec_status = GetSurfaceFormat(surface_format);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+
+    CHECK_VAAPI(vaCreateSurfaces(va_display_, surface_format, surface_width_, surface_height_,
+        va_surface_ids_.data() + num_existing_surfaces, va_surface_ids_.size() - num_existing_surfaces, nullptr, 0));
+
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiVideoDecoder::GetSurfaceFormat(uint32_t &surface_format) {
     switch (decoder_create_info_.chroma_format) {
         case rocDecVideoChromaFormat_Monochrome:
             surface_format = VA_RT_FORMAT_YUV400;
@@ -192,15 +172,183 @@ rocDecStatus VaapiVideoDecoder::CreateSurfaces() {
             ERR("The surface type is not supported");
             return ROCDEC_NOT_SUPPORTED;
     }
+    return ROCDEC_SUCCESS;
+}
+
+rocDecStatus VaapiVideoDecoder::CreatePostProcSurfaces() {
+    if (!IsPostProcessing()) {
+        return ROCDEC_SUCCESS;
+    }
+    // the output pool follows the target size, so it is recreated with every reconfiguration
+    rocDecStatus rocdec_status = post_processor_.Release();
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    uint32_t surface_format;
+    rocdec_status = GetSurfaceFormat(surface_format);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    VARectangle src_region, dst_region;
+    uint32_t target_width, target_height;
+    GetPostProcRegions(src_region, dst_region, target_width, target_height);
+    return post_processor_.Initialize(va_display_, surface_format, target_width, target_height, GetNumSurfaces());
+}
+
+void VaapiVideoDecoder::GetPostProcRegions(VARectangle &src_region, VARectangle &dst_region, uint32_t &target_width, uint32_t &target_height) {
+    // a null display_rect selects the whole coded frame, a zero target size keeps the size of the displayed area and a
+    // null target_rect fills the whole target
+    auto &display_rect = decoder_create_info_.display_rect;
+    if (display_rect.right > display_rect.left && display_rect.bottom > display_rect.top) {
+        src_region = {display_rect.left, display_rect.top, static_cast<uint16_t>(display_rect.right - display_rect.left),
+            static_cast<uint16_t>(display_rect.bottom - display_rect.top)};
+    } else {
+        src_region = {0, 0, static_cast<uint16_t>(decoder_create_info_.width), static_cast<uint16_t>(decoder_create_info_.height)};
+    }
+    target_width = decoder_create_info_.target_width ? decoder_create_info_.target_width : src_region.width;
+    target_height = decoder_create_info_.target_height ? decoder_create_info_.target_height : src_region.height;
+    auto &target_rect = decoder_create_info_.target_rect;
+    if (target_rect.right > target_rect.left && target_rect.bottom > target_rect.top) {
+        dst_region = {target_rect.left, target_rect.top, static_cast<uint16_t>(target_rect.right - target_rect.left),
+            static_cast<uint16_t>(target_rect.bottom - target_rect.top)};
+    } else {
+        dst_region = {0, 0, static_cast<uint16_t>(target_width), static_cast<uint16_t>(target_height)};
+    }
+}
 
-    CHECK_VAAPI(vaCreateSurfaces(va_display_, surface_format, decoder_create_info_.width,
-        decoder_create_info_.height, va_surface_ids_.data(), va_surface_ids_.size(), nullptr, 0));
+bool VaapiVideoDecoder::IsPostProcessing() {
+    return decoder_create_info_.decoder_flags & rocDecDecoderFlags_PostProcess;
+}
 
+int VaapiVideoDecoder::GetOutputSurfaceIdx(int surface_idx) {
+    // the output surfaces of the post-processor follow the decode surfaces in the exportable surface indices
+    return IsPostProcessing() ? static_cast<int>(GetNumSurfaces()) + surface_idx : surface_idx;
+}
+
+rocDecStatus VaapiVideoDecoder::PostProcess(int surface_idx) {
+    if (surface_idx < 0 || surface_idx >= va_surface_ids_.size()) {
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    VARectangle src_region, dst_region;
+    uint32_t target_width, target_height;
+    GetPostProcRegions(src_region, dst_region, target_width, target_height);
+    rocDecStatus rocdec_status = post_processor_.Process(va_surface_ids_[surface_idx], src_region, dst_region, surface_idx);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    return post_processor_.SyncSurface(surface_idx);
+}
+
+bool VaapiVideoDecoder::IsIntraOnlyPool() {
+    return decoder_create_info_.intra_decode_only && (decoder_create_info_.codec_type == rocDecVideoCodec_AVC ||
+        decoder_create_info_.codec_type == rocDecVideoCodec_HEVC);
+}
+
+uint32_t VaapiVideoDecoder::GetNumPoolSurfaces(uint32_t num_decode_surfaces) {
+    // intra pictures reference no other picture, so besides the one being decoded only the one the parser is about to
+    // output and the pictures waiting in the output queue of the client need a surface. Pictures the parser holds back
+    // for reordering occupy a surface on top of those, BindSurface() fails once none is left. The HIP mappings bounded
+    // by num_output_surfaces are independent of the pool.
+    if (IsIntraOnlyPool()) {
+        return std::min(num_decode_surfaces, decoder_create_info_.output_queue_depth + 2);
+    }
+    return num_decode_surfaces;
+}
+
+void VaapiVideoDecoder::InitSurfaceIdx() {
+    // only called while no output thread is using the session
+    uint32_t num_pool_surfaces = GetNumPoolSurfaces(decoder_create_info_.num_decode_surfaces);
+    pic_surface_idx_ = std::vector<std::atomic<int>>(decoder_create_info_.num_decode_surfaces);
+    surface_pic_idx_.assign(num_pool_surfaces, -1);
+    surface_output_tick_ = std::vector<std::atomic<uint64_t>>(IsIntraOnlyPool() ? num_pool_surfaces : 0);
+    for (int i = 0; i < pic_surface_idx_.size(); i++) {
+        pic_surface_idx_[i].store(IsIntraOnlyPool() || i >= num_pool_surfaces ? -1 : i, std::memory_order_relaxed);
+        if (!IsIntraOnlyPool() && i < num_pool_surfaces) {
+            surface_pic_idx_[i] = i;
+        }
+    }
+    next_surface_idx_ = 0;
+    output_tick_ = 0;
+}
+
+rocDecStatus VaapiVideoDecoder::BindSurface(int pic_idx, const std::function<bool(int)> &is_surface_held, int &surface_idx) {
+    // a surface held by the client is not decoded into, the picture is refused until the client has released it
+    if (!IsIntraOnlyPool()) {
+        surface_idx = pic_surface_idx_[pic_idx].load(std::memory_order_relaxed);
+        return surface_idx >= 0 && is_surface_held(surface_idx) ? ROCDEC_SURFACE_BUSY : ROCDEC_SUCCESS;
+    }
+    // the surfaces are handed out in decode order, skipping those whose picture the client has not received yet, still
+    // keeps or holds, so the one taken over holds the oldest picture the client is done with
+    bool is_held_skipped = false;
+    surface_idx = FindPoolSurface(is_surface_held, is_held_skipped);
+    if (surface_idx < 0) {
+        if (is_held_skipped) {
+            return ROCDEC_SURFACE_BUSY;
+        }
+        ERR("All surfaces of the intra_decode_only pool hold pictures the client has not received yet or still keeps.");
+        return ROCDEC_OUTOF_MEMORY;
+    }
+    next_surface_idx_ = (surface_idx + 1) % surface_pic_idx_.size();
+    surface_output_tick_[surface_idx].store(0, std::memory_order_release);
+    if (surface_pic_idx_[surface_idx] >= 0) {
+        pic_surface_idx_[surface_pic_idx_[surface_idx]].store(-1, std::memory_order_release);
+    }
+    int prev_surface_idx = pic_surface_idx_[pic_idx].load(std::memory_order_relaxed);
+    if (prev_surface_idx >= 0) {
+        surface_pic_idx_[prev_surface_idx] = -1;
+    }
+    surface_pic_idx_[surface_idx] = pic_idx;
+    pic_surface_idx_[pic_idx].store(surface_idx, std::memory_order_release);
     return ROCDEC_SUCCESS;
 }
 
+int VaapiVideoDecoder::GetSurfaceIdx(int pic_idx) {
+    if (pic_idx < 0 || pic_idx >= pic_surface_idx_.size()) {
+        return -1;
+    }
+    return pic_surface_idx_[pic_idx].load(std::memory_order_acquire);
+}
+
+bool VaapiVideoDecoder::IsPoolSurfaceFree(int surface_idx) {
+    // as long as the client has not received any picture, it keeps none either and the pool is taken round-robin
+    if (surface_pic_idx_[surface_idx] < 0 || !output_tick_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    uint64_t output_tick = surface_output_tick_[surface_idx].load(std::memory_order_acquire);
+    return output_tick && output_tick + decoder_create_info_.output_queue_depth <= output_tick_.load(std::memory_order_acquire);
+}
+
+int VaapiVideoDecoder::FindPoolSurface(const std::function<bool(int)> &is_surface_held, bool &is_held_skipped) {
+    // next free pool surface in decode order, -1 if there is none
+    uint32_t num_pool_surfaces = static_cast<uint32_t>(surface_pic_idx_.size());
+    for (uint32_t i = 0; i < num_pool_surfaces; i++) {
+        int surface_idx = (next_surface_idx_ + i) % num_pool_surfaces;
+        if (!IsPoolSurfaceFree(surface_idx)) {
+            continue;
+        }
+        if (is_surface_held(surface_idx)) {
+            is_held_skipped = true;
+            continue;
+        }
+        return surface_idx;
+    }
+    return -1;
+}
+
+void VaapiVideoDecoder::MarkPictureOutput(int pic_idx) {
+    // called by the output threads when a picture is returned to the client, its surface stays with the client for
+    // the next output_queue_depth returned pictures
+    if (!IsIntraOnlyPool()) {
+        return;
+    }
+    int surface_idx = GetSurfaceIdx(pic_idx);
+    if (surface_idx >= 0) {
+        surface_output_tick_[surface_idx].store(++output_tick_, std::memory_order_release);
+    }
+}
+
 rocDecStatus VaapiVideoDecoder::CreateContext() {
-    CHECK_VAAPI(vaCreateContext(va_display_, va_config_id_, decoder_create_info_.width, decoder_create_info_.height,
+    CHECK_VAAPI(vaCreateContext(va_display_, va_config_id_, surface_width_, surface_height_,
         VA_PROGRESSIVE, va_surface_ids_.data(), va_surface_ids_.size(), &va_context_id_));
     return ROCDEC_SUCCESS;
 }
@@ -214,7 +362,7 @@ rocDecStatus VaapiVideoDecoder::DestroyDataBuffers() {
         CHECK_VAAPI(vaDestroyBuffer(va_display_, iq_matrix_buf_id_));
         iq_matrix_buf_id_ = 0;
     }
-    for (int i = 0; i < num_slices_; i++) {
+    for (uint32_t i = 0; i < num_slice_params_buf_; i++) {
         if (slice_params_buf_id_[i]) {
             CHECK_VAAPI(vaDestroyBuffer(va_display_, slice_params_buf_id_[i]));
             slice_params_buf_id_[i] = 0;
@@ -227,18 +375,27 @@ rocDecStatus VaapiVideoDecoder::DestroyDataBuffers() {
     return ROCDEC_SUCCESS;
 }
 
-rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
+rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams, const std::function<bool(int)> &is_surface_held) {
     void *pic_params_ptr, *iq_matrix_ptr, *slice_params_ptr;
     uint32_t pic_params_size, iq_matrix_size, slice_params_size;
     bool scaling_list_enabled = false;
     VASurfaceID curr_surface_id;
 
-    // Get the surface id for the current picture, assuming 1:1 mapping between DPB and VAAPI decoded surfaces.
-    if (pPicParams->curr_pic_idx >= va_surface_ids_.size() || pPicParams->curr_pic_idx < 0) {
+    // Get the surface id for the current picture
+    if (pPicParams->curr_pic_idx < 0 || pPicParams->curr_pic_idx >= pic_surface_idx_.size()) {
         ERR("curr_pic_idx exceeded the VAAPI surface pool limit.");
         return ROCDEC_INVALID_PARAMETER;
     }
-    curr_surface_id = va_surface_ids_[pPicParams->curr_pic_idx];
+    int curr_surface_idx = -1;
+    rocDecStatus rocdec_status = BindSurface(pPicParams->curr_pic_idx, is_surface_held, curr_surface_idx);
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        return rocdec_status;
+    }
+    if (curr_surface_idx < 0) {
+        ERR("curr_pic_idx exceeded the VAAPI surface pool limit.");
+        return ROCDEC_INVALID_PARAMETER;
+    }
+    curr_surface_id = va_surface_ids_[curr_surface_idx];
 
     // Upload data buffers
     switch (decoder_create_info_.codec_type) {
@@ -246,11 +403,13 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
             pPicParams->pic_params.hevc.curr_pic.pic_idx = curr_surface_id;
             for (int i = 0; i < 15; i++) {
                 if (pPicParams->pic_params.hevc.ref_frames[i].pic_idx != 0xFF) {
-                    if (pPicParams->pic_params.hevc.ref_frames[i].pic_idx >= va_surface_ids_.size() || pPicParams->pic_params.hevc.ref_frames[i].pic_idx < 0) {
+                    int ref_surface_idx = GetSurfaceIdx(pPicParams->pic_params.hevc.ref_frames[i].pic_idx);
+                    if (ref_surface_idx < 0 && !IsIntraOnlyPool()) {
                         ERR("Reference frame index exceeded the VAAPI surface pool limit.");
                         return ROCDEC_INVALID_PARAMETER;
                     }
-                    pPicParams->pic_params.hevc.ref_frames[i].pic_idx = va_surface_ids_[pPicParams->pic_params.hevc.ref_frames[i].pic_idx];
+                    // intra pictures never read their reference list, pictures without a surface are left out of it
+                    pPicParams->pic_params.hevc.ref_frames[i].pic_idx = ref_surface_idx < 0 ? VA_INVALID_SURFACE : va_surface_ids_[ref_surface_idx];
                 }
             }
             pic_params_ptr = (void*)&pPicParams->pic_params.hevc;
@@ -277,11 +436,13 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
             pPicParams->pic_params.avc.curr_pic.pic_idx = curr_surface_id;
             for (int i = 0; i < 16; i++) {
                 if (pPicParams->pic_params.avc.ref_frames[i].pic_idx != 0xFF) {
-                    if (pPicParams->pic_params.avc.ref_frames[i].pic_idx >= va_surface_ids_.size() || pPicParams->pic_params.avc.ref_frames[i].pic_idx < 0) {
+                    int ref_surface_idx = GetSurfaceIdx(pPicParams->pic_params.avc.ref_frames[i].pic_idx);
+                    if (ref_surface_idx < 0 && !IsIntraOnlyPool()) {
                         ERR("Reference frame index exceeded the VAAPI surface pool limit.");
                         return ROCDEC_INVALID_PARAMETER;
                     }
-                    pPicParams->pic_params.avc.ref_frames[i].pic_idx = va_surface_ids_[pPicParams->pic_params.avc.ref_frames[i].pic_idx];
+                    // intra pictures never read their reference list, pictures without a surface are left out of it
+                    pPicParams->pic_params.avc.ref_frames[i].pic_idx = ref_surface_idx < 0 ? VA_INVALID_SURFACE : va_surface_ids_[ref_surface_idx];
                 }
             }
             pic_params_ptr = (void*)&pPicParams->pic_params.avc;
@@ -308,7 +469,7 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
     }
 
     // Destroy the data buffers of the previous frame
-    rocDecStatus rocdec_status = DestroyDataBuffers();
+    rocdec_status = DestroyDataBuffers();
     if (rocdec_status != ROCDEC_SUCCESS) {
         ERR("Failed to destroy VAAPI buffer.");
         return rocdec_status;
@@ -318,14 +479,21 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
     if (scaling_list_enabled) {
         CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VAIQMatrixBufferType, iq_matrix_size, 1, iq_matrix_ptr, &iq_matrix_buf_id_));
     }
-    // Resize if needed
-    num_slices_ = pPicParams->num_slices;
-    if (num_slices_ > slice_params_buf_id_.size()) {
-        slice_params_buf_id_.resize(num_slices_, {0});
-    }
-    for (int i = 0; i < num_slices_; i++) {
-        CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VASliceParameterBufferType, slice_params_size, 1, slice_params_ptr, &slice_params_buf_id_[i]));
-        slice_params_ptr = (void*)((uint8_t*)slice_params_ptr + slice_params_size);
+    // the slice parameters are contiguous, so all slices go into one buffer with an element per slice where the driver
+    // supports it (see MESA_SLICE_PARAM_ARRAY_MAJOR_VERSION)
+    if (slice_param_arrays_) {
+        num_slice_params_buf_ = 1;
+        CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VASliceParameterBufferType, slice_params_size, pPicParams->num_slices, slice_params_ptr, &slice_params_buf_id_[0]));
+    } else {
+        // Resize if needed
+        num_slice_params_buf_ = pPicParams->num_slices;
+        if (num_slice_params_buf_ > slice_params_buf_id_.size()) {
+            slice_params_buf_id_.resize(num_slice_params_buf_, {0});
+        }
+        for (uint32_t i = 0; i < num_slice_params_buf_; i++) {
+            CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VASliceParameterBufferType, slice_params_size, 1, slice_params_ptr, &slice_params_buf_id_[i]));
+            slice_params_ptr = (void*)((uint8_t*)slice_params_ptr + slice_params_size);
+        }
     }
     CHECK_VAAPI(vaCreateBuffer(va_display_, va_context_id_, VASliceDataBufferType, pPicParams->bitstream_data_len, 1, (void*)pPicParams->bitstream_data, &slice_data_buf_id_));
 
@@ -335,7 +503,7 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
     if (scaling_list_enabled) {
         CHECK_VAAPI(vaRenderPicture(va_display_, va_context_id_, &iq_matrix_buf_id_, 1));
     }
-    CHECK_VAAPI(vaRenderPicture(va_display_, va_context_id_, slice_params_buf_id_.data(), num_slices_));
+    CHECK_VAAPI(vaRenderPicture(va_display_, va_context_id_, slice_params_buf_id_.data(), num_slice_params_buf_));
     CHECK_VAAPI(vaRenderPicture(va_display_, va_context_id_, &slice_data_buf_id_, 1));
     CHECK_VAAPI(vaEndPicture(va_display_, va_context_id_));
 
@@ -344,10 +512,11 @@ rocDecStatus VaapiVideoDecoder::SubmitDecode(RocdecPicParams *pPicParams) {
 
 rocDecStatus VaapiVideoDecoder::GetDecodeStatus(int pic_idx, RocdecDecodeStatus *decode_status) {
     VASurfaceStatus va_surface_status;
-    if (pic_idx >= va_surface_ids_.size() || decode_status == nullptr) {
+    int surface_idx = GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0 || decode_status == nullptr) {
         return ROCDEC_INVALID_PARAMETER;
     }
-    CHECK_VAAPI(vaQuerySurfaceStatus(va_display_, va_surface_ids_[pic_idx], &va_surface_status));
+    CHECK_VAAPI(vaQuerySurfaceStatus(va_display_, va_surface_ids_[surface_idx], &va_surface_status));
     switch (va_surface_status) {
         case VASurfaceRendering:
             decode_status->decode_status = rocDecodeStatus_InProgress;
@@ -364,11 +533,14 @@ rocDecStatus VaapiVideoDecoder::GetDecodeStatus(int pic_idx, RocdecDecodeStatus
     return ROCDEC_SUCCESS;
 }
 
-rocDecStatus VaapiVideoDecoder::ExportSurface(int pic_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc) {
-    if (pic_idx >= va_surface_ids_.size()) {
+rocDecStatus VaapiVideoDecoder::ExportSurface(int surface_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc) {
+    if (surface_idx >= static_cast<int>(va_surface_ids_.size()) && IsPostProcessing()) {
+        return post_processor_.ExportSurface(surface_idx - va_surface_ids_.size(), va_drm_prime_surface_desc);
+    }
+    if (surface_idx < 0 || surface_idx >= va_surface_ids_.size()) {
         return ROCDEC_INVALID_PARAMETER;
     }
-    CHECK_VAAPI(vaExportSurfaceHandle(va_display_, va_surface_ids_[pic_idx],
+    CHECK_VAAPI(vaExportSurfaceHandle(va_display_, va_surface_ids_[surface_idx],
                 VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
                 VA_EXPORT_SURFACE_READ_ONLY |
                 VA_EXPORT_SURFACE_SEPARATE_LAYERS,
@@ -385,15 +557,32 @@ rocDecStatus VaapiVideoDecoder::ReconfigureDecoder(RocdecReconfigureDecoderInfo
         ERR("VAAPI decoder has not been initialized but reconfiguration of the decoder has been requested.");
         return ROCDEC_NOT_SUPPORTED;
     }
-    CHECK_VAAPI(vaDestroySurfaces(va_display_, va_surface_ids_.data(), va_surface_ids_.size()));
-    CHECK_VAAPI(vaDestroyContext(va_display_, va_context_id_));
-
-    va_surface_ids_.clear();
+    uint32_t num_reusable_surfaces = GetNumReusableSurfaces(reconfig_params);
     decoder_create_info_.width = reconfig_params->width;
     decoder_create_info_.height = reconfig_params->height;
     decoder_create_info_.num_decode_surfaces = reconfig_params->num_decode_surfaces;
     decoder_create_info_.target_height = reconfig_params->target_height;
     decoder_create_info_.target_width = reconfig_params->target_width;
+    decoder_create_info_.display_rect.left = reconfig_params->display_rect.left;
+    decoder_create_info_.display_rect.top = reconfig_params->display_rect.top;
+    decoder_create_info_.display_rect.right = reconfig_params->display_rect.right;
+    decoder_create_info_.display_rect.bottom = reconfig_params->display_rect.bottom;
+    decoder_create_info_.target_rect.left = reconfig_params->target_rect.left;
+    decoder_create_info_.target_rect.top = reconfig_params->target_rect.top;
+    decoder_create_info_.target_rect.right = reconfig_params->target_rect.right;
+    decoder_create_info_.target_rect.bottom = reconfig_params->target_rect.bottom;
+    if (num_reusable_surfaces > 0 && num_reusable_surfaces >= GetNumPoolSurfaces(reconfig_params->num_decode_surfaces)) {
+        // the new size fits into the allocated surfaces: the surfaces and the context stay in place, and the
+        // picture dimensions are passed along with every picture
+        InitSurfaceIdx();
+        return CreatePostProcSurfaces();
+    }
+
+    CHECK_VAAPI(vaDestroyContext(va_display_, va_context_id_));
+    if (num_reusable_surfaces == 0) {
+        CHECK_VAAPI(vaDestroySurfaces(va_display_, va_surface_ids_.data(), va_surface_ids_.size()));
+        va_surface_ids_.clear();
+    }
 
     rocDecStatus rocdec_status = CreateSurfaces();
     if (rocdec_status != ROCDEC_SUCCESS) {
@@ -405,115 +594,64 @@ rocDecStatus VaapiVideoDecoder::ReconfigureDecoder(RocdecReconfigureDecoderInfo
         ERR("Failed to create a VAAPI context during the decoder reconfiguration.");
         return rocdec_status;
     }
+    rocdec_status = CreatePostProcSurfaces();
+    if (rocdec_status != ROCDEC_SUCCESS) {
+        ERR("Failed to create the VA post-processing surfaces during the decoder reconfiguration.");
+        return rocdec_status;
+    }
     return rocdec_status;
 }
 
+uint32_t VaapiVideoDecoder::GetNumReusableSurfaces(RocdecReconfigureDecoderInfo *reconfig_params) {
+    // all surfaces are kept across a reconfiguration as long as the new size fits into them
+    if (reconfig_params->width > surface_width_ || reconfig_params->height > surface_height_) {
+        return 0;
+    }
+    return static_cast<uint32_t>(va_surface_ids_.size());
+}
+
 rocDecStatus VaapiVideoDecoder::SyncSurface(int pic_idx) {
-    if (pic_idx >= va_surface_ids_.size()) {
+    int surface_idx = GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0) {
         return ROCDEC_INVALID_PARAMETER;
     }
     VASurfaceStatus surface_status;
-    CHECK_VAAPI(vaQuerySurfaceStatus(va_display_, va_surface_ids_[pic_idx], &surface_status));
+    CHECK_VAAPI(vaQuerySurfaceStatus(va_display_, va_surface_ids_[surface_idx], &surface_status));
     if (surface_status != VASurfaceReady) {
-        CHECK_VAAPI(vaSyncSurface(va_display_, va_surface_ids_[pic_idx]));
+        CHECK_VAAPI(vaSyncSurface(va_display_, va_surface_ids_[surface_idx]));
     }
     return ROCDEC_SUCCESS;
 }
 
-void VaapiVideoDecoder::GetVisibleDevices(std::vector<int>& visible_devices_vetor) {
-    char *visible_devices = std::getenv("HIP_VISIBLE_DEVICES");
-    if (visible_devices != nullptr) {
-        char *token = std::strtok(visible_devices,",");
-        while (token != nullptr) {
-            visible_devices_vetor.push_back(std::atoi(token));
-            token = std::strtok(nullptr,",");
+rocDecStatus VaapiVideoDecoder::ResetDecoder() {
+    // let every outstanding decode finish before the surfaces are handed to a new stream; the data buffers of the last
+    // submission are not needed anymore
+    for (auto surface_id : va_surface_ids_) {
+        VAStatus va_status = vaSyncSurface(va_display_, surface_id);
+        if (va_status != VA_STATUS_SUCCESS && va_status != VA_STATUS_ERROR_DECODING_ERROR) {
+            ERR("vaSyncSurface failed with status: " + TOSTR(va_status) + " = '" + STR(vaErrorStr(va_status)) + "' during reset");
+            return ROCDEC_RUNTIME_ERROR;
         }
-    std::sort(visible_devices_vetor.begin(), visible_devices_vetor.end());
     }
+    InitSurfaceIdx();
+    return DestroyDataBuffers();
 }
 
-void VaapiVideoDecoder::GetCurrentComputePartition(std::vector<ComputePartition> &current_compute_partitions) {
-    std::string search_path = "/sys/devices/";
-    std::string partition_file = "current_compute_partition";
-#if __cplusplus >= 201703L && __has_include(<filesystem>)
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(search_path)) {
-#else
-    for (const auto& entry : std::experimental::filesystem::recursive_directory_iterator(search_path)) {
-#endif
-        if (entry.path().filename() == partition_file) {
-            std::ifstream file(entry.path());
-            if (file.is_open()) {
-                std::string partition;
-                std::getline(file, partition);
-                if (partition.compare("SPX") == 0 || partition.compare("spx") == 0) {
-                    current_compute_partitions.push_back(kSpx);
-                } else if (partition.compare("DPX") == 0 || partition.compare("dpx") == 0) {
-                    current_compute_partitions.push_back(kDpx);
-                } else if (partition.compare("TPX") == 0 || partition.compare("tpx") == 0) {
-                    current_compute_partitions.push_back(kTpx);
-                } else if (partition.compare("QPX") == 0 || partition.compare("qpx") == 0) {
-                    current_compute_partitions.push_back(kQpx);
-                } else if (partition.compare("CPX") == 0 || partition.compare("cpx") == 0) {
-                    current_compute_partitions.push_back(kCpx);
-                }
-                file.close();
-            }
-        }
+rocDecStatus VaapiVideoDecoder::WaitForDecode(int pic_idx, rocDecDecodeStatus &decode_status) {
+    int surface_idx = GetSurfaceIdx(pic_idx);
+    if (surface_idx < 0) {
+        return ROCDEC_INVALID_PARAMETER;
     }
-}
-
-void VaapiVideoDecoder::GetDrmNodeOffset(std::string device_name, uint8_t device_id, std::vector<int>& visible_devices,
-                                                   std::vector<ComputePartition> &current_compute_partitions, int &offset) {
-
-    if (!current_compute_partitions.empty()) {
-        switch (current_compute_partitions[0]) {
-            case kSpx:
-                if (device_id < visible_devices.size()) {
-                    offset = visible_devices[device_id] * 7;
-                } else {
-                    offset = device_id * 7;
-                }
-                break;
-            case kDpx:
-                if (device_id < visible_devices.size()) {
-                    offset = (visible_devices[device_id] / 2) * 6;
-                } else {
-                    offset = (device_id / 2) * 6;
-                }
-                break;
-            case kTpx:
-                // Please note that although there are only 6 XCCs per socket on MI300A,
-                // there are two dummy render nodes added by the driver.
-                // This needs to be taken into account when creating drm_node on each socket in TPX mode.
-                if (device_id < visible_devices.size()) {
-                    offset = (visible_devices[device_id] / 3) * 5;
-                } else {
-                    offset = (device_id / 3) * 5;
-                }
-                break;
-            case kQpx:
-                if (device_id < visible_devices.size()) {
-                    offset = (visible_devices[device_id] / 4) * 4;
-                } else {
-                    offset = (device_id / 4) * 4;
-                }
-                break;
-            case kCpx:
-                // Please note that both MI300A and MI300X have the same gfx_arch_name which is
-                // gfx942. Therefore we cannot use the gfx942 to identify MI300A.
-                // instead use the device name and look for MI300A
-                // Also, as explained aboe in the TPX mode section, we need to be taken into account
-                // the extra two dummy nodes when creating drm_node on each socket in CPX mode as well.
-                std::string mi300a = "MI300A";
-                size_t found_mi300a = device_name.find(mi300a);
-                if (found_mi300a != std::string::npos) {
-                    if (device_id < visible_devices.size()) {
-                        offset = (visible_devices[device_id] / 6) * 2;
-                    } else {
-                        offset = (device_id / 6) * 2;
-                    }
-                }
-                break;
-        }
+    // vaSyncSurface reports a failed decode through VA_STATUS_ERROR_DECODING_ERROR, which is a status of the picture
+    // rather than a failure of the call
+    VAStatus va_status = vaSyncSurface(va_display_, va_surface_ids_[surface_idx]);
+    if (va_status == VA_STATUS_SUCCESS) {
+        decode_status = rocDecodeStatus_Success;
+    } else if (va_status == VA_STATUS_ERROR_DECODING_ERROR) {
+        decode_status = rocDecodeStatus_Error;
+    } else {
+        ERR("vaSyncSurface failed with status: " + TOSTR(va_status) + " = '" + STR(vaErrorStr(va_status)) + "' for picture idx = " + TOSTR(pic_idx));
+        return ROCDEC_RUNTIME_ERROR;
     }
-}
\ No newline at end of file
+    return ROCDEC_SUCCESS;
+}
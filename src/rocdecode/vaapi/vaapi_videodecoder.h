@@ -26,17 +26,19 @@ THE SOFTWARE.
 #include <fstream>
 #include <vector>
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
 #include <fcntl.h>
 #include <unistd.h>
 #include <cstring>
-#if __cplusplus >= 201703L && __has_include(<filesystem>)
-    #include <filesystem>
-#else
-    #include <experimental/filesystem>
-#endif
 #include <va/va.h>
 #include <va/va_drm.h>
 #include <va/va_drmcommon.h>
+#include "vaapi_display_cache.h"
+#include "vaapi_post_processor.h"
+#include "drm_device_topology.h"
 #include "../roc_decoder_caps.h"
 #include "../../commons.h"
 #include "../../../api/rocdecode.h"
@@ -51,48 +53,73 @@ THE SOFTWARE.
 
 #define INIT_SLICE_PARAM_LIST_NUM 16 // initial slice parameter buffer list size
 
-typedef enum {
-    kSpx = 0, // Single Partition Accelerator
-    kDpx = 1, // Dual Partition Accelerator
-    kTpx = 2, // Triple Partition Accelerator
-    kQpx = 3, // Quad Partition Accelerator
-    kCpx = 4, // Core Partition Accelerator
-} ComputePartition;
-
 class VaapiVideoDecoder {
 public:
     VaapiVideoDecoder(RocDecoderCreateInfo &decoder_create_info);
     ~VaapiVideoDecoder();
     rocDecStatus InitializeDecoder(std::string device_name, std::string gcn_arch_name);
-    rocDecStatus SubmitDecode(RocdecPicParams *pPicParams);
+    rocDecStatus SubmitDecode(RocdecPicParams *pPicParams, const std::function<bool(int)> &is_surface_held);
     rocDecStatus GetDecodeStatus(int pic_idx, RocdecDecodeStatus* decode_status);
-    rocDecStatus ExportSurface(int pic_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc);
+    rocDecStatus ExportSurface(int surface_idx, VADRMPRIMESurfaceDescriptor &va_drm_prime_surface_desc);
     rocDecStatus SyncSurface(int pic_idx);
+    rocDecStatus WaitForDecode(int pic_idx, rocDecDecodeStatus &decode_status);
     rocDecStatus ReconfigureDecoder(RocdecReconfigureDecoderInfo *reconfig_params);
+    rocDecStatus ResetDecoder();
+    uint32_t GetNumReusableSurfaces(RocdecReconfigureDecoderInfo *reconfig_params);
+    uint32_t GetNumSurfaces() { return static_cast<uint32_t>(va_surface_ids_.size()); }
+    uint32_t GetSurfaceWidth() { return surface_width_; }
+    uint32_t GetSurfaceHeight() { return surface_height_; }
+    uint32_t GetNumPoolSurfaces(uint32_t num_decode_surfaces);
+    int GetSurfaceIdx(int pic_idx);
+    void MarkPictureOutput(int pic_idx);
+    bool IsPostProcessing();
+    rocDecStatus PostProcess(int surface_idx);
+    int GetOutputSurfaceIdx(int surface_idx);
+    uint32_t GetNumExportableSurfaces() { return GetNumSurfaces() + post_processor_.GetNumSurfaces(); }
 private:
     RocDecoderCreateInfo decoder_create_info_;
-    int drm_fd_;
-    VADisplay va_display_;
-    VAConfigAttrib va_config_attrib_;
-    VAConfigID va_config_id_;
+    VADisplay va_display_; // shared with the other sessions on the same render node through VaDisplayCache
+    VAConfigID va_config_id_; // owned by VaDisplayCache
     VAProfile va_profile_;
     VAContextID va_context_id_;
     std::vector<VASurfaceID> va_surface_ids_;
+    uint32_t surface_width_; // width of the allocated surfaces, max_width if it was provided
+    uint32_t surface_height_; // height of the allocated surfaces, max_height if it was provided
+    // Picture indices map 1:1 to the surfaces, except with intra_decode_only where the pictures are bound to a smaller
+    // pool of surfaces in decode order. Only the submitting thread binds surfaces, the output threads look them up
+    // without locking.
+    std::vector<std::atomic<int>> pic_surface_idx_; // surface index of each picture index, -1 if the picture has no surface
+    std::vector<int> surface_pic_idx_; // picture index bound to each surface, -1 if none
+    uint32_t next_surface_idx_;
+    // output tick of the picture bound to each pool surface, 0 until the picture is returned to the client. The client
+    // keeps the last output_queue_depth returned pictures, so their surfaces are not taken over either.
+    std::vector<std::atomic<uint64_t>> surface_output_tick_;
+    std::atomic<uint64_t> output_tick_;
+    // with rocDecDecoderFlags_PostProcess, the decoded pictures are cropped and scaled into the surfaces of the
+    // post-processor, exported after the decode surfaces
+    VaapiPostProcessor post_processor_;
 
     VABufferID pic_params_buf_id_;
     VABufferID iq_matrix_buf_id_;
+    // one buffer holding the parameters of all slices of the picture if the driver walks its elements, one buffer per
+    // slice otherwise
+    bool slice_param_arrays_;
     std::vector<VABufferID> slice_params_buf_id_ = std::vector<VABufferID>(INIT_SLICE_PARAM_LIST_NUM, 0);
-    uint32_t num_slices_;
+    uint32_t num_slice_params_buf_;
     VABufferID slice_data_buf_id_;
     uint32_t slice_data_buf_size_;
 
     rocDecStatus InitVAAPI(std::string drm_node);
     rocDecStatus CreateDecoderConfig();
     rocDecStatus CreateSurfaces();
+    rocDecStatus GetSurfaceFormat(uint32_t &surface_format);
+    rocDecStatus CreatePostProcSurfaces();
+    void GetPostProcRegions(VARectangle &src_region, VARectangle &dst_region, uint32_t &target_width, uint32_t &target_height);
+    bool IsIntraOnlyPool();
+    void InitSurfaceIdx();
+    rocDecStatus BindSurface(int pic_idx, const std::function<bool(int)> &is_surface_held, int &surface_idx);
+    bool IsPoolSurfaceFree(int surface_idx);
+    int FindPoolSurface(const std::function<bool(int)> &is_surface_held, bool &is_held_skipped);
     rocDecStatus CreateContext();
     rocDecStatus DestroyDataBuffers();
-    void GetVisibleDevices(std::vector<int>& visible_devices);
-    void GetCurrentComputePartition(std::vector<ComputePartition> &currnet_compute_partitions);
-    void GetDrmNodeOffset(std::string device_name, uint8_t device_id, std::vector<int>& visible_devices,
-                                    std::vector<ComputePartition> &current_compute_partitions, int &offset);
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#if __cplusplus >= 201703L && __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+#include "drm_device_topology.h"
+#include "unit_test.h"
+
+// Fake sysfs tree with one class/drm/renderD* node per entry of partitions, each reporting its compute partition mode
+class FakeSysfs {
+public:
+    explicit FakeSysfs(const std::vector<std::string> &partitions) {
+        root_ = fs::temp_directory_path() / ("rocdecode_sysfs_" + std::to_string(getpid()) + "_" + std::to_string(num_trees_++));
+        fs::create_directories(root_ / "class" / "drm" / "card0");
+        for (size_t i = 0; i < partitions.size(); i++) {
+            fs::path device_path = root_ / "class" / "drm" / ("renderD" + std::to_string(128 + i)) / "device";
+            fs::create_directories(device_path);
+            std::ofstream(device_path / "current_compute_partition") << partitions[i] << "\n";
+        }
+    }
+    ~FakeSysfs() {
+        std::error_code ec;
+        fs::remove_all(root_, ec);
+    }
+    std::string GetRoot() const { return root_.string(); }
+
+private:
+    fs::path root_;
+    static int num_trees_;
+};
+int FakeSysfs::num_trees_ = 0;
+
+static void TestWithoutPartitions() {
+    FakeSysfs sysfs({});
+    DrmDeviceTopology topology(sysfs.GetRoot(), nullptr);
+    CHECK(topology.GetVisibleDevices().empty());
+    CHECK(topology.GetComputePartitions().empty());
+    CHECK_EQ(topology.GetRenderNode(0, "AMD Instinct MI210", "gfx90a:sramecc+:xnack-"), std::string("/dev/dri/renderD128"));
+    CHECK_EQ(topology.GetRenderNode(1, "AMD Instinct MI210", "gfx90a:sramecc+:xnack-"), std::string("/dev/dri/renderD129"));
+    // gfx94x without a reported partition mode is taken as SPX: 7 render nodes per device
+    CHECK_EQ(topology.GetRenderNode(2, "AMD Instinct MI300X", "gfx942:sramecc+:xnack-"), std::string("/dev/dri/renderD144"));
+}
+
+static void TestVisibleDevices() {
+    FakeSysfs sysfs({});
+    // the list is sorted, and the devices beyond it keep their own index
+    DrmDeviceTopology topology(sysfs.GetRoot(), "3,1,,");
+    CHECK_EQ(topology.GetVisibleDevices().size(), size_t(2));
+    CHECK_EQ(topology.GetRenderNode(0, "AMD Radeon PRO W6800", "gfx1030"), std::string("/dev/dri/renderD129"));
+    CHECK_EQ(topology.GetRenderNode(1, "AMD Radeon PRO W6800", "gfx1030"), std::string("/dev/dri/renderD131"));
+    CHECK_EQ(topology.GetRenderNode(2, "AMD Radeon PRO W6800", "gfx1030"), std::string("/dev/dri/renderD130"));
+
+    DrmDeviceTopology empty_env_topology(sysfs.GetRoot(), "");
+    CHECK(empty_env_topology.GetVisibleDevices().empty());
+    CHECK_EQ(empty_env_topology.GetRenderNode(1, "AMD Radeon PRO W6800", "gfx1030"), std::string("/dev/dri/renderD129"));
+}
+
+static void TestComputePartitions() {
+    FakeSysfs sysfs({"DPX", "dpx", "bogus"});
+    DrmDeviceTopology topology(sysfs.GetRoot(), nullptr);
+    std::vector<ComputePartition> partitions = topology.GetComputePartitions();
+    CHECK_EQ(partitions.size(), size_t(2));
+    CHECK(partitions.size() == 2 && partitions[0] == kDpx && partitions[1] == kDpx);
+    // DPX: 6 render nodes per pair of partitions
+    CHECK_EQ(topology.GetRenderNode(1, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD129"));
+    CHECK_EQ(topology.GetRenderNode(2, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD136"));
+    CHECK_EQ(topology.GetRenderNode(5, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD145"));
+}
+
+static void TestSpxAndTpxAndQpx() {
+    FakeSysfs spx_sysfs({"SPX"});
+    DrmDeviceTopology spx_topology(spx_sysfs.GetRoot(), nullptr);
+    CHECK_EQ(spx_topology.GetRenderNode(1, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD136"));
+
+    FakeSysfs tpx_sysfs({"TPX"});
+    DrmDeviceTopology tpx_topology(tpx_sysfs.GetRoot(), nullptr);
+    CHECK_EQ(tpx_topology.GetRenderNode(4, "AMD Instinct MI300A", "gfx942"), std::string("/dev/dri/renderD137"));
+
+    FakeSysfs qpx_sysfs({"QPX"});
+    DrmDeviceTopology qpx_topology(qpx_sysfs.GetRoot(), nullptr);
+    CHECK_EQ(qpx_topology.GetRenderNode(4, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD136"));
+}
+
+static void TestCpxWithVisibleDevices() {
+    FakeSysfs sysfs({"CPX"});
+    // MI300A adds 2 dummy render nodes per socket of 6 partitions, MI300X doesn't
+    DrmDeviceTopology mi300a_topology(sysfs.GetRoot(), "9,8");
+    CHECK_EQ(mi300a_topology.GetRenderNode(0, "AMD Instinct MI300A", "gfx942:sramecc+:xnack-"), std::string("/dev/dri/renderD138"));
+    CHECK_EQ(mi300a_topology.GetRenderNode(1, "AMD Instinct MI300A", "gfx942:sramecc+:xnack-"), std::string("/dev/dri/renderD139"));
+    DrmDeviceTopology mi300x_topology(sysfs.GetRoot(), "9,8");
+    CHECK_EQ(mi300x_topology.GetRenderNode(1, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD137"));
+}
+
+static void TestCaching() {
+    FakeSysfs sysfs({"SPX"});
+    DrmDeviceTopology topology(sysfs.GetRoot(), nullptr);
+    CHECK_EQ(topology.GetRenderNode(1, "AMD Instinct MI300X", "gfx942"), std::string("/dev/dri/renderD136"));
+    // the resolved node is kept for the device, whatever is asked for it later
+    CHECK_EQ(topology.GetRenderNode(1, "AMD Instinct MI210", "gfx90a"), std::string("/dev/dri/renderD136"));
+    std::map<int, std::string> render_nodes = topology.GetResolvedRenderNodes();
+    CHECK_EQ(render_nodes.size(), size_t(1));
+    CHECK_EQ(render_nodes[1], std::string("/dev/dri/renderD136"));
+}
+
+int main(int argc, char **argv) {
+    TestWithoutPartitions();
+    TestVisibleDevices();
+    TestComputePartitions();
+    TestSpxAndTpxAndQpx();
+    TestCpxWithVisibleDevices();
+    TestCaching();
+    return GetTestResult("drm_device_topology_test");
+}
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "roc_decoder_scheduler.h"
+#include "unit_test.h"
+
+// Device model of a fake system made of the given GPU architectures
+class FakeDeviceModel : public RocDecDeviceModel {
+public:
+    explicit FakeDeviceModel(const std::vector<std::string> &gcn_arch_names) : gcn_arch_names_(gcn_arch_names) {}
+    int GetNumDevices() override { return static_cast<int>(gcn_arch_names_.size()); }
+    std::string GetGcnArchName(int device_id) override { return gcn_arch_names_[device_id]; }
+
+private:
+    std::vector<std::string> gcn_arch_names_;
+};
+
+static RocdecDevicePlacementInfo GetPlacementInfo(rocDecVideoCodec codec_type, uint32_t width, uint32_t height, uint32_t fps) {
+    RocdecDevicePlacementInfo placement_info = {};
+    placement_info.codec_type = codec_type;
+    placement_info.chroma_format = rocDecVideoChromaFormat_420;
+    placement_info.width = width;
+    placement_info.height = height;
+    placement_info.frame_rate_numerator = fps;
+    placement_info.frame_rate_denominator = fps ? 1 : 0;
+    return placement_info;
+}
+
+static int Acquire(RocDecoderScheduler &scheduler, const RocdecDevicePlacementInfo &placement_info) {
+    int device_id = -1;
+    CHECK_EQ(scheduler.AcquireDevice(placement_info, device_id), ROCDEC_SUCCESS);
+    return device_id;
+}
+
+static void TestPixelRate() {
+    CHECK_EQ(RocDecoderScheduler::GetPixelRate(GetPlacementInfo(rocDecVideoCodec_HEVC, 1920, 1080, 60)), 1920.0 * 1080.0 * 60.0);
+    // 30 fps when the frame rate is unknown
+    CHECK_EQ(RocDecoderScheduler::GetPixelRate(GetPlacementInfo(rocDecVideoCodec_HEVC, 1920, 1080, 0)), 1920.0 * 1080.0 * 30.0);
+}
+
+static void TestHeadroom() {
+    // gfx90a has 2 VCN instances, gfx942 has 3: a 4K60 HEVC stream takes one instance
+    RocDecoderScheduler scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx90a", "gfx942"}));
+    RocdecDevicePlacementInfo stream_4k60 = GetPlacementInfo(rocDecVideoCodec_HEVC, 3840, 2160, 60);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+    // equal headroom left on both devices, gfx90a has fewer sessions per VCN instance
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 0);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+    // both oversubscribed, the least oversubscribed one is returned
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 0);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+
+    // sessions created without AcquireDevice count as streams like the new one
+    RocDecoderScheduler unplaced_scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx942", "gfx942"}));
+    int session_0 = 0, session_1 = 0;
+    unplaced_scheduler.AddSession(0, &session_0);
+    unplaced_scheduler.AddSession(0, &session_1);
+    CHECK_EQ(Acquire(unplaced_scheduler, stream_4k60), 1);
+    CHECK_EQ(Acquire(unplaced_scheduler, stream_4k60), 1);
+    CHECK_EQ(Acquire(unplaced_scheduler, stream_4k60), 0);
+}
+
+static void TestUnsupportedStreams() {
+    RocDecoderScheduler scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx90a", "gfx942"}));
+    int device_id = -1;
+    // AV1 is only decoded by gfx942, 8K AVC by none
+    CHECK_EQ(Acquire(scheduler, GetPlacementInfo(rocDecVideoCodec_AV1, 1920, 1080, 30)), 1);
+    CHECK_EQ(Acquire(scheduler, GetPlacementInfo(rocDecVideoCodec_AV1, 1920, 1080, 30)), 1);
+    CHECK_EQ(scheduler.AcquireDevice(GetPlacementInfo(rocDecVideoCodec_AVC, 7680, 4320, 30), device_id), ROCDEC_NOT_SUPPORTED);
+    RocDecoderScheduler no_device_scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{}));
+    CHECK_EQ(no_device_scheduler.AcquireDevice(GetPlacementInfo(rocDecVideoCodec_HEVC, 1920, 1080, 30), device_id), ROCDEC_NOT_SUPPORTED);
+}
+
+static void TestPeakMeasuredRate() {
+    RocDecoderScheduler scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx90a", "gfx90a"}));
+    RocdecDevicePlacementInfo stream_4k60 = GetPlacementInfo(rocDecVideoCodec_HEVC, 3840, 2160, 60);
+    double pixel_rate = RocDecoderScheduler::GetPixelRate(stream_4k60);
+    // device 1 was measured decoding far above the nominal rate of its 2 instances
+    int session = 0;
+    scheduler.AddSession(1, &session);
+    scheduler.ReportDecodeRate(1, &session, 5 * pixel_rate);
+    scheduler.RemoveSession(1, &session);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 1);
+    // 5 - 3 - 1 = 1 stream of headroom left on device 1, as on device 0: the fewer sessions per instance win
+    CHECK_EQ(Acquire(scheduler, stream_4k60), 0);
+
+    // a live session measured above its booked rate counts with its measured rate
+    RocDecoderScheduler measured_scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx90a", "gfx90a"}));
+    int busy_session = 0;
+    measured_scheduler.AddSession(0, &busy_session);
+    measured_scheduler.ReportDecodeRate(0, &busy_session, 1.5 * pixel_rate);
+    CHECK_EQ(Acquire(measured_scheduler, stream_4k60), 1);
+
+    // a rate reported for a session that isn't live is ignored
+    RocDecoderScheduler stale_scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx90a", "gfx90a"}));
+    int removed_session = 0;
+    stale_scheduler.ReportDecodeRate(1, &removed_session, 5 * pixel_rate);
+    CHECK_EQ(Acquire(stale_scheduler, stream_4k60), 0);
+    CHECK_EQ(Acquire(stale_scheduler, stream_4k60), 1);
+    CHECK_EQ(Acquire(stale_scheduler, stream_4k60), 0);
+}
+
+static void TestTies() {
+    // identical idle devices are filled evenly, starting with the lowest device id
+    RocDecoderScheduler scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx942", "gfx942", "gfx942"}));
+    RocdecDevicePlacementInfo stream_1080p30 = GetPlacementInfo(rocDecVideoCodec_HEVC, 1920, 1080, 30);
+    CHECK_EQ(Acquire(scheduler, stream_1080p30), 0);
+    CHECK_EQ(Acquire(scheduler, stream_1080p30), 1);
+    CHECK_EQ(Acquire(scheduler, stream_1080p30), 2);
+    CHECK_EQ(Acquire(scheduler, stream_1080p30), 0);
+}
+
+static void TestAcquireRelease() {
+    RocDecoderScheduler scheduler(std::make_unique<FakeDeviceModel>(std::vector<std::string>{"gfx1030", "gfx1030"}));
+    RocdecDevicePlacementInfo stream_4k30 = GetPlacementInfo(rocDecVideoCodec_HEVC, 3840, 2160, 30);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 0);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 1);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 0);
+    // releasing the bookings of device 0 makes it the emptiest device again
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 0), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 0), ROCDEC_SUCCESS);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 0);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 0);
+    CHECK_EQ(Acquire(scheduler, stream_4k30), 1);
+    // a device without bookings, or out of range, can't be released
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 1), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 1), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 1), ROCDEC_INVALID_PARAMETER);
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, 2), ROCDEC_INVALID_PARAMETER);
+    CHECK_EQ(scheduler.ReleaseDevice(stream_4k30, -1), ROCDEC_INVALID_PARAMETER);
+}
+
+int main(int argc, char **argv) {
+    TestPixelRate();
+    TestHeadroom();
+    TestUnsupportedStreams();
+    TestPeakMeasuredRate();
+    TestTies();
+    TestAcquireRelease();
+    return GetTestResult("roc_decoder_scheduler_test");
+}
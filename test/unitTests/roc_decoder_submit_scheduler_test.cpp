@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "roc_decoder_submit_scheduler.h"
+#include "unit_test.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Simulated backend: the submissions only record their dispatch order
+class DispatchLog {
+public:
+    std::function<rocDecStatus()> GetSubmitFn(int submission_id) {
+        return [this, submission_id] {
+            std::lock_guard<std::mutex> lock(mutex_);
+            dispatch_order_.push_back(submission_id);
+            return ROCDEC_SUCCESS;
+        };
+    }
+    std::vector<int> GetDispatchOrder() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dispatch_order_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<int> dispatch_order_;
+};
+
+// Keeps the scheduler busy with a dispatched submission until Release(), so that the submissions queued meanwhile are
+// all pending when the dispatching resumes
+class BlockingSubmission {
+public:
+    explicit BlockingSubmission(RocDecoderSubmitScheduler &scheduler) {
+        std::future<void> is_started = started_.get_future();
+        std::shared_future<void> is_released = release_.get_future().share();
+        thread_ = std::thread([this, &scheduler, is_released] {
+            scheduler.Submit(rocDecPriorityClass_Batch, SteadyClock::now() + std::chrono::hours(1), [this, is_released] {
+                started_.set_value();
+                is_released.wait();
+                return ROCDEC_SUCCESS;
+            });
+        });
+        is_started.wait();
+    }
+    void Release() {
+        release_.set_value();
+        thread_.join();
+    }
+
+private:
+    std::promise<void> started_;
+    std::promise<void> release_;
+    std::thread thread_;
+};
+
+// Submits from a new thread once the previous submissions are pending, which fixes their arrival order
+static std::thread SubmitAsync(RocDecoderSubmitScheduler &scheduler, rocDecPriorityClass priority_class, SteadyClock::time_point deadline,
+    std::function<rocDecStatus()> submit_fn) {
+    size_t num_pending = scheduler.GetNumPending();
+    std::thread submit_thread([&scheduler, priority_class, deadline, submit_fn] {
+        CHECK_EQ(scheduler.Submit(priority_class, deadline, submit_fn), ROCDEC_SUCCESS);
+    });
+    while (scheduler.GetNumPending() == num_pending) {
+        std::this_thread::yield();
+    }
+    return submit_thread;
+}
+
+static void JoinAll(std::vector<std::thread> &threads) {
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+static void TestEarliestDeadlineFirst() {
+    RocDecoderSubmitScheduler scheduler;
+    DispatchLog log;
+    auto now = SteadyClock::now();
+    BlockingSubmission blocking_submission(scheduler);
+    std::vector<std::thread> threads;
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(30), log.GetSubmitFn(3)));
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(10), log.GetSubmitFn(1)));
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(20), log.GetSubmitFn(2)));
+    // equal deadlines are dispatched in arrival order
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(20), log.GetSubmitFn(4)));
+    CHECK_EQ(scheduler.GetNumPending(), 4u);
+    blocking_submission.Release();
+    JoinAll(threads);
+    CHECK(log.GetDispatchOrder() == std::vector<int>({1, 2, 4, 3}));
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Realtime), 4u);
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Batch), 1u);
+    CHECK_EQ(scheduler.GetNumMissedDeadlines(rocDecPriorityClass_Realtime), 0u);
+}
+
+static void TestBatchBackPressure() {
+    RocDecoderSubmitScheduler scheduler;
+    DispatchLog log;
+    auto now = SteadyClock::now();
+    BlockingSubmission blocking_submission(scheduler);
+    std::vector<std::thread> threads;
+    // batch submissions wait behind every realtime one, however early their deadline
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Batch, now + std::chrono::seconds(1), log.GetSubmitFn(10)));
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(60), log.GetSubmitFn(1)));
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Batch, now + std::chrono::milliseconds(500), log.GetSubmitFn(9)));
+    threads.push_back(SubmitAsync(scheduler, rocDecPriorityClass_Realtime, now + std::chrono::seconds(50), log.GetSubmitFn(0)));
+    blocking_submission.Release();
+    JoinAll(threads);
+    CHECK(log.GetDispatchOrder() == std::vector<int>({0, 1, 9, 10}));
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Realtime), 2u);
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Batch), 3u);
+}
+
+static void TestMissedDeadlines() {
+    RocDecoderSubmitScheduler scheduler;
+    DispatchLog log;
+    auto now = SteadyClock::now();
+    CHECK_EQ(scheduler.Submit(rocDecPriorityClass_Realtime, now - std::chrono::milliseconds(1), log.GetSubmitFn(0)), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.Submit(rocDecPriorityClass_Realtime, now + std::chrono::hours(1), log.GetSubmitFn(1)), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.Submit(rocDecPriorityClass_Batch, now - std::chrono::milliseconds(1), log.GetSubmitFn(2)), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Realtime), 2u);
+    CHECK_EQ(scheduler.GetNumMissedDeadlines(rocDecPriorityClass_Realtime), 1u);
+    CHECK_EQ(scheduler.GetNumDispatched(rocDecPriorityClass_Batch), 1u);
+    CHECK_EQ(scheduler.GetNumMissedDeadlines(rocDecPriorityClass_Batch), 1u);
+
+    // a submission that falls behind while a slow one is dispatched is counted as missed when it is dispatched
+    BlockingSubmission blocking_submission(scheduler);
+    std::thread late_thread = SubmitAsync(scheduler, rocDecPriorityClass_Realtime, SteadyClock::now() + std::chrono::milliseconds(10),
+        log.GetSubmitFn(3));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    blocking_submission.Release();
+    late_thread.join();
+    CHECK_EQ(scheduler.GetNumMissedDeadlines(rocDecPriorityClass_Realtime), 2u);
+}
+
+static void TestSubmitStatus() {
+    RocDecoderSubmitScheduler scheduler;
+    auto deadline = SteadyClock::now() + std::chrono::hours(1);
+    CHECK_EQ(scheduler.Submit(rocDecPriorityClass_Realtime, deadline, [] { return ROCDEC_RUNTIME_ERROR; }), ROCDEC_RUNTIME_ERROR);
+    // an exception leaves the scheduler free for the next submission
+    bool is_thrown = false;
+    try {
+        scheduler.Submit(rocDecPriorityClass_Realtime, deadline, []() -> rocDecStatus { throw std::runtime_error("submit failed"); });
+    } catch (const std::runtime_error &) {
+        is_thrown = true;
+    }
+    CHECK(is_thrown);
+    CHECK_EQ(scheduler.Submit(rocDecPriorityClass_Batch, deadline, [] { return ROCDEC_SUCCESS; }), ROCDEC_SUCCESS);
+    CHECK_EQ(scheduler.GetNumPending(), 0u);
+}
+
+int main(int argc, char **argv) {
+    TestEarliestDeadlineFirst();
+    TestBatchBackPressure();
+    TestMissedDeadlines();
+    TestSubmitStatus();
+    return GetTestResult("roc_decoder_submit_scheduler_test");
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <memory>
+#include <thread>
+#include "roc_video_dec_ring.h"
+#include "unit_test.h"
+
+static void TestEmpty() {
+    SpscRing<int> ring(4);
+    int item = -1;
+    CHECK(ring.Empty());
+    CHECK(!ring.Full());
+    CHECK(ring.Front() == nullptr);
+    CHECK(!ring.Pop(&item));
+    CHECK_EQ(item, -1);
+
+    CHECK(ring.Push(1));
+    CHECK(!ring.Empty());
+    CHECK(ring.Pop(&item));
+    CHECK_EQ(item, 1);
+    CHECK(ring.Empty());
+    CHECK(ring.Front() == nullptr);
+}
+
+static void TestFull() {
+    // the capacity is rounded up to a power of two
+    SpscRing<int> ring(3);
+    CHECK_EQ(ring.Capacity(), 4u);
+    for (int i = 0; i < 4; i++) {
+        CHECK(ring.Push(i));
+    }
+    CHECK(ring.Full());
+    CHECK_EQ(ring.Size(), 4u);
+    CHECK(!ring.Push(4));
+
+    // a pop makes room for exactly one item, and the rejected item was not stored
+    CHECK(ring.Pop());
+    CHECK(ring.Push(4));
+    CHECK(!ring.Push(5));
+    for (int i = 1; i <= 4; i++) {
+        CHECK(ring.Front() != nullptr);
+        CHECK_EQ(*ring.Front(), i);
+        CHECK(ring.Pop());
+    }
+    CHECK(ring.Empty());
+
+    ring.Reset(8);
+    CHECK_EQ(ring.Capacity(), 8u);
+    CHECK(ring.Empty());
+}
+
+static void TestWrapAround() {
+    // the indices run over many laps of the slots, with the ring filled to a different level on each lap
+    SpscRing<int> ring(4);
+    int next_push = 0, next_pop = 0;
+    for (int lap = 0; lap < 100; lap++) {
+        int num_items = lap % 4 + 1;
+        for (int i = 0; i < num_items; i++) {
+            CHECK(ring.Push(next_push++));
+        }
+        CHECK_EQ(ring.Size(), static_cast<size_t>(num_items));
+        for (int i = 0; i < num_items; i++) {
+            int item = -1;
+            CHECK(ring.Pop(&item));
+            CHECK_EQ(item, next_pop++);
+        }
+        CHECK(ring.Empty());
+    }
+}
+
+static void TestMoveOnly() {
+    // Pop() moves the item out, so the slot no longer owns it
+    SpscRing<std::shared_ptr<int>> ring(2);
+    std::shared_ptr<int> item = std::make_shared<int>(7);
+    CHECK(ring.Push(item));
+    CHECK_EQ(item.use_count(), 2);
+    std::shared_ptr<int> popped;
+    CHECK(ring.Pop(&popped));
+    CHECK_EQ(*popped, 7);
+    CHECK_EQ(item.use_count(), 2);
+}
+
+static void TestConcurrent() {
+    // a small ring keeps both sides hitting the full and empty cases; the consumer must see every item once, in order
+    const int num_items = 1000000;
+    SpscRing<int> ring(16);
+    std::thread producer([&] {
+        for (int i = 0; i < num_items; i++) {
+            while (!ring.Push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int num_out_of_order = 0;
+    for (int expected = 0; expected < num_items; ) {
+        int item = -1;
+        if (!ring.Pop(&item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item != expected) num_out_of_order++;
+        expected++;
+    }
+    producer.join();
+    CHECK_EQ(num_out_of_order, 0);
+    CHECK(ring.Empty());
+}
+
+int main(int argc, char **argv) {
+    TestEmpty();
+    TestFull();
+    TestWrapAround();
+    TestMoveOnly();
+    TestConcurrent();
+    return GetTestResult("roc_video_dec_ring_test");
+}
@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <thread>
+#include <vector>
+#include "roc_video_dec_segment.h"
+#include "unit_test.h"
+
+typedef std::vector<uint8_t> Bitstream;
+
+static bool ScanPacket(StreamSegmenter &segmenter, const Bitstream &packet) {
+    return segmenter.ScanPacket(packet.data(), packet.size());
+}
+
+static Bitstream Concat(std::initializer_list<Bitstream> parts) {
+    Bitstream bitstream;
+    for (auto &part : parts) {
+        bitstream.insert(bitstream.end(), part.begin(), part.end());
+    }
+    return bitstream;
+}
+
+static void TestAvcRandomAccessPoints() {
+    StreamSegmenter segmenter(rocDecVideoCodec_AVC);
+    Bitstream sps = {0, 0, 0, 1, 0x67, 0x42, 0xC0, 0x1E, 0x8C};
+    Bitstream pps = {0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    Bitstream idr = {0, 0, 1, 0x65, 0x88, 0x84, 0x21};
+    Bitstream non_idr = {0, 0, 0, 1, 0x41, 0x9A, 0x02, 0x11};
+    Bitstream key_packet = Concat({sps, pps, idr});
+
+    CHECK(ScanPacket(segmenter, key_packet));
+    CHECK(!ScanPacket(segmenter, non_idr));
+    CHECK(segmenter.HasParameterSets(key_packet.data(), key_packet.size()));
+    CHECK(!segmenter.HasParameterSets(non_idr.data(), non_idr.size()));
+    // the parameter sets are saved with a 4-byte start code
+    CHECK_EQ(segmenter.GetParameterSets().size(), 2u);
+    CHECK(segmenter.GetParameterSets()[0] == sps);
+    CHECK(segmenter.GetParameterSets()[1] == pps);
+
+    // a repeated parameter set moves last instead of being saved twice, a new one is appended
+    Bitstream new_sps = {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x28, 0xAC};
+    CHECK(!ScanPacket(segmenter, Concat({new_sps, non_idr})));
+    CHECK(!ScanPacket(segmenter, Concat({sps, non_idr})));
+    CHECK_EQ(segmenter.GetParameterSets().size(), 3u);
+    CHECK(segmenter.GetParameterSets()[0] == pps);
+    CHECK(segmenter.GetParameterSets()[1] == new_sps);
+    CHECK(segmenter.GetParameterSets()[2] == sps);
+
+    segmenter.Reset();
+    CHECK(segmenter.GetParameterSets().empty());
+}
+
+static void TestHevcRandomAccessPoints() {
+    StreamSegmenter segmenter(rocDecVideoCodec_HEVC);
+    Bitstream vps = {0, 0, 0, 1, 0x40, 0x01, 0x0C, 0x01};
+    Bitstream sps = {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01};
+    Bitstream pps = {0, 0, 0, 1, 0x44, 0x01, 0xC1, 0x72};
+    Bitstream idr_w_radl = {0, 0, 1, 0x26, 0x01, 0xAF, 0x08};
+    Bitstream bla_w_lp = {0, 0, 1, 0x20, 0x01, 0xAF, 0x08};
+    Bitstream cra = {0, 0, 1, 0x2A, 0x01, 0xAF, 0x08};
+    Bitstream trail_r = {0, 0, 1, 0x02, 0x01, 0xD0, 0x09};
+    Bitstream key_packet = Concat({vps, sps, pps, idr_w_radl});
+
+    CHECK(ScanPacket(segmenter, key_packet));
+    CHECK(ScanPacket(segmenter, bla_w_lp));
+    // the leading pictures of a CRA may reference the previous segment
+    CHECK(!ScanPacket(segmenter, Concat({vps, sps, pps, cra})));
+    CHECK(!ScanPacket(segmenter, trail_r));
+    CHECK(segmenter.HasParameterSets(key_packet.data(), key_packet.size()));
+    CHECK(!segmenter.HasParameterSets(idr_w_radl.data(), idr_w_radl.size()));
+    CHECK_EQ(segmenter.GetParameterSets().size(), 3u);
+    CHECK(segmenter.GetParameterSets()[0] == vps);
+    CHECK(segmenter.GetParameterSets()[1] == sps);
+    CHECK(segmenter.GetParameterSets()[2] == pps);
+}
+
+static void TestVp9KeyFrames() {
+    StreamSegmenter segmenter(rocDecVideoCodec_VP9);
+    // frame_marker, profile bits, show_existing_frame, frame_type
+    CHECK(ScanPacket(segmenter, {0x80, 0x49, 0x83}));    // profile 0 key frame
+    CHECK(!ScanPacket(segmenter, {0x84, 0x00}));         // profile 0 inter frame
+    CHECK(!ScanPacket(segmenter, {0x88}));               // profile 0 shown existing frame
+    CHECK(ScanPacket(segmenter, {0xB0, 0x49, 0x83}));    // profile 3 key frame
+    CHECK(!ScanPacket(segmenter, {0xB2, 0x00}));         // profile 3 inter frame
+    CHECK(!ScanPacket(segmenter, {0x00, 0x00}));         // no frame marker
+    CHECK(!ScanPacket(segmenter, {}));
+    CHECK(segmenter.GetParameterSets().empty());
+}
+
+static void TestAv1KeyFrames() {
+    StreamSegmenter segmenter(rocDecVideoCodec_AV1);
+    Bitstream temporal_delimiter = {0x12, 0x00};
+    Bitstream sequence_header = {0x0A, 0x02, 0x00, 0x00};
+    Bitstream key_frame = {0x32, 0x02, 0x10, 0x00};     // OBU_FRAME, show_existing_frame 0, KEY_FRAME, show_frame 1
+    Bitstream inter_frame = {0x32, 0x02, 0x30, 0x00};   // INTER_FRAME
+    Bitstream key_frame_header = {0x1A, 0x01, 0x10};    // OBU_FRAME_HEADER
+
+    CHECK(ScanPacket(segmenter, Concat({temporal_delimiter, sequence_header, key_frame})));
+    CHECK(ScanPacket(segmenter, Concat({temporal_delimiter, sequence_header, key_frame_header})));
+    // a key frame without a sequence header or an inter frame after one don't start a segment
+    CHECK(!ScanPacket(segmenter, Concat({temporal_delimiter, key_frame})));
+    CHECK(!ScanPacket(segmenter, Concat({temporal_delimiter, sequence_header, inter_frame})));
+    // truncated OBU
+    CHECK(!ScanPacket(segmenter, {0x12}));
+}
+
+static void TestOtherCodecs() {
+    StreamSegmenter segmenter(rocDecVideoCodec_MPEG2);
+    Bitstream sequence_header = {0, 0, 1, 0xB3, 0x14, 0x00};
+    CHECK(!ScanPacket(segmenter, sequence_header));
+    CHECK(segmenter.HasParameterSets(sequence_header.data(), sequence_header.size()));
+}
+
+// Frames numbered in the order of the stream, decoded by sessions running concurrently and ahead of each other
+static void TestSegmentOrder() {
+    const uint32_t num_sessions = 3;
+    const std::vector<int> segment_sizes = {4, 1, 6, 0, 3, 5, 2, 7};
+    std::vector<int> first_frames;
+    int num_frames = 0;
+    for (int segment_size : segment_sizes) {
+        first_frames.push_back(num_frames);
+        num_frames += segment_size;
+    }
+
+    SegmentedFrameQueue<int> frame_queue(num_sessions, 2);
+    CHECK_EQ(frame_queue.GetNumSessions(), num_sessions);
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<std::thread> sessions;
+        for (uint32_t session_index = 0; session_index < num_sessions; session_index++) {
+            sessions.emplace_back([&, session_index] {
+                for (size_t segment = session_index; segment < segment_sizes.size(); segment += num_sessions) {
+                    for (int i = 0; i < segment_sizes[segment]; i++) {
+                        if (!frame_queue.Push(session_index, first_frames[segment] + i)) return;
+                    }
+                    if (!frame_queue.EndSegment(session_index)) return;
+                }
+                frame_queue.CloseSession(session_index);
+            });
+        }
+        int frame, next_frame = 0;
+        while (frame_queue.Pop(frame)) {
+            CHECK_EQ(frame, next_frame);
+            next_frame++;
+        }
+        CHECK_EQ(next_frame, num_frames);
+        for (auto &session : sessions) {
+            session.join();
+        }
+        // the second pass starts again from the first segment
+        frame_queue.Reset();
+    }
+}
+
+static void TestClose() {
+    SegmentedFrameQueue<int> frame_queue(2, 1);
+    int frame = -1;
+    std::thread consumer([&] { CHECK(!frame_queue.Pop(frame)); });
+    frame_queue.Close();
+    consumer.join();
+    CHECK_EQ(frame, -1);
+    CHECK(!frame_queue.Push(0, 1));
+    CHECK(!frame_queue.EndSegment(1));
+
+    // the frames queued before Close() are still handed out
+    frame_queue.Reset();
+    CHECK(frame_queue.Push(0, 7));
+    frame_queue.Close();
+    CHECK(frame_queue.Pop(frame));
+    CHECK_EQ(frame, 7);
+    CHECK(!frame_queue.Pop(frame));
+}
+
+int main(int argc, char **argv) {
+    TestAvcRandomAccessPoints();
+    TestHevcRandomAccessPoints();
+    TestVp9KeyFrames();
+    TestAv1KeyFrames();
+    TestOtherCodecs();
+    TestSegmentOrder();
+    TestClose();
+    return GetTestResult("roc_video_dec_segment_test");
+}
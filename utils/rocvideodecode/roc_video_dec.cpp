@@ -20,12 +20,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <fstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
 #include "roc_video_dec.h"
 
 RocVideoDecoder::RocVideoDecoder(int device_id, OutputSurfaceMemoryType out_mem_type, rocDecVideoCodec codec, bool force_zero_latency,
               const Rect *p_crop_rect, bool extract_user_sei_Message, int max_width, int max_height, uint32_t clk_rate) :
               device_id_{device_id}, out_mem_type_(out_mem_type), codec_id_(codec), b_force_zero_latency_(force_zero_latency), 
-              b_extract_sei_message_(extract_user_sei_Message), max_width_ (max_width), max_height_(max_height) {
+              b_extract_sei_message_(extract_user_sei_Message), max_width_ (max_width), max_height_(max_height), clk_rate_(clk_rate) {
 
     if (!InitHIP(device_id_)) {
         THROW("Failed to initilize the HIP");
@@ -34,13 +38,16 @@ RocVideoDecoder::RocVideoDecoder(int device_id, OutputSurfaceMemoryType out_mem_
     if (b_extract_sei_message_) {
         fp_sei_ = fopen("rocdec_sei_message.txt", "wb");
         curr_sei_message_ptr_ = new RocdecSeiMessageInfo;
-        memset(&sei_message_display_q_, 0, sizeof(sei_message_display_q_));
     }
     // create rocdec videoparser
+    CreateParser();
+}
+
+void RocVideoDecoder::CreateParser() {
     RocdecParserParams parser_params = {};
     parser_params.codec_type = codec_id_;
     parser_params.max_num_decode_surfaces = 1;
-    parser_params.clock_rate = clk_rate;
+    parser_params.clock_rate = clk_rate_;
     parser_params.max_display_delay = 0;
     parser_params.user_data = this;
     parser_params.pfn_sequence_callback = HandleVideoSequenceProc;
@@ -68,26 +75,12 @@ RocVideoDecoder::~RocVideoDecoder() {
     }
 
     if (roc_decoder_) {
+        std::lock_guard<std::mutex> lock(mtx_decoder_session_);
         rocDecDestroyDecoder(roc_decoder_);
         roc_decoder_ = nullptr;
     }
 
-    std::lock_guard<std::mutex> lock(mtx_vp_frame_);
-    if (out_mem_type_ != OUT_SURFACE_MEM_DEV_INTERNAL) {
-        for (auto &p_frame : vp_frames_) {
-            if (p_frame.frame_ptr) {
-              if (out_mem_type_ == OUT_SURFACE_MEM_DEV_COPIED) {
-                  hipError_t hip_status = hipFree(p_frame.frame_ptr);
-                  if (hip_status != hipSuccess) {
-                      std::cerr << "ERROR: hipFree failed! (" << hip_status << ")" << std::endl;
-                  }
-              }
-              else
-                  delete[] (p_frame.frame_ptr);
-              p_frame.frame_ptr = nullptr;
-            }
-        }
-    }
+    ReleaseOutputFrames();
     if (hip_stream_) {
         hipError_t hip_status = hipSuccess;
         hip_status = hipStreamDestroy(hip_stream_);
@@ -288,6 +281,19 @@ int RocVideoDecoder::HandleVideoSequence(RocdecVideoFormat *p_video_format) {
         return 0;
     }
 
+    if (coded_width_ && coded_height_ && is_reset_pending_ && (p_video_format->chroma_format != video_chroma_format_ ||
+        p_video_format->bit_depth_luma_minus8 != bitdepth_minus_8_)) {
+        // the stream after Reset() can't be decoded by the existing session, replace it
+        {
+            std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+            ROCDEC_API_CALL(rocDecDestroyDecoder(roc_decoder_));
+            roc_decoder_ = nullptr;
+        }
+        ReleaseOutputFrames();
+        coded_width_ = coded_height_ = 0;
+    }
+    is_reset_pending_ = false;
+
     if (coded_width_ && coded_height_) {
         // rocdecCreateDecoder() has been called before, and now there's possible config change
         return ReconfigureDecoder(p_video_format);
@@ -344,6 +350,36 @@ int RocVideoDecoder::HandleVideoSequence(RocdecVideoFormat *p_video_format) {
     if (max_height_ < (int)p_video_format->coded_height)
         max_height_ = p_video_format->coded_height;
 
+    // size the surface pool from the DPB and reorder depth of the sequence, and drop the reconfigure headroom if the
+    // surfaces don't fit into the decode memory budget of the device at max_width x max_height
+    RocdecDecoderMemoryInfo memory_info = {};
+    memory_info.codec_type = codec_id_;
+    memory_info.chroma_format = video_chroma_format_;
+    memory_info.bit_depth_minus_8 = bitdepth_minus_8_;
+    memory_info.width = max_width_;
+    memory_info.height = max_height_;
+    // the parser hands out the format embedded in a RocdecVideoFormatEx
+    RocdecVideoFormatEx *video_format_ex = reinterpret_cast<RocdecVideoFormatEx *>(p_video_format);
+    memory_info.max_dpb_frames = video_format_ex->max_dpb_frames;
+    memory_info.max_num_reorder_frames = video_format_ex->max_num_reorder_frames;
+    // the frames of OUT_SURFACE_MEM_DEV_INTERNAL are held by the application, in the output ring or with DecodedFrame handles
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        memory_info.output_queue_depth = GetFrameHandleBudget();
+    }
+    if (rocDecGetDecoderMemoryInfo(&memory_info) == ROCDEC_SUCCESS) {
+        num_decode_surfaces = std::max(num_decode_surfaces, static_cast<int>(memory_info.num_decode_surfaces));
+        uint64_t budget_in_bytes = 0, used_in_bytes = 0;
+        ROCDEC_API_CALL(rocDecGetDecoderMemoryBudget(device_id_, &budget_in_bytes, &used_in_bytes));
+        if (budget_in_bytes && used_in_bytes + memory_info.surface_size_in_bytes * num_decode_surfaces > budget_in_bytes &&
+            (max_width_ > static_cast<int>(coded_width_) || max_height_ > static_cast<int>(coded_height_))) {
+            max_width_ = coded_width_;
+            max_height_ = coded_height_;
+            memory_info.width = max_width_;
+            memory_info.height = max_height_;
+            ROCDEC_API_CALL(rocDecGetDecoderMemoryInfo(&memory_info));
+        }
+    }
+
     RocDecoderCreateInfo videoDecodeCreateInfo = { 0 };
     videoDecodeCreateInfo.device_id = device_id_;
     videoDecodeCreateInfo.codec_type = codec_id_;
@@ -372,12 +408,21 @@ int RocVideoDecoder::HandleVideoSequence(RocdecVideoFormat *p_video_format) {
     }
     videoDecodeCreateInfo.target_width = target_width_;
     videoDecodeCreateInfo.target_height = target_height_;
+    videoDecodeCreateInfo.decoder_flags = rocDecDecoderFlags_CompletionQueue;
+    if (out_mem_type_ != OUT_SURFACE_MEM_NOT_MAPPED) {
+        videoDecodeCreateInfo.decoder_flags |= rocDecDecoderFlags_PremapSurfaces;
+    }
+    if (is_deadline_scheduled_) {
+        videoDecodeCreateInfo.decoder_flags |= rocDecDecoderFlags_DeadlineScheduling;
+        videoDecodeCreateInfo.priority_class = priority_class_;
+    }
 
     chroma_height_ = (int)(ceil(disp_height_ * GetChromaHeightFactor(video_surface_format_)));
     num_chroma_planes_ = GetChromaPlaneCount(video_surface_format_);
     if (video_chroma_format_ == rocDecVideoChromaFormat_Monochrome) num_chroma_planes_ = 0;
+    // the decoder allocates its surfaces at max_width x max_height so that resolution changes within it don't recreate them
     if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL || out_mem_type_ == OUT_SURFACE_MEM_NOT_MAPPED)
-        GetSurfaceStrideInternal(video_surface_format_, p_video_format->coded_width, p_video_format->coded_height, &surface_stride_, &surface_vstride_);
+        GetSurfaceStrideInternal(video_surface_format_, max_width_, max_height_, &surface_stride_, &surface_vstride_);
     else {
         surface_stride_ = videoDecodeCreateInfo.target_width * byte_per_pixel_;    // todo:: check if we need pitched memory for faster copy
     }
@@ -407,6 +452,7 @@ int RocVideoDecoder::HandleVideoSequence(RocdecVideoFormat *p_video_format) {
 
     input_video_info_str_ << "Video Decoding Params:" << std::endl
         << "\tNum Surfaces : " << videoDecodeCreateInfo.num_decode_surfaces << std::endl
+        << "\tSurface mem  : " << (memory_info.surface_size_in_bytes * num_decode_surfaces) / (1024 * 1024) << " MB" << std::endl
         << "\tCrop         : [" << videoDecodeCreateInfo.display_rect.left << ", " << videoDecodeCreateInfo.display_rect.top << ", "
         << videoDecodeCreateInfo.display_rect.right << ", " << videoDecodeCreateInfo.display_rect.bottom << "]" << std::endl
         << "\tResize       : " << videoDecodeCreateInfo.target_width << "x" << videoDecodeCreateInfo.target_height << std::endl
@@ -414,7 +460,19 @@ int RocVideoDecoder::HandleVideoSequence(RocdecVideoFormat *p_video_format) {
     input_video_info_str_ << std::endl;
     std::cout << input_video_info_str_.str();
 
-    ROCDEC_API_CALL(rocDecCreateDecoder(&roc_decoder_, &videoDecodeCreateInfo));
+    ResizePictureInfo(videoDecodeCreateInfo.num_decode_surfaces);
+    {
+        std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+        ROCDEC_API_CALL(rocDecCreateDecoder(&roc_decoder_, &videoDecodeCreateInfo));
+        decoder_generation_++;
+    }
+    // the decode order reported by the completions of the new session starts at its first picture
+    decode_poc_base_ = decode_poc_;
+    num_frames_ready_ = num_frames_popped_ = 0;
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL && vp_frames_q_.Capacity() < 2 * videoDecodeCreateInfo.num_decode_surfaces) {
+        // the ring is empty while no session exists; it has room for every surface twice, a frame beyond it is parked
+        vp_frames_q_.Reset(2 * videoDecodeCreateInfo.num_decode_surfaces);
+    }
     return num_decode_surfaces;
 }
 
@@ -465,32 +523,21 @@ int RocVideoDecoder::ReconfigureDecoder(RocdecVideoFormat *p_video_format) {
     }
 
     // Flush and clear internal frame store to reconfigure when either coded size or display size has changed.
+    DeliverParkedFrames(parked_frames_.size());
     if (p_reconfig_params_ && p_reconfig_params_->p_fn_reconfigure_flush) 
         num_frames_flushed_during_reconfig_ += p_reconfig_params_->p_fn_reconfigure_flush(this, p_reconfig_params_->reconfig_flush_mode, static_cast<void *>(p_reconfig_params_->p_reconfig_user_struct));
     // clear the existing output buffers of different size
     // note that app lose the remaining frames in the vp_frames/vp_frames_q in case application didn't set p_fn_reconfigure_flush_ callback
-    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
-        ReleaseInternalFrames();
-    } else {
-        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
-        while(!vp_frames_.empty()) {
-            DecFrameBuffer *p_frame = &vp_frames_.back();
-            // pop decoded frame
-            vp_frames_.pop_back();
-            if (p_frame->frame_ptr) {
-              if (out_mem_type_ == OUT_SURFACE_MEM_DEV_COPIED) {
-                  hipError_t hip_status = hipFree(p_frame->frame_ptr);
-                  if (hip_status != hipSuccess) std::cerr << "ERROR: hipFree failed! (" << hip_status << ")" << std::endl;
-              }
-              else
-                  delete [] (p_frame->frame_ptr);
-            }
-        }
-    }
+    ReleaseOutputFrames();
     decoded_frame_cnt_ = 0;     // reset frame_count
     if (is_decode_res_changed) {
         coded_width_ = p_video_format->coded_width;
         coded_height_ = p_video_format->coded_height;
+        // a size beyond max_width x max_height makes the decoder reallocate its surfaces at the new size
+        if (max_width_ < static_cast<int>(coded_width_) || max_height_ < static_cast<int>(coded_height_)) {
+            max_width_ = std::max(max_width_, static_cast<int>(coded_width_));
+            max_height_ = std::max(max_height_, static_cast<int>(coded_height_));
+        }
     }
     if (is_display_rect_changed) {
         disp_rect_.left = p_video_format->display_area.left;
@@ -510,7 +557,7 @@ int RocVideoDecoder::ReconfigureDecoder(RocdecVideoFormat *p_video_format) {
     }
 
     if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL || out_mem_type_ == OUT_SURFACE_MEM_NOT_MAPPED) {
-        GetSurfaceStrideInternal(video_surface_format_, coded_width_, coded_height_, &surface_stride_, &surface_vstride_);
+        GetSurfaceStrideInternal(video_surface_format_, max_width_, max_height_, &surface_stride_, &surface_vstride_);
     } else {
         surface_stride_ = target_width_ * byte_per_pixel_;
     }
@@ -569,7 +616,11 @@ int RocVideoDecoder::ReconfigureDecoder(RocdecVideoFormat *p_video_format) {
         ROCDEC_THROW("Reconfigurition of the decoder detected but the decoder was not initialized previoulsy!", ROCDEC_NOT_SUPPORTED);
         return 0;
     }
-    ROCDEC_API_CALL(rocDecReconfigureDecoder(roc_decoder_, &reconfig_params));
+    ResizePictureInfo(reconfig_params.num_decode_surfaces);
+    {
+        std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+        ROCDEC_API_CALL(rocDecReconfigureDecoder(roc_decoder_, &reconfig_params));
+    }
 
 
     input_video_info_str_.str("");
@@ -601,8 +652,19 @@ int RocVideoDecoder::HandlePictureDecode(RocdecPicParams *pPicParams) {
     if (!roc_decoder_) {
         THROW("RocDecoder not initialized: failed with ErrCode: " +  TOSTR(ROCDEC_NOT_INITIALIZED));
     }
+    if (pPicParams->curr_pic_idx >= static_cast<int>(pic_num_in_dec_order_.size())) {
+        ResizePictureInfo(pPicParams->curr_pic_idx + 1);
+    }
     pic_num_in_dec_order_[pPicParams->curr_pic_idx] = decode_poc_++;
-    ROCDEC_API_CALL(rocDecDecodeFrame(roc_decoder_, pPicParams));
+    // a parked picture is handed out before its surface is decoded into again, beyond max_output_depth_ if needed
+    for (size_t i = 0; i < parked_frames_.size(); i++) {
+        if (parked_frames_[i].disp_info.picture_index == pPicParams->curr_pic_idx) {
+            DeliverParkedFrames(i + 1);
+            break;
+        }
+    }
+    WaitForFrameCopies(pPicParams->curr_pic_idx);
+    ROCDEC_API_CALL(DecodePicture(pPicParams));
     if (b_force_zero_latency_ && ((!pPicParams->field_pic_flag) || (pPicParams->second_field))) {
         RocdecParserDispInfo disp_info;
         memset(&disp_info, 0, sizeof(disp_info));
@@ -621,11 +683,7 @@ int RocVideoDecoder::HandlePictureDecode(RocdecPicParams *pPicParams) {
  * @return int 0:fail 1: success
  */
 int RocVideoDecoder::HandlePictureDisplay(RocdecParserDispInfo *pDispInfo) {
-    RocdecProcParams video_proc_params = {};
-    video_proc_params.progressive_frame = pDispInfo->progressive_frame;
-    video_proc_params.top_field_first = pDispInfo->top_field_first;
-
-    if (b_extract_sei_message_) {
+    if (b_extract_sei_message_ && pDispInfo->picture_index < static_cast<int>(sei_message_display_q_.size())) {
         if (sei_message_display_q_[pDispInfo->picture_index].sei_data) {
             // Write SEI Message
             uint8_t *sei_buffer = (uint8_t *)(sei_message_display_q_[pDispInfo->picture_index].sei_data);
@@ -657,44 +715,64 @@ int RocVideoDecoder::HandlePictureDisplay(RocdecParserDispInfo *pDispInfo) {
             sei_message_display_q_[pDispInfo->picture_index].sei_message = NULL; // to avoid double free
         }
     }
+    ProcessDecodeCompletions();
+    if (!parked_frames_.empty() || IsOutputFull() || !DeliverFrame(pDispInfo)) {
+        ParkFrame(pDispInfo);
+    }
+    return 1;
+}
+
+bool RocVideoDecoder::DeliverFrame(RocdecParserDispInfo *pDispInfo) {
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL && vp_frames_q_.Full()) {
+        // checked before the surface is mapped: only this thread pushes, so the ring can't fill up before the push below
+        return false;
+    }
+    RocdecProcParams video_proc_params = {};
+    video_proc_params.progressive_frame = pDispInfo->progressive_frame;
+    video_proc_params.top_field_first = pDispInfo->top_field_first;
+
     if (out_mem_type_ != OUT_SURFACE_MEM_NOT_MAPPED) {
         void * src_dev_ptr[3] = { 0 };
         uint32_t src_pitch[3] = { 0 };
-        ROCDEC_API_CALL(rocDecGetVideoFrame(roc_decoder_, pDispInfo->picture_index, src_dev_ptr, src_pitch, &video_proc_params));
-        RocdecDecodeStatus dec_status;
-        memset(&dec_status, 0, sizeof(dec_status));
-        rocDecStatus result = rocDecGetDecodeStatus(roc_decoder_, pDispInfo->picture_index, &dec_status);
-        if (result == ROCDEC_SUCCESS && (dec_status.decode_status == rocDecodeStatus_Error || dec_status.decode_status == rocDecodeStatus_Error_Concealed)) {
-            std::cerr << "Decode Error occurred for picture: " << pic_num_in_dec_order_[pDispInfo->picture_index] << std::endl;
+        if (frame_ready_callback_ && out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+            // don't wait for the decode of the surface, FrameReadyCallback() makes the frame available once it completes
+            video_proc_params.pfn_frame_ready = FrameReadyCallback;
+            video_proc_params.frame_ready_user_data = this;
+            ROCDEC_API_CALL(rocDecGetVideoFrameAsync(roc_decoder_, pDispInfo->picture_index, src_dev_ptr, src_pitch, &video_proc_params));
+        } else {
+            ROCDEC_API_CALL(rocDecGetVideoFrame(roc_decoder_, pDispInfo->picture_index, src_dev_ptr, src_pitch, &video_proc_params));
         }
         if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
             DecFrameBuffer dec_frame = { 0 };
             dec_frame.frame_ptr = (uint8_t *)(src_dev_ptr[0]);
             dec_frame.pts = pDispInfo->pts;
             dec_frame.picture_index = pDispInfo->picture_index;
-            std::lock_guard<std::mutex> lock(mtx_vp_frame_);
-            vp_frames_q_.push(dec_frame);
+            if (!vp_frames_q_.Push(dec_frame)) {
+                THROW("the output frame ring is full");
+            }
+            num_output_frames_++;
             decoded_frame_cnt_++;
         } else {
             // copy the decoded surface info device or host
             uint8_t *p_dec_frame = nullptr;
+            hipEvent_t copy_done_event = nullptr;
             {
                 std::lock_guard<std::mutex> lock(mtx_vp_frame_);
                 // if not enough frames in stock, allocate
                 if ((unsigned)++decoded_frame_cnt_ > vp_frames_.size()) {
-                    num_alloced_frames_++;
-                    DecFrameBuffer dec_frame = { 0 };
-                    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_COPIED) {
-                        // allocate device memory
-                        HIP_API_CALL(hipMalloc((void **)&dec_frame.frame_ptr, GetFrameSize()));
-                    } else {
-                        dec_frame.frame_ptr = new uint8_t[GetFrameSize()];
-                    }
-                    dec_frame.pts = pDispInfo->pts;
-                    dec_frame.picture_index = pDispInfo->picture_index;
-                    vp_frames_.push_back(dec_frame);
+                    vp_frames_.push_back(AllocateOutputFrame());
                 }
-                p_dec_frame = vp_frames_[decoded_frame_cnt_ - 1].frame_ptr;
+                DecFrameBuffer &dec_frame = vp_frames_[decoded_frame_cnt_ - 1];
+                if (!dec_frame.frame_ptr) {
+                    // the buffer of this slot is held by a DecodedFrame handle
+                    dec_frame = AllocateOutputFrame();
+                }
+                num_output_frames_++;
+                num_slot_frames_++;
+                dec_frame.pts = pDispInfo->pts;
+                dec_frame.picture_index = pDispInfo->picture_index;
+                p_dec_frame = dec_frame.frame_ptr;
+                copy_done_event = dec_frame.copy_done_event;
             }
             // Copy luma data
             int dst_pitch = disp_width_ * byte_per_pixel_;
@@ -741,7 +819,8 @@ int RocVideoDecoder::HandlePictureDisplay(RocdecParserDispInfo *pDispInfo) {
                     HIP_API_CALL(hipMemcpy2DAsync(p_frame_v, dst_pitch, p_src_ptr_v, src_pitch[2], dst_pitch, chroma_height_, hipMemcpyDeviceToHost, hip_stream_));
             }
 
-            HIP_API_CALL(hipStreamSynchronize(hip_stream_));
+            // the copies overlap with the parsing and the decode of the next pictures, GetFrame() waits for them
+            HIP_API_CALL(hipEventRecord(copy_done_event, hip_stream_));
         }
     } else {
         RocdecDecodeStatus dec_status;
@@ -752,8 +831,104 @@ int RocVideoDecoder::HandlePictureDisplay(RocdecParserDispInfo *pDispInfo) {
         }
         decoded_frame_cnt_++;
     }
+    return true;
+}
 
-    return 1;
+/**
+ * @brief function to size the per-picture bookkeeping indexed by picture_index to the decode surface count; it only grows,
+ * so the entries of the pictures still in flight across a reconfigure are kept
+ *
+ * @param num_surfaces - number of decode surfaces of the session
+ */
+void RocVideoDecoder::ResizePictureInfo(uint32_t num_surfaces) {
+    if (num_surfaces > pic_num_in_dec_order_.size()) {
+        pic_num_in_dec_order_.resize(num_surfaces, 0);
+        sei_message_display_q_.resize(num_surfaces, RocdecSeiMessageInfo{});
+    }
+}
+
+/**
+ * @brief function to hand out the pictures parked beyond max_output_depth_, in display order
+ *
+ * @param num_forced - number of parked pictures to hand out even beyond max_output_depth_
+ */
+void RocVideoDecoder::DeliverParkedFrames(size_t num_forced) {
+    while (!parked_frames_.empty() && (num_forced || !IsOutputFull())) {
+        // even a forced picture stays parked while the output ring is full, in display order with the ones behind it; the
+        // decoder refuses its held surface until then
+        if (!DeliverFrame(&parked_frames_.front().disp_info)) {
+            break;
+        }
+        if (parked_frames_.front().hold_id) {
+            ROCDEC_API_CALL(rocDecReleaseVideoFrame(roc_decoder_, parked_frames_.front().hold_id));
+        }
+        parked_frames_.pop_front();
+        if (num_forced) num_forced--;
+    }
+}
+
+/**
+ * @brief function to park a displayed picture beyond max_output_depth_: it stays in its surface and is handed out by a later
+ * DecodeFrame(). With OUT_SURFACE_MEM_DEV_INTERNAL the handout can fail on a full output ring, so the surface is held until
+ * then; the copied output modes always hand out a picture before its surface is decoded into again.
+ *
+ * @param pDispInfo - displayed picture
+ */
+void RocVideoDecoder::ParkFrame(RocdecParserDispInfo *pDispInfo) {
+    ParkedFrame parked_frame = {*pDispInfo, 0};
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        ROCDEC_API_CALL(rocDecHoldVideoFrame(roc_decoder_, pDispInfo->picture_index, &parked_frame.hold_id));
+    }
+    parked_frames_.push_back(parked_frame);
+}
+
+/**
+ * @brief function to drop the parked pictures; the holds of a destroyed decoder session went with it
+ */
+void RocVideoDecoder::ClearParkedFrames() {
+    for (auto &parked_frame : parked_frames_) {
+        if (parked_frame.hold_id && roc_decoder_) {
+            rocDecStatus rocdec_status = rocDecReleaseVideoFrame(roc_decoder_, parked_frame.hold_id);
+            if (rocdec_status != ROCDEC_SUCCESS) std::cerr << "ERROR: rocDecReleaseVideoFrame failed! (" << rocDecGetErrorName(rocdec_status) << ")" << std::endl;
+        }
+    }
+    parked_frames_.clear();
+}
+
+bool RocVideoDecoder::IsOutputFull() {
+    if (out_mem_type_ == OUT_SURFACE_MEM_NOT_MAPPED) {
+        return false;
+    }
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL && vp_frames_q_.Full()) {
+        return true;
+    }
+    return max_output_depth_ && num_output_frames_ >= max_output_depth_;
+}
+
+/**
+ * @brief function to account for a frame returned by the application and wake up a DecodeFrame() waiting for room
+ */
+void RocVideoDecoder::ReturnOutputFrame() {
+    num_output_frames_--;
+    if (block_when_full_) {
+        // pairs with the predicate check of the waiter, so that the notification can't fall between its check and its wait
+        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+    }
+    output_space_cv_.notify_one();
+    if (output_space_callback_) {
+        output_space_callback_();
+    }
+}
+
+void RocVideoDecoder::SetMaxOutputDepth(uint32_t max_output_depth, bool block_when_full) {
+    std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+    max_output_depth_ = max_output_depth;
+    block_when_full_ = block_when_full;
+    output_space_cv_.notify_all();
+}
+
+void RocVideoDecoder::SetOutputSpaceCallback(std::function<void()> output_space_callback) {
+    output_space_callback_ = std::move(output_space_callback);
 }
 
 int RocVideoDecoder::GetSEIMessage(RocdecSeiMessageInfo *pSEIMessageInfo) {
@@ -761,10 +936,13 @@ int RocVideoDecoder::GetSEIMessage(RocdecSeiMessageInfo *pSEIMessageInfo) {
     if (sei_num_mesages) {
       RocdecSeiMessage *p_sei_msg_info = pSEIMessageInfo->sei_message;
       size_t total_SEI_buff_size = 0;
-      if ((pSEIMessageInfo->picIdx < 0) || (pSEIMessageInfo->picIdx >= MAX_FRAME_NUM)) {
+      if (pSEIMessageInfo->picIdx < 0) {
           ERR("Invalid picture index for SEI message: " + TOSTR(pSEIMessageInfo->picIdx));
           return 0;
       }
+      if (pSEIMessageInfo->picIdx >= static_cast<int>(sei_message_display_q_.size())) {
+          ResizePictureInfo(pSEIMessageInfo->picIdx + 1);
+      }
       for (uint32_t i = 0; i < sei_num_mesages; i++) {
           total_SEI_buff_size += p_sei_msg_info[i].sei_message_size;
       }
@@ -791,9 +969,45 @@ int RocVideoDecoder::GetSEIMessage(RocdecSeiMessageInfo *pSEIMessageInfo) {
     return 1;
 }
 
+void RocVideoDecoder::ProcessDecodeCompletions() {
+    // the decoder collects the status of finished pictures in the background, so drain them in batches instead of
+    // querying the status of every displayed picture
+    const uint32_t max_completions = 16;
+    RocdecDecodeCompletion completions[max_completions];
+    uint32_t num_completions = 0;
+    do {
+        if (rocDecGetDecodeCompletions(roc_decoder_, completions, max_completions, &num_completions) != ROCDEC_SUCCESS) {
+            return;
+        }
+        for (uint32_t i = 0; i < num_completions; i++) {
+            if (completions[i].decode_status == rocDecodeStatus_Error || completions[i].decode_status == rocDecodeStatus_Error_Concealed) {
+                std::cerr << "Decode Error occurred for picture: " << decode_poc_base_ + static_cast<int>(completions[i].decode_order) << std::endl;
+            }
+        }
+    } while (num_completions == max_completions);
+}
 
 int RocVideoDecoder::DecodeFrame(const uint8_t *data, size_t size, int pkt_flags, int64_t pts) {
     decoded_frame_cnt_ = 0, decoded_frame_cnt_ret_ = 0;
+    {
+        std::unique_lock<std::mutex> lock(mtx_vp_frame_);
+        // the frames left in vp_frames_ by the previous call are overwritten from now on
+        num_output_frames_ -= num_slot_frames_;
+        num_slot_frames_ = 0;
+        if (max_output_depth_ && out_mem_type_ != OUT_SURFACE_MEM_NOT_MAPPED && num_output_frames_ >= max_output_depth_) {
+            if (!block_when_full_) {
+                return ROCDEC_DECODE_WOULD_BLOCK;
+            }
+            output_space_cv_.wait(lock, [&] { return num_output_frames_ < max_output_depth_ || !max_output_depth_; });
+        }
+    }
+    if (!parked_frames_.empty()) {
+        DeliverParkedFrames();
+        // a flush is held back until the pictures parked before it are handed out
+        if ((!data || size == 0) && !parked_frames_.empty()) {
+            return decoded_frame_cnt_;
+        }
+    }
     RocdecSourceDataPacket packet = { 0 };
     packet.payload = data;
     packet.payload_size = size;
@@ -809,21 +1023,240 @@ int RocVideoDecoder::DecodeFrame(const uint8_t *data, size_t size, int pkt_flags
 
 uint8_t* RocVideoDecoder::GetFrame(int64_t *pts) {
     if (decoded_frame_cnt_ > 0) {
-        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
         decoded_frame_cnt_--;
-        if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL && !vp_frames_q_.empty()) {
-            DecFrameBuffer *fb = &vp_frames_q_.front();
+        if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+            // lock-free with the display callback: the ring has a single producer and a single consumer
+            DecFrameBuffer *fb = vp_frames_q_.Front();
+            if (!fb) return nullptr;
+            if (pts) *pts = fb->pts;
+            return fb->frame_ptr;
+        }
+        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+        if (vp_frames_.size() > 0){
+            DecFrameBuffer *fb = &vp_frames_[decoded_frame_cnt_ret_++];
+            HIP_API_CALL(hipEventSynchronize(fb->copy_done_event));
             if (pts) *pts = fb->pts;
             return fb->frame_ptr;
-        } else if (vp_frames_.size() > 0){
-            if (pts) *pts = vp_frames_[decoded_frame_cnt_ret_].pts;
-            return vp_frames_[decoded_frame_cnt_ret_++].frame_ptr;
         }
     }
     return nullptr;
 }
 
+DecodedFrame RocVideoDecoder::GetFrameHandle() {
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        // the frames refused while the budget was used up stay in vp_frames_q_, so they are taken from there rather than
+        // counted by decoded_frame_cnt_, which only covers the last DecodeFrame() call
+        if (num_held_frames_ >= GetFrameHandleBudget()) return DecodedFrame();
+        if (frame_ready_callback_) {
+            // the frames are handed out once their surface is decoded, independently of the DecodeFrame() call that output them
+            if (!IsFrameReady()) return DecodedFrame();
+            num_frames_popped_++;
+        }
+        if (decoded_frame_cnt_ > 0) decoded_frame_cnt_--;
+        return HoldQueuedFrame();
+    }
+    if (decoded_frame_cnt_ > 0) {
+        decoded_frame_cnt_--;
+        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+        if (decoded_frame_cnt_ret_ < vp_frames_.size()) {
+            // the buffer leaves vp_frames_ with the handle, the next frame landing in this slot gets another one
+            DecFrameBuffer &slot = vp_frames_[decoded_frame_cnt_ret_++];
+            HIP_API_CALL(hipEventSynchronize(slot.copy_done_event));
+            DecFrameBuffer fb = slot;
+            slot.frame_ptr = nullptr;
+            slot.copy_done_event = nullptr;
+            num_slot_frames_--;
+            return DecodedFrame(this, fb, 0, output_generation_);
+        }
+    }
+    return DecodedFrame();
+}
+
+/**
+ * @brief function to hand out the frame at the front of vp_frames_q_ as a handle, which keeps its surface out of the decode
+ *        pool instead of the in-order ReleaseFrame()
+ *
+ * @return DecodedFrame - empty if no frame is queued
+ */
+DecodedFrame RocVideoDecoder::HoldQueuedFrame() {
+    DecFrameBuffer fb;
+    if (!vp_frames_q_.Pop(&fb)) return DecodedFrame();
+    uint64_t hold_id = 0;
+    ROCDEC_API_CALL(rocDecHoldVideoFrame(roc_decoder_, fb.picture_index, &hold_id));
+    num_held_frames_++;
+    return DecodedFrame(this, fb, hold_id, decoder_generation_);
+}
 
+DecodedFrame& DecodedFrame::operator=(DecodedFrame &&other) noexcept {
+    if (this != &other) {
+        Reset();
+        decoder_ = other.decoder_;
+        frame_ = other.frame_;
+        hold_id_ = other.hold_id_;
+        generation_ = other.generation_;
+        other.decoder_ = nullptr;
+    }
+    return *this;
+}
+
+void DecodedFrame::Reset() noexcept {
+    if (decoder_) {
+        decoder_->ReleaseFrameHandle(*this);
+        decoder_ = nullptr;
+    }
+}
+
+void RocVideoDecoder::SetFrameReadyCallback(std::function<void()> frame_ready_callback) {
+    if (frame_ready_callback && out_mem_type_ != OUT_SURFACE_MEM_DEV_INTERNAL) {
+        THROW("SetFrameReadyCallback() requires OUT_SURFACE_MEM_DEV_INTERNAL");
+    }
+    frame_ready_callback_ = std::move(frame_ready_callback);
+}
+
+bool RocVideoDecoder::IsFrameReady() {
+    // rocDecGetVideoFrameAsync() signals the frames in the order they were requested, which is the order of vp_frames_q_
+    return num_frames_ready_ > num_frames_popped_ && vp_frames_q_.Front() != nullptr;
+}
+
+void ROCDECAPI RocVideoDecoder::FrameReadyCallback(void *user_data, int pic_idx, rocDecStatus status) {
+    RocVideoDecoder *viddec = static_cast<RocVideoDecoder *>(user_data);
+    if (status != ROCDEC_SUCCESS) {
+        std::cerr << "ERROR: the decode of picture idx " << pic_idx << " failed to complete (" << rocDecGetErrorName(status) << ")" << std::endl;
+    }
+    viddec->num_frames_ready_++;
+    viddec->frame_ready_callback_();
+}
+
+/**
+ * @brief function to submit a picture, waiting for the release of a DecodedFrame handle while its surface is held
+ *
+ * @param pPicParams - picture to decode
+ * @return rocDecStatus of rocDecDecodeFrame()
+ */
+rocDecStatus RocVideoDecoder::DecodePicture(RocdecPicParams *pPicParams) {
+    rocDecStatus rocdec_status = rocDecDecodeFrame(roc_decoder_, pPicParams);
+    while (rocdec_status == ROCDEC_SURFACE_BUSY) {
+        // the decoder refuses the surface of a frame still held by a handle, or of a parked picture the full output ring
+        // couldn't take; both wait for the consumer threads, which only run beside a blocking DecodeFrame() for the ring
+        size_t num_forced = 0;
+        for (size_t i = 0; i < parked_frames_.size(); i++) {
+            if (parked_frames_[i].disp_info.picture_index == pPicParams->curr_pic_idx) {
+                num_forced = i + 1;
+                break;
+            }
+        }
+        if (num_forced && block_when_full_) {
+            {
+                std::unique_lock<std::mutex> lock(mtx_vp_frame_);
+                output_space_cv_.wait(lock, [&] { return !vp_frames_q_.Full(); });
+            }
+            DeliverParkedFrames(num_forced);
+        } else if (!num_forced && num_held_frames_ > 0) {
+            uint32_t num_held_frames = num_held_frames_;
+            std::unique_lock<std::mutex> lock(mtx_vp_frame_);
+            output_space_cv_.wait(lock, [&] { return num_held_frames_ < num_held_frames; });
+        } else {
+            break;
+        }
+        rocdec_status = rocDecDecodeFrame(roc_decoder_, pPicParams);
+    }
+    return rocdec_status;
+}
+
+/**
+ * @brief function to end the ownership of a DecodedFrame: releases the hold of the surface or returns the buffer to free_frames_
+ *
+ * @param frame - handle being reset
+ */
+void RocVideoDecoder::ReleaseFrameHandle(DecodedFrame &frame) {
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        // the holds of a destroyed decoder session went with it. The session is not replaced while the hold is released:
+        // the handles may be released from other threads than the one decoding
+        {
+            std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+            if (frame.generation_ == decoder_generation_ && roc_decoder_) {
+                rocDecStatus rocdec_status = rocDecReleaseVideoFrame(roc_decoder_, frame.hold_id_);
+                if (rocdec_status != ROCDEC_SUCCESS) std::cerr << "ERROR: rocDecReleaseVideoFrame failed! (" << rocDecGetErrorName(rocdec_status) << ")" << std::endl;
+            }
+        }
+        {
+            // pairs with the predicate check of DecodePicture(), so that the notification can't fall between its check and its wait
+            std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+            num_held_frames_--;
+        }
+        ReturnOutputFrame();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mtx_vp_frame_);
+    if (frame.generation_ == output_generation_) {
+        free_frames_.push_back(frame.frame_);
+    } else {
+        // the frame size changed while the handle was held
+        FreeOutputFrame(frame.frame_);
+    }
+    lock.unlock();
+    ReturnOutputFrame();
+}
+
+/**
+ * @brief function to get a frame buffer for the copied output modes, from free_frames_ or newly allocated; called with mtx_vp_frame_ held
+ *
+ * @return DecFrameBuffer - buffer of GetFrameSize() bytes with its copy_done_event
+ */
+DecFrameBuffer RocVideoDecoder::AllocateOutputFrame() {
+    if (!free_frames_.empty()) {
+        DecFrameBuffer dec_frame = free_frames_.back();
+        free_frames_.pop_back();
+        return dec_frame;
+    }
+    num_alloced_frames_++;
+    DecFrameBuffer dec_frame = { 0 };
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_COPIED) {
+        // allocate device memory
+        HIP_API_CALL(hipMalloc((void **)&dec_frame.frame_ptr, GetFrameSize()));
+    } else {
+        dec_frame.frame_ptr = host_frame_pool_.Acquire(GetFrameSize());
+    }
+    HIP_API_CALL(hipEventCreateWithFlags(&dec_frame.copy_done_event, hipEventDisableTiming));
+    return dec_frame;
+}
+
+/**
+ * @brief function to free a frame buffer of the copied output modes and its copy_done_event
+ *
+ * @param frame - buffer to free
+ */
+void RocVideoDecoder::FreeOutputFrame(DecFrameBuffer &frame) {
+    if (frame.copy_done_event) {
+        hipError_t hip_status = hipEventDestroy(frame.copy_done_event);
+        if (hip_status != hipSuccess) std::cerr << "ERROR: hipEventDestroy failed! (" << hip_status << ")" << std::endl;
+    }
+    if (frame.frame_ptr) {
+        if (out_mem_type_ == OUT_SURFACE_MEM_DEV_COPIED) {
+            hipError_t hip_status = hipFree(frame.frame_ptr);
+            if (hip_status != hipSuccess) std::cerr << "ERROR: hipFree failed! (" << hip_status << ")" << std::endl;
+        }
+        else
+            host_frame_pool_.Recycle(frame.frame_ptr);
+    }
+}
+
+/**
+ * @brief function to wait for the copies out of the surface of pic_idx that are still in flight: Only used with the copied output modes
+ *
+ * @param pic_idx - picture index about to be decoded into
+ */
+void RocVideoDecoder::WaitForFrameCopies(int pic_idx) {
+    if (out_mem_type_ != OUT_SURFACE_MEM_DEV_COPIED && out_mem_type_ != OUT_SURFACE_MEM_HOST_COPIED) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+    for (auto &frame : vp_frames_) {
+        if (frame.picture_index == pic_idx && frame.copy_done_event) {
+            HIP_API_CALL(hipEventSynchronize(frame.copy_done_event));
+        }
+    }
+}
 
 /**
  * @brief function to release frame after use by the application: Only used with "OUT_SURFACE_MEM_DEV_INTERNAL"
@@ -849,22 +1282,99 @@ bool RocVideoDecoder::ReleaseFrame(int64_t pTimestamp, bool b_flushing) {
         }
     }
     // only needed when using internal mapped buffer
-    if (!vp_frames_q_.empty()) {
-        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
-        DecFrameBuffer *fb = &vp_frames_q_.front();
-        void *mapped_frame_ptr = fb->frame_ptr;
-
+    DecFrameBuffer *fb = vp_frames_q_.Front();
+    if (fb) {
         if (pTimestamp != fb->pts) {
             std::cerr << "Decoded Frame is released out of order" << std::endl;
             return false;
         }
         // pop decoded frame
-        vp_frames_q_.pop();
+        vp_frames_q_.Pop();
+        ReturnOutputFrame();
     }
     return true;
 }
 
 
+/**
+ * @brief function to drop the decoded frames of the current stream: releases the internal frames or frees the copied frame buffers
+ */
+void RocVideoDecoder::ReleaseOutputFrames() {
+    ClearParkedFrames();
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        ReleaseInternalFrames();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_vp_frame_);
+    // the frame copies may still read from the mapped surfaces and write into the frames
+    if (!vp_frames_.empty()) {
+        hipError_t hip_status = hipStreamSynchronize(hip_stream_);
+        if (hip_status != hipSuccess) std::cerr << "ERROR: hipStreamSynchronize failed! (" << hip_status << ")" << std::endl;
+    }
+    num_output_frames_ -= num_slot_frames_;
+    num_slot_frames_ = 0;
+    while (!vp_frames_.empty()) {
+        FreeOutputFrame(vp_frames_.back());
+        // pop decoded frame
+        vp_frames_.pop_back();
+    }
+    for (auto &frame : free_frames_) {
+        FreeOutputFrame(frame);
+    }
+    free_frames_.clear();
+    // the buffers still held by DecodedFrame handles are freed on their release
+    output_generation_++;
+}
+
+/**
+ * @brief function to re-arm the decoder for a new stream without recreating the HIP stream, the parser or the decoder session
+ *
+ * @param codec - codec of the new stream
+ */
+void RocVideoDecoder::Reset(rocDecVideoCodec codec) {
+    // flush whatever the parser still holds of the previous stream; the flushed frames are dropped below
+    RocdecSourceDataPacket packet = { 0 };
+    packet.flags = ROCDEC_PKT_ENDOFSTREAM;
+    ROCDEC_API_CALL(rocDecParseVideoData(rocdec_parser_, &packet));
+    if (roc_decoder_) {
+        std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+        ROCDEC_API_CALL(rocDecResetDecoder(roc_decoder_));
+    }
+    if (out_mem_type_ == OUT_SURFACE_MEM_DEV_INTERNAL) {
+        ReleaseInternalFrames();
+    }
+    ClearParkedFrames();
+    // the copied frame buffers are kept and reused by the next stream as long as the frame size doesn't change
+    decoded_frame_cnt_ = 0, decoded_frame_cnt_ret_ = 0;
+    decode_poc_ = decode_poc_base_ = 0;
+    num_frames_flushed_during_reconfig_ = 0;
+    is_decoder_reconfigured_ = false;
+    if (b_extract_sei_message_) {
+        for (auto &sei_message_info : sei_message_display_q_) {
+            free(sei_message_info.sei_data);
+            free(sei_message_info.sei_message);
+            sei_message_info = {};
+        }
+    }
+    ResetSaveFrameToFile();
+
+    if (codec != codec_id_) {
+        // both the parser and the decoder session are codec specific; the session is created again from the new sequence header
+        ROCDEC_API_CALL(rocDecDestroyVideoParser(rocdec_parser_));
+        rocdec_parser_ = nullptr;
+        if (roc_decoder_) {
+            std::lock_guard<std::mutex> lock(mtx_decoder_session_);
+            ROCDEC_API_CALL(rocDecDestroyDecoder(roc_decoder_));
+            roc_decoder_ = nullptr;
+        }
+        ReleaseOutputFrames();
+        coded_width_ = coded_height_ = 0;
+        codec_id_ = codec;
+        CreateParser();
+    }
+    is_reset_pending_ = true;
+}
+
 /**
  * @brief function to release all internal frames and clear the q (used with reconfigure): Only used with "OUT_SURFACE_MEM_DEV_INTERNAL"
  * 
@@ -874,11 +1384,10 @@ bool RocVideoDecoder::ReleaseFrame(int64_t pTimestamp, bool b_flushing) {
 bool RocVideoDecoder::ReleaseInternalFrames() {
     if (out_mem_type_ != OUT_SURFACE_MEM_DEV_INTERNAL || out_mem_type_ == OUT_SURFACE_MEM_NOT_MAPPED)
         return true;            // nothing to do
-    // only needed when using internal mapped buffer
-    while (!vp_frames_q_.empty()) {
-        std::lock_guard<std::mutex> lock(mtx_vp_frame_);
-        // pop decoded frame
-        vp_frames_q_.pop();
+    // only needed when using internal mapped buffer; called on the submitting thread while the consumer is idle
+    while (vp_frames_q_.Pop()) {
+        num_frames_popped_++;
+        ReturnOutputFrame();
     }
     return true;
 }
@@ -1105,6 +1614,114 @@ void RocVideoDecoder::GetDeviceinfo(std::string &device_name, std::string &gcn_a
 }
 
 
+/**
+ * @brief function to set how the pinned host frames of OUT_SURFACE_MEM_HOST_COPIED are allocated
+ *
+ * @param write_combined - use write-combined memory
+ * @param numa_local - place the frames on the NUMA node of the GPU
+ */
+void RocVideoDecoder::SetHostFrameOptions(bool write_combined, bool numa_local) {
+    int numa_node = -1;
+    if (numa_local) {
+        char pci_dev_path[64];
+        snprintf(pci_dev_path, sizeof(pci_dev_path), "/sys/bus/pci/devices/%04x:%02x:%02x.0/numa_node", hip_dev_prop_.pciDomainID,
+            hip_dev_prop_.pciBusID, hip_dev_prop_.pciDeviceID);
+        std::ifstream numa_node_file(pci_dev_path);
+        if (!(numa_node_file >> numa_node)) {
+            numa_node = -1;
+        }
+        if (numa_node < 0) {
+            std::cerr << "WARNING: the NUMA node of the GPU is unknown, host frames use the default placement" << std::endl;
+        }
+    }
+    host_frame_pool_.SetOptions(write_combined, numa_node);
+}
+
+/**
+ * @brief function to get a pinned host buffer of at least size bytes, reusing a free one if it fits
+ *
+ * @param size - size of the buffer in bytes
+ * @return uint8_t* - the pinned host buffer
+ */
+uint8_t* PinnedHostFramePool::Acquire(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto best_fit = free_buffers_.end();
+    for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+        size_t buffer_size = buffers_[*it];
+        if (buffer_size >= size && (best_fit == free_buffers_.end() || buffer_size < buffers_[*best_fit])) {
+            best_fit = it;
+        }
+    }
+    if (best_fit != free_buffers_.end()) {
+        uint8_t *ptr = *best_fit;
+        free_buffers_.erase(best_fit);
+        return ptr;
+    }
+    // the free buffers are all too small: they are left from a smaller sequence and won't be used again
+    for (auto ptr : free_buffers_) {
+        Free(ptr);
+        buffers_.erase(ptr);
+    }
+    free_buffers_.clear();
+
+    uint8_t *ptr = nullptr;
+    unsigned int host_malloc_flags = is_write_combined_ ? hipHostMallocWriteCombined : hipHostMallocDefault;
+    if (numa_node_ >= 0 && numa_node_ < 64) {
+        // with hipHostMallocNumaUser, hipHostMalloc follows the NUMA policy of the calling thread, which prefers the node
+        // of the GPU for the duration of the allocation. The write-combined flag applies as without the placement.
+        int prev_mode = MPOL_DEFAULT;
+        unsigned long prev_node_mask = 0;
+        bool is_policy_saved = syscall(SYS_get_mempolicy, &prev_mode, &prev_node_mask, sizeof(prev_node_mask) * 8, nullptr, 0) == 0;
+        unsigned long node_mask = 1UL << numa_node_;
+        if (!is_policy_saved || syscall(SYS_set_mempolicy, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8) != 0) {
+            std::cerr << "WARNING: setting the NUMA policy failed, the host frame is not placed on NUMA node " << numa_node_ << std::endl;
+            is_policy_saved = false;
+        }
+        hipError_t hip_status = hipHostMalloc((void **)&ptr, size, host_malloc_flags | hipHostMallocNumaUser);
+        if (is_policy_saved) {
+            syscall(SYS_set_mempolicy, prev_mode, prev_mode == MPOL_DEFAULT ? nullptr : &prev_node_mask, sizeof(prev_node_mask) * 8);
+        }
+        if (hip_status != hipSuccess) {
+            THROW("hipHostMalloc failed with " + STR(hipGetErrorName(hip_status)));
+        }
+    } else {
+        HIP_API_CALL(hipHostMalloc((void **)&ptr, size, host_malloc_flags));
+    }
+    buffers_[ptr] = size;
+    return ptr;
+}
+
+/**
+ * @brief function to return a buffer to the pool for reuse
+ *
+ * @param ptr - buffer returned by Acquire()
+ */
+void PinnedHostFramePool::Recycle(uint8_t *ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffers_.find(ptr) != buffers_.end()) {
+        free_buffers_.push_back(ptr);
+    }
+}
+
+/**
+ * @brief function to free all the buffers of the pool, including the ones still in use
+ */
+void PinnedHostFramePool::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &buffer : buffers_) {
+        Free(buffer.first);
+    }
+    buffers_.clear();
+    free_buffers_.clear();
+}
+
+void PinnedHostFramePool::Free(uint8_t *ptr) {
+    hipError_t hip_status = hipHostFree(ptr);
+    if (hip_status != hipSuccess) {
+        std::cerr << "ERROR: freeing a pinned host frame failed! (" << hip_status << ")" << std::endl;
+    }
+}
+
 bool RocVideoDecoder::GetOutputSurfaceInfo(OutputSurfaceInfo **surface_info) {
     if (!disp_width_ || !disp_height_) {
         std::cerr << "ERROR: RocVideoDecoder is not intialized" << std::endl;
@@ -31,9 +31,14 @@ THE SOFTWARE.
 #include <sstream>
 #include <string.h>
 #include <queue>
+#include <deque>
+#include <condition_variable>
+#include <unordered_map>
 #include <stdexcept>
 #include <exception>
 #include <cstring>
+#include <atomic>
+#include <functional>
 #include <hip/hip_runtime.h>
 extern "C" {
 #include "libavutil/md5.h"
@@ -41,6 +46,7 @@ extern "C" {
 }
 #include "rocdecode.h"
 #include "rocparser.h"
+#include "roc_video_dec_ring.h"
 
 /*!
  * \file
@@ -50,7 +56,8 @@ extern "C" {
  * \brief AMD The rocDecode video decoder for AMD’s GPUs.
  */
 
-#define MAX_FRAME_NUM     16
+#define ROCDEC_DECODE_WOULD_BLOCK   (-100) /**< returned by DecodeFrame() when the output depth is reached without blocking, apart from the rocDecStatus codes */
+#define DEFAULT_FRAME_HANDLE_BUDGET 4      /**< surfaces held by DecodedFrame handles with OUT_SURFACE_MEM_DEV_INTERNAL without an output depth */
 typedef int (ROCDECAPI *PFNRECONFIGUEFLUSHCALLBACK)(void *, uint32_t, void *);
 
 typedef enum SeiAvcHevcPayloadType_enum {
@@ -136,8 +143,14 @@ typedef struct DecFrameBuffer_ {
     uint8_t *frame_ptr;       /**< device memory pointer for the decoded frame */
     int64_t  pts;             /**<  timestamp for the decoded frame */
     int picture_index;         /**<  surface index for the decoded frame */
+    hipEvent_t copy_done_event; /**<  recorded after the copy into frame_ptr with the copied output modes, waited on in GetFrame */
 } DecFrameBuffer;
 
+typedef struct ParkedFrame_ {
+    RocdecParserDispInfo disp_info; /**<  displayed picture waiting to be handed out */
+    uint64_t hold_id;               /**<  rocDecHoldVideoFrame() id keeping its surface from being decoded into with OUT_SURFACE_MEM_DEV_INTERNAL, 0 if none */
+} ParkedFrame;
+
 
 typedef struct OutputSurfaceInfoType {
     uint32_t output_width;               /**< Output width of decoded surface*/
@@ -152,6 +165,73 @@ typedef struct OutputSurfaceInfoType {
     OutputSurfaceMemoryType mem_type;             /**< Output mem_type of the surface*/    
 } OutputSurfaceInfo;
 
+/**
+ * @brief Pool of pinned host frame buffers for OUT_SURFACE_MEM_HOST_COPIED, recycled across frames, sequences and reconfigures.
+ * Pageable destinations make hipMemcpy2DAsync go through a staging buffer at a fraction of the PCIe bandwidth.
+ */
+class PinnedHostFramePool {
+    public:
+        PinnedHostFramePool() = default;
+        ~PinnedHostFramePool() { Clear(); }
+        /**
+         * @brief sets how the buffers allocated from now on are pinned
+         *
+         * @param write_combined - write-combined buffers are faster to copy into but slow to read from the CPU
+         * @param numa_node - NUMA node to place the buffers on, -1 for the default placement. Applies together with write_combined
+         */
+        void SetOptions(bool write_combined, int numa_node) { is_write_combined_ = write_combined; numa_node_ = numa_node; }
+        uint8_t* Acquire(size_t size);
+        void Recycle(uint8_t *ptr);
+        void Clear();
+    private:
+        void Free(uint8_t *ptr);
+        std::unordered_map<uint8_t *, size_t> buffers_; // size of every buffer of the pool, in use or free
+        std::vector<uint8_t *> free_buffers_;
+        bool is_write_combined_ = false;
+        int numa_node_ = -1;
+        std::mutex mutex_;
+};
+
+class RocVideoDecoder;
+
+/**
+ * @brief Move-only handle of a decoded frame returned by RocVideoDecoder::GetFrameHandle(). The frame stays valid until the
+ * handle is destroyed or reset, independently of the other handles and of later DecodeFrame() calls, so handles can be
+ * released in any order and from any thread. With OUT_SURFACE_MEM_DEV_INTERNAL the handle holds the decoder surface with
+ * rocDecHoldVideoFrame(). The surface pool is sized with room for the handles of the frame handle budget, see
+ * RocVideoDecoder::GetFrameHandle(). With the copied output modes the handle owns the frame buffer, which goes back to the
+ * decoder on release. Handles must be released before their
+ * RocVideoDecoder is destroyed.
+ */
+class DecodedFrame {
+    public:
+        DecodedFrame() = default;
+        DecodedFrame(DecodedFrame &&other) noexcept { *this = std::move(other); }
+        DecodedFrame& operator=(DecodedFrame &&other) noexcept;
+        DecodedFrame(const DecodedFrame &) = delete;
+        DecodedFrame& operator=(const DecodedFrame &) = delete;
+        ~DecodedFrame() { Reset(); }
+        /**
+         * @brief returns the frame in the layout of RocVideoDecoder::GetFrame()
+         */
+        uint8_t* GetData() const { return frame_.frame_ptr; }
+        int64_t GetPts() const { return frame_.pts; }
+        int GetPictureIndex() const { return frame_.picture_index; }
+        explicit operator bool() const { return decoder_ != nullptr; }
+        /**
+         * @brief releases the frame back to the decoder, the handle is empty afterwards
+         */
+        void Reset() noexcept;
+    private:
+        friend class RocVideoDecoder;
+        DecodedFrame(RocVideoDecoder *decoder, const DecFrameBuffer &frame, uint64_t hold_id, uint32_t generation)
+            : decoder_(decoder), frame_(frame), hold_id_(hold_id), generation_(generation) {}
+        RocVideoDecoder *decoder_ = nullptr;
+        DecFrameBuffer frame_ = {};
+        uint64_t hold_id_ = 0; // frame id of the surface hold with OUT_SURFACE_MEM_DEV_INTERNAL
+        uint32_t generation_ = 0; // decoder session or output buffer generation the frame belongs to
+};
+
 typedef struct ReconfigParams_t {
     PFNRECONFIGUEFLUSHCALLBACK p_fn_reconfigure_flush;
     void *p_reconfig_user_struct;
@@ -276,6 +356,27 @@ class RocVideoDecoder {
          * @return int - num of frames to display
          */
         int DecodeFrame(const uint8_t *data, size_t size, int pkt_flags, int64_t pts = 0);
+
+        /**
+         * @brief sets the maximum number of decoded frames handed out and not returned yet: the frames queued with
+         * OUT_SURFACE_MEM_DEV_INTERNAL until ReleaseFrame(), the frames of the copied output modes until the next DecodeFrame(),
+         * and the frames of DecodedFrame handles until their release. When the depth is reached, DecodeFrame() doesn't take
+         * the packet: it waits for the consumer thread to return a frame, or returns ROCDEC_DECODE_WOULD_BLOCK so the packet
+         * can be resubmitted later. The frames displayed by one packet beyond the depth, like the burst of an end of stream
+         * flush, stay in their surfaces and are handed out by the next DecodeFrame() calls; after the end of stream, call
+         * DecodeFrame() with an empty packet until it returns 0.
+         *
+         * @param max_output_depth - 0 for no limit (default)
+         * @param block_when_full - true to wait for the consumer, which then has to run on another thread
+         */
+        void SetMaxOutputDepth(uint32_t max_output_depth, bool block_when_full = true);
+
+        /**
+         * @brief sets a function called each time a frame counted by SetMaxOutputDepth() is returned, from the thread returning it.
+         * Lets an event loop resubmit a packet refused with ROCDEC_DECODE_WOULD_BLOCK instead of polling; set it before the
+         * first DecodeFrame().
+         */
+        void SetOutputSpaceCallback(std::function<void()> output_space_callback);
         /**
          * @brief This function returns a decoded frame and timestamp. This should be called in a loop fetching all the available frames
          * 
@@ -292,6 +393,39 @@ class RocVideoDecoder {
          */
         bool ReleaseFrame(int64_t pTimestamp, bool b_flushing = false);
 
+        /**
+         * @brief This function returns the next decoded frame as a DecodedFrame handle, or an empty handle when none is left.
+         * Unlike GetFrame()/ReleaseFrame() the frames can be kept and released in any order, without ReleaseFrame().
+         * Don't mix both ways of fetching the frames of a DecodeFrame() call.
+         * With OUT_SURFACE_MEM_DEV_INTERNAL each handle holds a decode surface. The handles held at the same time are bounded by
+         * a budget, the output depth of SetMaxOutputDepth() or DEFAULT_FRAME_HANDLE_BUDGET without one, for which surfaces are
+         * added to the pool when the decoder session is created; set the output depth before the first DecodeFrame(). Once the
+         * budget is used up an empty handle is returned and the frame stays queued for a call after a handle is released, so
+         * a slow consumer holds back the output instead of the decode of a picture into a held surface. Should the parser
+         * still pick the surface of a held frame, DecodeFrame() waits for a handle to be released, so handles kept across
+         * DecodeFrame() calls must be released by other threads.
+         */
+        DecodedFrame GetFrameHandle();
+
+        /**
+         * @brief Makes the frames of OUT_SURFACE_MEM_DEV_INTERNAL complete asynchronously: the display callback maps the surfaces
+         * with rocDecGetVideoFrameAsync() instead of waiting for their decode, and GetFrameHandle() returns a frame only once its
+         * surface is decoded, regardless of the DecodeFrame() call that output it. frame_ready_callback is invoked from an
+         * internal thread of the decoder each time a frame becomes ready; it must not call back into the decoder. Set it before
+         * the first DecodeFrame() and fetch the frames with GetFrameHandle() only.
+         */
+        void SetFrameReadyCallback(std::function<void()> frame_ready_callback);
+
+        /**
+         * @brief returns true when GetFrameHandle() has a frame ready, with SetFrameReadyCallback()
+         */
+        bool IsFrameReady();
+
+        /**
+         * @brief returns the number of frames output by the decoder and not handed out yet with OUT_SURFACE_MEM_DEV_INTERNAL
+         */
+        size_t GetNumPendingFrames() { return vp_frames_q_.Size(); }
+
         /**
          * @brief utility function to save image to a file
          * 
@@ -356,6 +490,32 @@ class RocVideoDecoder {
          */
         int32_t GetNumOfFlushedFrames() { return num_frames_flushed_during_reconfig_;}
 
+        /**
+         * @brief Flush and re-arm the decoder for a new stream. The HIP stream, the parser and the decoder session are kept, so starting
+         *        the next file costs a fraction of constructing a new RocVideoDecoder. The parser and the decoder session are recreated if the codec changes,
+         *        and the decoder session is recreated once the new sequence header shows a different chroma format or bit depth.
+         *        Frames of the previous stream that were not retrieved are dropped and the output file is closed.
+         *
+         * @param codec - codec of the new stream
+         */
+        void Reset(rocDecVideoCodec codec);
+
+        /**
+         * @brief Opts the decoder into the deadline scheduling of the picture submissions across the decoders of the device.
+         *        Takes effect when the decoder is created, i.e. it has to be called before the first frame is decoded.
+         *
+         * @param priority_class - rocDecPriorityClass_Realtime for latency sensitive streams, rocDecPriorityClass_Batch otherwise
+         */
+        void SetPriorityClass(rocDecPriorityClass priority_class) { is_deadline_scheduled_ = true; priority_class_ = priority_class; }
+
+        /**
+         * @brief sets how the pinned host frames of OUT_SURFACE_MEM_HOST_COPIED are allocated, applies to the frames allocated afterwards
+         *
+         * @param write_combined - use write-combined memory, only for consumers that don't read the frames back with the CPU
+         * @param numa_local - place the frames on the NUMA node of the GPU, combines with write_combined
+         */
+        void SetHostFrameOptions(bool write_combined, bool numa_local);
+
     private:
         int decoder_session_id_; // Decoder session identifier. Used to gather session level stats.
         /**
@@ -395,11 +555,78 @@ class RocVideoDecoder {
              internal buffer
         */
         int HandlePictureDisplay(RocdecParserDispInfo *p_disp_info);
+
+        /**
+         *   @brief  This function maps or copies a displayed picture and hands it out to the application
+         *   @return false if the output frame ring of OUT_SURFACE_MEM_DEV_INTERNAL is full and the picture was not handed out
+         */
+        bool DeliverFrame(RocdecParserDispInfo *p_disp_info);
+
+        /**
+         *   @brief  This function hands out the pictures parked beyond max_output_depth_, at least num_forced of them
+         */
+        void DeliverParkedFrames(size_t num_forced = 0);
+
+        /**
+         *   @brief  This function parks a displayed picture beyond max_output_depth_ in its surface
+         */
+        void ParkFrame(RocdecParserDispInfo *p_disp_info);
+
+        /**
+         *   @brief  This function drops the parked pictures and ends the holds of their surfaces
+         */
+        void ClearParkedFrames();
+
+        /**
+         *   @brief  This function sizes the per-picture bookkeeping (SEI messages, decode order) to the decode surface count
+         */
+        void ResizePictureInfo(uint32_t num_surfaces);
+
+        /**
+         *   @brief  This function returns true when max_output_depth_ frames are handed out and not returned yet
+         */
+        bool IsOutputFull();
+
+        /**
+         *   @brief  This function accounts for a frame returned by the application and wakes up a DecodeFrame() waiting for room
+         */
+        void ReturnOutputFrame();
+
+        /**
+         *   @brief  This function submits a picture to the decoder, waiting for the consumer while its surface is held by a DecodedFrame
+         *   handle or by a parked picture the full output frame ring can't take
+         */
+        rocDecStatus DecodePicture(RocdecPicParams *pPicParams);
+
+        /**
+         *   @brief  This function returns the number of surfaces DecodedFrame handles may hold with OUT_SURFACE_MEM_DEV_INTERNAL
+         */
+        uint32_t GetFrameHandleBudget() { return max_output_depth_ ? max_output_depth_ : DEFAULT_FRAME_HANDLE_BUDGET; }
+
+        /**
+         *   @brief  This function hands out the next queued frame of OUT_SURFACE_MEM_DEV_INTERNAL as a handle holding its surface
+         */
+        DecodedFrame HoldQueuedFrame();
+
+        /**
+         *   @brief  Callback of rocDecGetVideoFrameAsync() with SetFrameReadyCallback()
+         */
+        static void ROCDECAPI FrameReadyCallback(void *user_data, int pic_idx, rocDecStatus status);
         /**
          *   @brief  This function gets called when all unregistered user SEI messages are parsed for a frame
          */
         int GetSEIMessage(RocdecSeiMessageInfo *p_sei_message_info);
 
+        /**
+         *   @brief  This function drains the decoder's completion queue in batches and reports the pictures that failed to decode
+         */
+        void ProcessDecodeCompletions();
+
+        /**
+         *   @brief  This function waits for the copies out of the surface of pic_idx that are still in flight, before it is decoded into again
+         */
+        void WaitForFrameCopies(int pic_idx);
+
         /**
          *   @brief  This function reconfigure decoder if there is a change in sequence params.
          */
@@ -413,6 +640,24 @@ class RocVideoDecoder {
          */
         bool ReleaseInternalFrames();
 
+        /**
+         * @brief function to drop the decoded frames of the current stream (used with reconfigure and Reset)
+         */
+        void ReleaseOutputFrames();
+
+        /**
+         * @brief functions to manage the frame buffers of the copied output modes and the frames of DecodedFrame handles
+         */
+        DecFrameBuffer AllocateOutputFrame();
+        void FreeOutputFrame(DecFrameBuffer &frame);
+        void ReleaseFrameHandle(DecodedFrame &frame);
+        friend class DecodedFrame;
+
+        /**
+         * @brief function to create the video parser for codec_id_
+         */
+        void CreateParser();
+
         /**
          * @brief Function to Initialize GPU-HIP
          * 
@@ -434,9 +679,12 @@ class RocVideoDecoder {
         rocDecVideoChromaFormat video_chroma_format_ = rocDecVideoChromaFormat_420;
         rocDecVideoSurfaceFormat video_surface_format_ = rocDecVideoSurfaceFormat_NV12;
         RocdecSeiMessageInfo *curr_sei_message_ptr_ = nullptr;
-        RocdecSeiMessageInfo sei_message_display_q_[MAX_FRAME_NUM];
-        int decoded_frame_cnt_ = 0, decoded_frame_cnt_ret_ = 0;
-        int decode_poc_ = 0, pic_num_in_dec_order_[MAX_FRAME_NUM];
+        std::vector<RocdecSeiMessageInfo> sei_message_display_q_;   // indexed by picture_index, sized to the decode surfaces
+        std::atomic<int> decoded_frame_cnt_ = 0;
+        int decoded_frame_cnt_ret_ = 0;
+        int decode_poc_ = 0;
+        int decode_poc_base_ = 0;   // decode_poc_ of the first picture of the decoder session, see ProcessDecodeCompletions()
+        std::vector<int> pic_num_in_dec_order_;   // indexed by picture_index, sized to the decode surfaces
         int num_alloced_frames_ = 0;
         std::ostringstream input_video_info_str_;
         int bitdepth_minus_8_ = 0;
@@ -457,7 +705,23 @@ class RocVideoDecoder {
         OutputSurfaceInfo output_surface_info_ = {};
         std::mutex mtx_vp_frame_;
         std::vector<DecFrameBuffer> vp_frames_;      // vector of decoded frames
-        std::queue<DecFrameBuffer> vp_frames_q_;
+        SpscRing<DecFrameBuffer> vp_frames_q_;      // decoded frames with OUT_SURFACE_MEM_DEV_INTERNAL, from the display callback to GetFrame()
+        PinnedHostFramePool host_frame_pool_;
+        std::vector<DecFrameBuffer> free_frames_;   // frame buffers returned by DecodedFrame handles, reused before allocating
+        uint32_t output_generation_ = 0;   // bumped when the frame buffers are freed, the buffers of older handles are freed on release
+        std::atomic<uint32_t> decoder_generation_ = 0;   // bumped when the decoder session is created, the holds of older handles died with their session
+        std::mutex mtx_decoder_session_;   // held while roc_decoder_ is created, reconfigured, reset or destroyed, which must not overlap with the release of a DecodedFrame hold
+        uint32_t max_output_depth_ = 0;   // 0: no limit on the frames handed out
+        bool block_when_full_ = true;
+        std::atomic<uint32_t> num_output_frames_ = 0;   // frames handed out and not returned yet
+        std::atomic<uint32_t> num_held_frames_ = 0;   // DecodedFrame handles holding a surface with OUT_SURFACE_MEM_DEV_INTERNAL
+        uint32_t num_slot_frames_ = 0;   // frames of the copied output modes in vp_frames_, returned by the next DecodeFrame()
+        std::condition_variable output_space_cv_;   // signaled when the consumer returns a frame
+        std::function<void()> output_space_callback_;   // set by SetOutputSpaceCallback()
+        std::deque<ParkedFrame> parked_frames_;   // displayed pictures beyond max_output_depth_, still in their surfaces
+        std::function<void()> frame_ready_callback_;   // set by SetFrameReadyCallback(), enables the asynchronous frame completion
+        std::atomic<uint64_t> num_frames_ready_ = 0;   // frames signalled ready by rocDecGetVideoFrameAsync()
+        std::atomic<uint64_t> num_frames_popped_ = 0;   // frames popped from vp_frames_q_ with the asynchronous frame completion
         Rect disp_rect_ = {}; // displayable area specified in the bitstream
         Rect crop_rect_ = {}; // user specified region of interest within diplayable area disp_rect_
         FILE *fp_sei_ = NULL;
@@ -465,6 +729,10 @@ class RocVideoDecoder {
         struct AVMD5 *md5_ctx_;
         uint8_t md5_digest_[16];
         bool is_decoder_reconfigured_ = false;
+        bool is_reset_pending_ = false; // set by Reset() until the sequence header of the new stream arrives
+        uint32_t clk_rate_ = 1000;
+        bool is_deadline_scheduled_ = false;
+        rocDecPriorityClass priority_class_ = rocDecPriorityClass_Realtime;
         std::string current_output_filename = "";
         uint32_t extra_output_file_count_ = 0;
 };
\ No newline at end of file
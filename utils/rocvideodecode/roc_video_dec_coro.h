@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "roc_video_dec.h"
+
+/**
+ * @brief Fixed set of worker threads resuming the coroutines posted to it. The decode coroutines of any number of
+ *        AsyncRocVideoDecoder sessions share the workers instead of keeping a blocked thread each.
+ */
+class DecodeExecutor {
+    public:
+        explicit DecodeExecutor(uint32_t num_threads = 1) {
+            if (!num_threads) num_threads = 1;
+            for (uint32_t i = 0; i < num_threads; i++) {
+                workers_.emplace_back(&DecodeExecutor::WorkerThreadFunc, this);
+            }
+        }
+
+        /**
+         * @brief stops the workers; the coroutines still queued are not resumed
+         */
+        ~DecodeExecutor() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            for (auto &worker : workers_) {
+                worker.join();
+            }
+        }
+
+        DecodeExecutor(const DecodeExecutor &) = delete;
+        DecodeExecutor &operator=(const DecodeExecutor &) = delete;
+
+        void Post(std::coroutine_handle<> handle) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(handle);
+            }
+            cv_.notify_one();
+        }
+
+        /**
+         * @brief awaitable moving the calling coroutine to a worker thread
+         */
+        auto Schedule() {
+            struct ScheduleAwaiter {
+                DecodeExecutor *executor;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { executor->Post(handle); }
+                void await_resume() const noexcept {}
+            };
+            return ScheduleAwaiter{this};
+        }
+
+    private:
+        void WorkerThreadFunc() {
+            while (true) {
+                std::coroutine_handle<> handle;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [&] { return stop_ || !ready_.empty(); });
+                    if (stop_) return;
+                    handle = ready_.front();
+                    ready_.pop_front();
+                }
+                handle.resume();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::coroutine_handle<>> ready_;
+        bool stop_ = false;
+        std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Return type of the decode coroutines. The coroutine starts right away on the calling thread and runs to completion
+ *        on its own; Wait() blocks until it has finished and rethrows the exception that ended it, if any.
+ */
+class DecodeTask {
+    public:
+        struct State {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool is_done = false;
+            std::exception_ptr exception;
+        };
+
+        struct promise_type {
+            std::shared_ptr<State> state = std::make_shared<State>();
+
+            DecodeTask get_return_object() { return DecodeTask(state); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            // signals the completion once the locals of the coroutine are destroyed; the frame is freed right after
+            auto final_suspend() noexcept {
+                struct FinalAwaiter {
+                    std::shared_ptr<State> state;
+                    bool await_ready() noexcept {
+                        {
+                            std::lock_guard<std::mutex> lock(state->mutex);
+                            state->is_done = true;
+                        }
+                        state->cv.notify_all();
+                        return true;
+                    }
+                    void await_suspend(std::coroutine_handle<>) noexcept {}
+                    void await_resume() noexcept {}
+                };
+                return FinalAwaiter{state};
+            }
+            void return_void() {}
+            void unhandled_exception() { state->exception = std::current_exception(); }
+        };
+
+        void Wait() {
+            std::unique_lock<std::mutex> lock(state_->mutex);
+            state_->cv.wait(lock, [&] { return state_->is_done; });
+            if (state_->exception) std::rethrow_exception(state_->exception);
+        }
+
+        bool IsDone() {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->is_done;
+        }
+
+    private:
+        explicit DecodeTask(std::shared_ptr<State> state) : state_(std::move(state)) {}
+        std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Awaitable front end of a RocVideoDecoder in OUT_SURFACE_MEM_DEV_INTERNAL mode. Submit() runs DecodeFrame() on a
+ *        worker of the DecodeExecutor, and NextFrame() suspends the coroutine until the next frame has been decoded instead of
+ *        waiting for it in the display callback: the decoder is switched to SetFrameReadyCallback() and the frame-ready
+ *        signal of rocDecGetVideoFrameAsync() resumes the waiting coroutine. One coroutine drives a session at a time, e.g.
+ *
+ *            DecodeTask Decode(AsyncRocVideoDecoder &session, DecodeExecutor &executor) {
+ *                co_await executor.Schedule();
+ *                while (demuxer.Demux(&data, &size, &pts)) {
+ *                    int n = co_await session.Submit(data, size, pts);
+ *                    while (DecodedFrame frame = co_await session.NextFrame()) { ... }
+ *                }
+ *                int n;
+ *                do {
+ *                    n = co_await session.Submit(nullptr, 0);
+ *                    while (DecodedFrame frame = co_await session.NextFrame()) { ... }
+ *                } while (n > 0);
+ *            }
+ *
+ *        Submit() returns ROCDEC_DECODE_WOULD_BLOCK with a non-blocking SetMaxOutputDepth(): drain the frames and submit the
+ *        packet again. DecodeFrame() itself still blocks its worker while the decoder waits for a free surface or for output
+ *        space in blocking mode, so give the executor at least as many workers as sessions expected to block at once.
+ */
+class AsyncRocVideoDecoder {
+    public:
+        AsyncRocVideoDecoder(RocVideoDecoder &decoder, DecodeExecutor &executor) : decoder_(decoder),
+            waiter_(std::make_shared<Waiter>()) {
+            waiter_->executor = &executor;
+            // the callback runs on the sync thread of the decoder, it only hands the waiting coroutine over to the executor
+            std::shared_ptr<Waiter> waiter = waiter_;
+            decoder_.SetFrameReadyCallback([waiter] {
+                std::coroutine_handle<> handle;
+                DecodeExecutor *executor = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(waiter->mutex);
+                    handle = std::exchange(waiter->handle, nullptr);
+                    executor = waiter->executor;
+                }
+                if (handle && executor) executor->Post(handle);
+            });
+        }
+
+        ~AsyncRocVideoDecoder() {
+            std::lock_guard<std::mutex> lock(waiter_->mutex);
+            waiter_->executor = nullptr;
+            waiter_->handle = nullptr;
+        }
+
+        AsyncRocVideoDecoder(const AsyncRocVideoDecoder &) = delete;
+        AsyncRocVideoDecoder &operator=(const AsyncRocVideoDecoder &) = delete;
+
+        /**
+         * @brief awaitable submitting a packet to RocVideoDecoder::DecodeFrame() from a worker of the executor; resumes with its
+         *        return value. A null data or a zero size ends the stream.
+         */
+        auto Submit(const uint8_t *data, size_t size, int64_t pts = 0, int pkt_flags = 0) {
+            struct SubmitAwaiter {
+                AsyncRocVideoDecoder *session;
+                const uint8_t *data;
+                size_t size;
+                int64_t pts;
+                int pkt_flags;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { session->GetExecutor()->Post(handle); }
+                int await_resume() { return session->decoder_.DecodeFrame(data, size, pkt_flags, pts); }
+            };
+            return SubmitAwaiter{this, data, size, pts, pkt_flags};
+        }
+
+        /**
+         * @brief awaitable resuming with the next frame in display order once it is decoded, or with an empty handle when the
+         *        decoder has no frame pending; submit more packets then
+         */
+        auto NextFrame() {
+            struct NextFrameAwaiter {
+                AsyncRocVideoDecoder *session;
+                bool await_ready() { return session->decoder_.IsFrameReady() || !session->decoder_.GetNumPendingFrames(); }
+                bool await_suspend(std::coroutine_handle<> handle) {
+                    std::lock_guard<std::mutex> lock(session->waiter_->mutex);
+                    // the frame-ready callback counts the frame before it takes the waiter, so checking again under the lock
+                    // does not miss a frame completing in between
+                    if (session->decoder_.IsFrameReady()) return false;
+                    session->waiter_->handle = handle;
+                    return true;
+                }
+                DecodedFrame await_resume() { return session->decoder_.GetFrameHandle(); }
+            };
+            return NextFrameAwaiter{this};
+        }
+
+        RocVideoDecoder &GetDecoder() { return decoder_; }
+
+    private:
+        struct Waiter {
+            std::mutex mutex;
+            std::coroutine_handle<> handle;   // coroutine suspended in NextFrame()
+            DecodeExecutor *executor = nullptr;
+        };
+
+        DecodeExecutor *GetExecutor() {
+            std::lock_guard<std::mutex> lock(waiter_->mutex);
+            return waiter_->executor;
+        }
+
+        RocVideoDecoder &decoder_;
+        std::shared_ptr<Waiter> waiter_;   // shared with the frame-ready callback, which may outlive the session
+};
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,284 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "roc_video_dec.h"
+#include "roc_video_dec_pipeline.h"
+#include "roc_video_dec_segment.h"
+
+/**
+ * @brief Creates the decoder of a session of RocVideoDecoderParallel on device_id, for example
+ *        [&](int device_id) { return std::make_unique<RocVideoDecoder>(device_id, mem_type, codec); }
+ */
+typedef std::function<std::unique_ptr<RocVideoDecoder>(int device_id)> ParallelDecoderFactory;
+
+/**
+ * @brief Decodes a single stream with several RocVideoDecoder sessions, so one long file can use all the VCN instances of a
+ *        device and several devices. A reader thread cuts the stream into segments of at least min_segment_packets packets
+ *        that start at a random access point closing the GOP before it, as found by StreamSegmenter. The segments are handed
+ *        round robin to the sessions, which decode them independently, flushing the decoder at the end of each, and
+ *        GetFrame() re-emits the frames segment after segment, i.e. in the presentation order of the stream.
+ *
+ *        Streams of other codecs, or without any such random access point, are decoded as a single segment. The parameter
+ *        sets of AVC and HEVC seen so far are repeated in front of a segment that doesn't carry its own.
+ *        Each session buffers up to max_buffered_frames frames ahead of the segment being emitted, the decode of the
+ *        sessions further ahead stalls until GetFrame() reaches them.
+ */
+class RocVideoDecoderParallel {
+    public:
+        /**
+         * @param num_sessions - decoder sessions, typically the number of VCN instances of the devices used
+         * @param placement_info - stream description used to spread the sessions over the devices with rocDecAcquireDevice()
+         * @param decoder_factory - creates the decoder of each session on the device picked for it
+         * @param min_segment_packets - packets per segment before it's cut at the next random access point
+         * @param max_buffered_frames - decoded frames each session keeps ahead of GetFrame()
+         */
+        RocVideoDecoderParallel(uint32_t num_sessions, const RocdecDevicePlacementInfo &placement_info, ParallelDecoderFactory decoder_factory,
+                                uint32_t min_segment_packets = 120, uint32_t max_buffered_frames = 8) :
+                                placement_info_(placement_info), min_segment_packets_(std::max(min_segment_packets, 1u)),
+                                segmenter_(placement_info.codec_type), frame_queue_(num_sessions, max_buffered_frames) {
+            try {
+                for (uint32_t i = 0; i < frame_queue_.GetNumSessions(); i++) {
+                    auto session = std::make_unique<Session>(i);
+                    ROCDEC_API_CALL(rocDecAcquireDevice(&placement_info_, &session->device_id));
+                    session->is_device_acquired = true;
+                    sessions_.push_back(std::move(session));
+                    sessions_.back()->decoder = decoder_factory(sessions_.back()->device_id);
+                    if (!sessions_.back()->decoder) {
+                        THROW("RocVideoDecoderParallel: the decoder factory returned no decoder");
+                    }
+                    // replaces an output space callback set on the decoder before
+                    std::shared_ptr<OutputSpaceSignal> output_space = sessions_.back()->output_space;
+                    sessions_.back()->decoder->SetOutputSpaceCallback([output_space] { output_space->Notify(); });
+                }
+            } catch (...) {
+                // the destructor doesn't run for a partly constructed object
+                ReleaseSessions();
+                throw;
+            }
+        }
+
+        ~RocVideoDecoderParallel() {
+            Stop();
+            ReleaseSessions();
+        }
+
+        RocVideoDecoderParallel(const RocVideoDecoderParallel &) = delete;
+        RocVideoDecoderParallel &operator=(const RocVideoDecoderParallel &) = delete;
+
+        /**
+         * @brief starts decoding a new stream of the codec of placement_info
+         */
+        void Start(PipelinePacketSource packet_source) {
+            Stop();
+            packet_source_ = std::move(packet_source);
+            segmenter_.Reset();
+            stage_error_ = nullptr;
+            stop_ = false;
+            frame_queue_.Reset();
+            for (auto &session : sessions_) {
+                session->segment_queue.Reset();
+                if (has_started_) {
+                    // a stopped stream may have left pictures in the decoder
+                    session->decoder->Reset(placement_info_.codec_type);
+                }
+            }
+            has_started_ = true;
+            for (auto &session : sessions_) {
+                session->thread = std::thread(&RocVideoDecoderParallel::SessionThreadFunc, this, session.get());
+            }
+            reader_thread_ = std::thread(&RocVideoDecoderParallel::ReaderThreadFunc, this);
+        }
+
+        /**
+         * @brief returns the next frame of the stream, waiting for it if needed. An empty handle is returned at the end of the
+         *        stream; an exception raised by the reader or a session is rethrown here.
+         */
+        DecodedFrame GetFrame() {
+            DecodedFrame frame;
+            if (!frame_queue_.Pop(frame)) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (stage_error_) {
+                    std::rethrow_exception(stage_error_);
+                }
+            }
+            return frame;
+        }
+
+        /**
+         * @brief stops the reader and the sessions and drops the segments and frames still queued. The frames held by the
+         *        application have to be released first when they can block the decode, i.e. with OUT_SURFACE_MEM_DEV_INTERNAL.
+         */
+        void Stop() {
+            stop_ = true;
+            CloseQueues();
+            // the queued frames may be what the sessions wait for in DecodeFrame()
+            frame_queue_.Clear();
+            for (auto &session : sessions_) {
+                session->output_space->Notify();
+            }
+            if (reader_thread_.joinable()) reader_thread_.join();
+            for (auto &session : sessions_) {
+                if (session->thread.joinable()) session->thread.join();
+                session->segment_queue.Clear();
+            }
+            frame_queue_.Clear();
+        }
+
+    private:
+        typedef std::vector<PipelinePacket> Segment;
+
+        struct Session {
+            explicit Session(uint32_t session_index) : index(session_index), segment_queue(1),
+                output_space(std::make_shared<OutputSpaceSignal>()) {}
+            uint32_t index;   // segments index, index + num_sessions, ... of the stream
+            int device_id = 0;
+            bool is_device_acquired = false;
+            std::unique_ptr<RocVideoDecoder> decoder;
+            BoundedQueue<Segment> segment_queue;
+            std::shared_ptr<OutputSpaceSignal> output_space;   // frames released by the application, see DecodePacket()
+            std::thread thread;
+        };
+
+        void ReleaseSessions() {
+            for (auto &session : sessions_) {
+                session->decoder.reset();
+                if (session->is_device_acquired) {
+                    rocDecReleaseDevice(&placement_info_, session->device_id);
+                    session->is_device_acquired = false;
+                }
+            }
+        }
+
+        void ReaderThreadFunc() {
+            try {
+                uint8_t *data = nullptr;
+                int size = 0;
+                int64_t pts = 0;
+                size_t num_segments = 0;
+                Segment segment;
+                while (!stop_ && packet_source_(&data, &size, &pts) && size > 0) {
+                    bool is_random_access_point = segmenter_.ScanPacket(data, size);
+                    if (is_random_access_point && segment.size() >= min_segment_packets_) {
+                        if (!sessions_[num_segments++ % sessions_.size()]->segment_queue.Push(std::move(segment))) return;
+                        segment = Segment();
+                    }
+                    PipelinePacket packet;
+                    if (segment.empty() && num_segments && !segmenter_.HasParameterSets(data, size)) {
+                        for (auto &parameter_set : segmenter_.GetParameterSets()) {
+                            packet.data.insert(packet.data.end(), parameter_set.begin(), parameter_set.end());
+                        }
+                    }
+                    packet.data.insert(packet.data.end(), data, data + size);
+                    packet.pts = pts;
+                    segment.push_back(std::move(packet));
+                }
+                if (!segment.empty() && !stop_) {
+                    sessions_[num_segments % sessions_.size()]->segment_queue.Push(std::move(segment));
+                }
+                for (auto &session : sessions_) {
+                    session->segment_queue.Close();
+                }
+            } catch (...) {
+                SetStageError(std::current_exception());
+            }
+        }
+
+        void SessionThreadFunc(Session *session) {
+            try {
+                Segment segment;
+                while (session->segment_queue.Pop(segment)) {
+                    for (auto &packet : segment) {
+                        if (DecodePacket(session, packet.data.data(), packet.data.size(), packet.pts) < 0) return;
+                    }
+                    // flush the decoder, the next segment of the session starts a new GOP further in the stream
+                    // the end of stream is repeated until the frames parked beyond the output depth are handed out
+                    int num_frames;
+                    do {
+                        num_frames = DecodePacket(session, nullptr, 0, 0);
+                    } while (num_frames > 0 && !stop_);
+                    if (num_frames < 0) return;
+                    if (!frame_queue_.EndSegment(session->index)) return;
+                }
+            } catch (...) {
+                SetStageError(std::current_exception());
+            }
+            frame_queue_.CloseSession(session->index);
+        }
+
+        /**
+         * @brief submits a packet to the decoder of a session and queues the frames it outputs. Returns the number of frames
+         *        output, or -1 once the decode is stopped.
+         */
+        int DecodePacket(Session *session, const uint8_t *data, size_t size, int64_t pts) {
+            int num_frames;
+            while (true) {
+                // read before DecodeFrame(), so a frame released in between wakes the wait below
+                uint64_t output_space_count = session->output_space->GetCount();
+                num_frames = session->decoder->DecodeFrame(data, size, 0, pts);
+                if (num_frames != ROCDEC_DECODE_WOULD_BLOCK) break;
+                // a non-blocking output depth is set on the decoder, wait for the application to release frames
+                if (stop_) return -1;
+                session->output_space->Wait(output_space_count, stop_);
+            }
+            for (DecodedFrame frame = session->decoder->GetFrameHandle(); frame; frame = session->decoder->GetFrameHandle()) {
+                if (!frame_queue_.Push(session->index, std::move(frame))) return -1;
+            }
+            return num_frames;
+        }
+
+        void SetStageError(std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!stage_error_) stage_error_ = error;
+            }
+            CloseQueues();
+        }
+
+        void CloseQueues() {
+            for (auto &session : sessions_) {
+                session->segment_queue.Close();
+            }
+            frame_queue_.Close();
+        }
+
+        RocdecDevicePlacementInfo placement_info_;
+        uint32_t min_segment_packets_;
+        StreamSegmenter segmenter_;   // used by the reader
+        SegmentedFrameQueue<DecodedFrame> frame_queue_;
+        std::vector<std::unique_ptr<Session>> sessions_;
+        PipelinePacketSource packet_source_;
+        bool has_started_ = false;
+        std::thread reader_thread_;
+        std::atomic<bool> stop_ = false;
+        std::mutex error_mutex_;
+        std::exception_ptr stage_error_;
+};
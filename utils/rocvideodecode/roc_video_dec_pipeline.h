@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "roc_video_dec.h"
+#include "roc_video_dec_queue.h"
+
+/**
+ * @brief Counts the frames returned by the application through RocVideoDecoder::SetOutputSpaceCallback(), so a stage refused
+ *        with ROCDEC_DECODE_WOULD_BLOCK sleeps until a frame comes back. It is shared with the callback, which may still be
+ *        called by a frame released after the pipeline is gone.
+ */
+class OutputSpaceSignal {
+    public:
+        uint64_t GetCount() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return count_;
+        }
+
+        void Notify() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                count_++;
+            }
+            cv_.notify_all();
+        }
+
+        /**
+         * @brief waits until a frame is returned after GetCount() returned count, or until stop is set and Notify() is called
+         */
+        void Wait(uint64_t count, const std::atomic<bool> &stop) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return count_ != count || stop; });
+        }
+
+    private:
+        uint64_t count_ = 0;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+};
+
+/**
+ * @brief Packet handed from the reader stage to the parser stage of RocVideoDecoderPipeline, an empty packet ends the stream
+ */
+typedef struct PipelinePacket_t {
+    std::vector<uint8_t> data;
+    int64_t pts;
+} PipelinePacket;
+
+/**
+ * @brief Source of the reader stage: returns the next packet in data, size and pts, false at the end of the stream. The data only
+ *        has to stay valid until the next call, for example
+ *        [&demuxer](uint8_t **data, int *size, int64_t *pts) { return demuxer.Demux(data, size, pts); }
+ */
+typedef std::function<bool(uint8_t **data, int *size, int64_t *pts)> PipelinePacketSource;
+
+/**
+ * @brief Runs a RocVideoDecoder as a pipeline of a reader stage, which pulls the packets from a PipelinePacketSource, a parser
+ *        stage, which parses and submits them and collects the decoded frames, and an output stage, from which the application
+ *        pops the frames in display order. The stages are connected by bounded queues, so demuxing, parsing, VCN decoding and
+ *        the consumption of the frames overlap, and a slow consumer holds back the decode rather than growing the queues.
+ *        While the pipeline runs, the decoder is only used by it; the frames are DecodedFrame handles, released by the
+ *        application in any order.
+ */
+class RocVideoDecoderPipeline {
+    public:
+        /**
+         * @param decoder - decoder run by the pipeline, it must outlive the pipeline
+         * @param packet_queue_depth - packets read ahead of the parser stage
+         * @param frame_queue_depth - decoded frames waiting for the application
+         */
+        RocVideoDecoderPipeline(RocVideoDecoder &decoder, size_t packet_queue_depth = 8, size_t frame_queue_depth = 4) :
+                                decoder_(decoder), packet_queue_(packet_queue_depth), frame_queue_(frame_queue_depth),
+                                output_space_(std::make_shared<OutputSpaceSignal>()) {
+            // replaces an output space callback set on the decoder before
+            std::shared_ptr<OutputSpaceSignal> output_space = output_space_;
+            decoder_.SetOutputSpaceCallback([output_space] { output_space->Notify(); });
+        }
+        ~RocVideoDecoderPipeline() { Stop(); }
+
+        /**
+         * @brief starts the reader and parser stages on a new stream
+         */
+        void Start(PipelinePacketSource packet_source) {
+            Stop();
+            packet_source_ = std::move(packet_source);
+            packet_queue_.Reset();
+            frame_queue_.Reset();
+            stage_error_ = nullptr;
+            stop_ = false;
+            reader_thread_ = std::thread(&RocVideoDecoderPipeline::ReaderThreadFunc, this);
+            parser_thread_ = std::thread(&RocVideoDecoderPipeline::ParserThreadFunc, this);
+        }
+
+        /**
+         * @brief returns the next decoded frame in display order, waiting for it if needed. An empty handle is returned at the
+         *        end of the stream; an exception raised by a stage is rethrown here once the frames before it are popped.
+         */
+        DecodedFrame GetFrame() {
+            DecodedFrame frame;
+            if (!frame_queue_.Pop(frame)) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (stage_error_) {
+                    std::rethrow_exception(stage_error_);
+                }
+            }
+            return frame;
+        }
+
+        /**
+         * @brief stops the stages and drops the packets and frames still queued; GetFrame() returns empty handles afterwards.
+         *        The frames held by the application have to be released first when they can block the decode, i.e. with
+         *        OUT_SURFACE_MEM_DEV_INTERNAL or a blocking output depth.
+         */
+        void Stop() {
+            stop_ = true;
+            output_space_->Notify();
+            packet_queue_.Close();
+            frame_queue_.Close();
+            // the queued frames may be what the parser stage waits for in DecodeFrame()
+            frame_queue_.Clear();
+            if (reader_thread_.joinable()) reader_thread_.join();
+            if (parser_thread_.joinable()) parser_thread_.join();
+            packet_queue_.Clear();
+            frame_queue_.Clear();
+        }
+
+    private:
+        void ReaderThreadFunc() {
+            try {
+                uint8_t *data = nullptr;
+                int size = 0;
+                int64_t pts = 0;
+                bool is_end_of_stream = false;
+                while (!is_end_of_stream && !stop_) {
+                    PipelinePacket packet = {AcquirePacketBuffer(), 0};
+                    is_end_of_stream = !packet_source_(&data, &size, &pts) || size <= 0;
+                    if (!is_end_of_stream) {
+                        packet.data.assign(data, data + size);
+                        packet.pts = pts;
+                    }
+                    if (!packet_queue_.Push(std::move(packet))) break;
+                }
+            } catch (...) {
+                SetStageError(std::current_exception());
+            }
+        }
+
+        void ParserThreadFunc() {
+            try {
+                PipelinePacket packet;
+                while (packet_queue_.Pop(packet)) {
+                    bool is_end_of_stream = packet.data.empty();
+                    int num_frames = 0;
+                    do {
+                        // taken before the call, so a frame returned while the packet is refused isn't missed
+                        uint64_t output_space_count = output_space_->GetCount();
+                        num_frames = decoder_.DecodeFrame(is_end_of_stream ? nullptr : packet.data.data(), packet.data.size(), 0, packet.pts);
+                        if (num_frames == ROCDEC_DECODE_WOULD_BLOCK) {
+                            // a non-blocking output depth is set on the decoder, wait for the application to release a frame
+                            output_space_->Wait(output_space_count, stop_);
+                            continue;
+                        }
+                        for (DecodedFrame frame = decoder_.GetFrameHandle(); frame; frame = decoder_.GetFrameHandle()) {
+                            if (!frame_queue_.Push(std::move(frame))) return;
+                        }
+                        // the end of stream is repeated until the frames parked beyond the output depth are handed out
+                    } while (!stop_ && (num_frames == ROCDEC_DECODE_WOULD_BLOCK || (is_end_of_stream && num_frames > 0)));
+                    RecyclePacketBuffer(std::move(packet.data));
+                    if (is_end_of_stream) break;
+                }
+            } catch (...) {
+                SetStageError(std::current_exception());
+            }
+            frame_queue_.Close();
+        }
+
+        void SetStageError(std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!stage_error_) stage_error_ = error;
+            }
+            packet_queue_.Close();
+            frame_queue_.Close();
+        }
+
+        // the packet buffers go back to the reader stage instead of being reallocated for each packet
+        std::vector<uint8_t> AcquirePacketBuffer() {
+            std::lock_guard<std::mutex> lock(buffer_mutex_);
+            if (spare_buffers_.empty()) return std::vector<uint8_t>();
+            std::vector<uint8_t> buffer = std::move(spare_buffers_.back());
+            spare_buffers_.pop_back();
+            buffer.clear();
+            return buffer;
+        }
+
+        void RecyclePacketBuffer(std::vector<uint8_t> &&buffer) {
+            std::lock_guard<std::mutex> lock(buffer_mutex_);
+            spare_buffers_.push_back(std::move(buffer));
+        }
+
+        RocVideoDecoder &decoder_;
+        PipelinePacketSource packet_source_;
+        BoundedQueue<PipelinePacket> packet_queue_;
+        BoundedQueue<DecodedFrame> frame_queue_;
+        std::thread reader_thread_;
+        std::thread parser_thread_;
+        std::atomic<bool> stop_ = false;
+        std::shared_ptr<OutputSpaceSignal> output_space_;
+        std::mutex error_mutex_;
+        std::exception_ptr stage_error_;
+        std::mutex buffer_mutex_;
+        std::vector<std::vector<uint8_t>> spare_buffers_;
+};
@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "roc_video_dec.h"
+
+/**
+ * @brief Key of the decoders kept by RocVideoDecoderPool: the device and codec a decoder was last used with. The bit depth is not
+ *        part of it, since a prewarmed decoder has no decoder session until the first sequence header of its stream.
+ */
+typedef struct RocVideoDecoderPoolKey_t {
+    int device_id;
+    rocDecVideoCodec codec;
+    bool operator<(const RocVideoDecoderPoolKey_t &other) const {
+        return std::tie(device_id, codec) < std::tie(other.device_id, other.codec);
+    }
+} RocVideoDecoderPoolKey;
+
+/**
+ * @brief Pool of warm RocVideoDecoder objects for applications that decode many short streams. A decoder handed back to the pool
+ *        is Reset() and keeps its HIP stream, parser and decoder session, so the next stream of the same codec on the same device
+ *        starts without any of the setup cost. A stream of another bit depth or chroma format replaces the decoder session only. All decoders of a pool share the same output settings.
+ */
+class RocVideoDecoderPool {
+    public:
+        RocVideoDecoderPool(OutputSurfaceMemoryType out_mem_type, bool force_zero_latency = false, const Rect *p_crop_rect = nullptr,
+                            bool extract_user_sei_message = false, int max_width = 0, int max_height = 0, uint32_t clk_rate = 1000) :
+                            out_mem_type_(out_mem_type), b_force_zero_latency_(force_zero_latency), b_extract_sei_message_(extract_user_sei_message),
+                            max_width_(max_width), max_height_(max_height), clk_rate_(clk_rate) {
+            if (p_crop_rect) {
+                crop_rect_ = *p_crop_rect;
+                p_crop_rect_ = &crop_rect_;
+            }
+        }
+
+        /**
+         * @brief Create num_decoders idle decoders for the given device and codec ahead of time
+         */
+        void Prewarm(int device_id, rocDecVideoCodec codec, int num_decoders) {
+            for (int i = 0; i < num_decoders; i++) {
+                std::unique_ptr<RocVideoDecoder> viddec(CreateDecoder(device_id, codec));
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle_decoders_[{device_id, codec}].push_back(std::move(viddec));
+            }
+        }
+
+        /**
+         * @brief Hand out a decoder for a stream of the given codec on device_id. An idle decoder with the same key is preferred;
+         *        otherwise an idle decoder of the same device is reset to the codec, and only when there is none a new decoder is
+         *        created.
+         */
+        std::unique_ptr<RocVideoDecoder> Acquire(int device_id, rocDecVideoCodec codec) {
+            std::unique_ptr<RocVideoDecoder> viddec;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = idle_decoders_.find({device_id, codec});
+                if (it == idle_decoders_.end() || it->second.empty()) {
+                    for (it = idle_decoders_.begin(); it != idle_decoders_.end(); it++) {
+                        if (it->first.device_id == device_id && !it->second.empty()) break;
+                    }
+                }
+                if (it != idle_decoders_.end()) {
+                    viddec = std::move(it->second.back());
+                    it->second.pop_back();
+                }
+            }
+            if (!viddec) {
+                return std::unique_ptr<RocVideoDecoder>(CreateDecoder(device_id, codec));
+            }
+            if (viddec->GetCodecId() != codec) {
+                viddec->Reset(codec);
+            }
+            return viddec;
+        }
+
+        /**
+         * @brief Return a decoder to the pool once the application is done with its stream; the decoder is reset right away so the
+         *        next Acquire() doesn't pay for it
+         */
+        void Release(int device_id, std::unique_ptr<RocVideoDecoder> viddec) {
+            if (!viddec) {
+                return;
+            }
+            rocDecVideoCodec codec = viddec->GetCodecId();
+            viddec->Reset(codec);
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_decoders_[{device_id, codec}].push_back(std::move(viddec));
+        }
+
+        /**
+         * @brief Number of idle decoders currently held by the pool
+         */
+        size_t GetNumIdleDecoders() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t num_idle_decoders = 0;
+            for (auto &entry : idle_decoders_) {
+                num_idle_decoders += entry.second.size();
+            }
+            return num_idle_decoders;
+        }
+
+    private:
+        RocVideoDecoder *CreateDecoder(int device_id, rocDecVideoCodec codec) {
+            return new RocVideoDecoder(device_id, out_mem_type_, codec, b_force_zero_latency_, p_crop_rect_, b_extract_sei_message_,
+                                       max_width_, max_height_, clk_rate_);
+        }
+
+        OutputSurfaceMemoryType out_mem_type_;
+        bool b_force_zero_latency_;
+        bool b_extract_sei_message_;
+        int max_width_, max_height_;
+        uint32_t clk_rate_;
+        Rect crop_rect_ = {};
+        Rect *p_crop_rect_ = nullptr;
+        std::mutex mutex_;
+        std::map<RocVideoDecoderPoolKey, std::vector<std::unique_ptr<RocVideoDecoder>>> idle_decoders_;
+};
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief Blocking FIFO of bounded depth connecting two stages. Close() wakes up both sides: pushes fail from then on, and pops
+ *        drain the remaining items before failing.
+ */
+template <typename T>
+class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t max_depth) : max_depth_(max_depth ? max_depth : 1) {}
+
+        bool Push(T &&item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_cv_.wait(lock, [&] { return is_closed_ || items_.size() < max_depth_; });
+            if (is_closed_) return false;
+            items_.push_back(std::move(item));
+            lock.unlock();
+            not_empty_cv_.notify_one();
+            return true;
+        }
+
+        bool Pop(T &item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_cv_.wait(lock, [&] { return is_closed_ || !items_.empty(); });
+            if (items_.empty()) return false;
+            item = std::move(items_.front());
+            items_.pop_front();
+            lock.unlock();
+            not_full_cv_.notify_one();
+            return true;
+        }
+
+        void Close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_closed_ = true;
+            not_full_cv_.notify_all();
+            not_empty_cv_.notify_all();
+        }
+
+        /**
+         * @brief drops the items
+         */
+        void Clear() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.clear();
+            not_full_cv_.notify_all();
+        }
+
+        /**
+         * @brief drops the items and opens the queue again; only while no stage uses it
+         */
+        void Reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.clear();
+            is_closed_ = false;
+        }
+
+    private:
+        size_t max_depth_;
+        bool is_closed_ = false;
+        std::deque<T> items_;
+        std::mutex mutex_;
+        std::condition_variable not_full_cv_;
+        std::condition_variable not_empty_cv_;
+};
@@ -0,0 +1,327 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "roc_video_dec.h"
+#include "roc_video_dec_pipeline.h"
+
+/**
+ * @brief Output of RocVideoDecoderReactor: a decoded frame of a session, the end of its stream, or the error that stopped it
+ */
+struct ReactorCompletion {
+    uint32_t session_id = 0;
+    DecodedFrame frame;                 // empty for the end of stream and error completions
+    bool is_end_of_stream = false;      // the last frame of the stream of session_id was delivered before
+    std::exception_ptr error;           // set when the session failed; its later packets are dropped
+};
+
+/**
+ * @brief Drives many RocVideoDecoder sessions from a small fixed set of worker threads. Packets are pushed per session and
+ *        each session is scheduled on whichever worker is free, one packet per turn, so its packets are parsed in order and
+ *        by one worker at a time while the sessions share the workers round robin. The decoded frames of all sessions come
+ *        out of one completion channel, GetCompletion(), in display order within each session.
+ *
+ *        A worker never waits for the consumer: AddSession() gives each session a non-blocking SetMaxOutputDepth() of
+ *        max_session_frames, which also bounds the frames waiting in the completion channel to that many per session.
+ *        A packet refused with ROCDEC_DECODE_WOULD_BLOCK parks the session until the consumer releases one of its frames,
+ *        and the worker moves on to the other sessions. DecodeFrame() still waits for a free decode surface and, with
+ *        OUT_SURFACE_MEM_DEV_INTERNAL, for the decode of the frames it outputs.
+ */
+class RocVideoDecoderReactor {
+    public:
+        /**
+         * @param num_threads - worker threads shared by all the sessions
+         * @param max_session_packets - packets queued per session before PushPacket() refuses more
+         * @param max_session_frames - frames of a session delivered and not released yet before the session is parked
+         */
+        explicit RocVideoDecoderReactor(uint32_t num_threads, uint32_t max_session_packets = 16, uint32_t max_session_frames = 8) :
+            max_session_packets_(max_session_packets ? max_session_packets : 1),
+            max_session_frames_(max_session_frames ? max_session_frames : 1) {
+            if (!num_threads) num_threads = 1;
+            for (uint32_t i = 0; i < num_threads; i++) {
+                workers_.emplace_back(&RocVideoDecoderReactor::WorkerThreadFunc, this);
+            }
+        }
+
+        ~RocVideoDecoderReactor() { Stop(); }
+
+        RocVideoDecoderReactor(const RocVideoDecoderReactor &) = delete;
+        RocVideoDecoderReactor &operator=(const RocVideoDecoderReactor &) = delete;
+
+        /**
+         * @brief takes over a decoder and returns the id of its session; sessions can be added while the reactor runs. The output
+         *        depth of the decoder is set to max_session_frames without blocking.
+         */
+        uint32_t AddSession(std::unique_ptr<RocVideoDecoder> decoder) {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            uint32_t session_id = static_cast<uint32_t>(sessions_.size());
+            sessions_.emplace_back(std::make_unique<Session>());
+            Session *session = sessions_.back().get();
+            session->id = session_id;
+            session->decoder = std::move(decoder);
+            session->decoder->SetMaxOutputDepth(max_session_frames_, false);
+            session->decoder->SetOutputSpaceCallback([this, session] { OnOutputSpace(session); });
+            return session_id;
+        }
+
+        RocVideoDecoder &GetDecoder(uint32_t session_id) { return *GetSession(session_id)->decoder; }
+
+        /**
+         * @brief queues a copy of a packet on a session; an empty packet ends its stream, which is acknowledged with an end of
+         *        stream completion once its frames are delivered. When the session already has max_session_packets packets
+         *        queued, waits for one of them to be parsed if wait is true, or returns false without queueing: push the
+         *        packet again later. Also returns false after Stop().
+         */
+        bool PushPacket(uint32_t session_id, const uint8_t *data, size_t size, int64_t pts = 0, bool wait = false) {
+            Session *session = GetSession(session_id);
+            bool schedule = false;
+            {
+                std::unique_lock<std::mutex> lock(session->mutex);
+                if (wait) {
+                    session->space_cv.wait(lock, [&] { return is_closing_ || session->has_failed || session->packets.size() < max_session_packets_; });
+                }
+                if (is_closing_) return false;
+                if (session->has_failed) return true;
+                if (session->packets.size() >= max_session_packets_) return false;
+                PipelinePacket packet;
+                if (!session->free_buffers.empty()) {
+                    packet.data = std::move(session->free_buffers.back());
+                    session->free_buffers.pop_back();
+                }
+                packet.data.assign(data, data + (data ? size : 0));
+                packet.pts = pts;
+                session->packets.push_back(std::move(packet));
+                if (!session->is_scheduled) {
+                    session->is_scheduled = schedule = true;
+                }
+            }
+            if (schedule) Schedule(session);
+            return true;
+        }
+
+        /**
+         * @brief pops the next completion of any session, waiting for one if wait is true. Returns false when there is none
+         *        or after Stop().
+         */
+        bool GetCompletion(ReactorCompletion &completion, bool wait = true) {
+            std::unique_lock<std::mutex> lock(completion_mutex_);
+            if (wait) {
+                completion_cv_.wait(lock, [&] { return is_stopped_ || !completions_.empty(); });
+            }
+            if (completions_.empty()) return false;
+            completion = std::move(completions_.front());
+            completions_.pop_front();
+            return true;
+        }
+
+        /**
+         * @brief stops the workers once their current packets are done, drops the queued packets and completions and wakes the
+         *        producers waiting in PushPacket()
+         */
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(ready_mutex_);
+                if (stop_) return;
+                stop_ = true;
+            }
+            ready_cv_.notify_all();
+            is_closing_ = true;
+            {
+                // wakes the producers waiting in PushPacket(), under their session lock so none misses the flag
+                std::lock_guard<std::mutex> lock(sessions_mutex_);
+                for (auto &session : sessions_) {
+                    std::lock_guard<std::mutex> session_lock(session->mutex);
+                    session->space_cv.notify_all();
+                }
+            }
+            for (auto &worker : workers_) {
+                worker.join();
+            }
+            {
+                std::lock_guard<std::mutex> lock(completion_mutex_);
+                completions_.clear();
+                is_stopped_ = true;
+            }
+            completion_cv_.notify_all();
+        }
+
+    private:
+        struct Session {
+            uint32_t id = 0;
+            std::unique_ptr<RocVideoDecoder> decoder;
+            std::mutex mutex;
+            std::deque<PipelinePacket> packets;   // only the worker running the session pops
+            std::condition_variable space_cv;   // signaled when packets are popped, for PushPacket() with wait
+            std::vector<std::vector<uint8_t>> free_buffers;   // buffers of the parsed packets, reused by PushPacket()
+            bool is_scheduled = false;   // queued in ready_sessions_, run by a worker, or parked on the output depth
+            bool is_output_blocked = false;   // parked until the consumer releases a frame
+            uint64_t num_output_returns = 0;   // frames released by the consumer, to catch a release racing with the park
+            bool has_failed = false;
+        };
+
+        Session *GetSession(uint32_t session_id) {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            if (session_id >= sessions_.size()) {
+                THROW("RocVideoDecoderReactor: invalid session id " + TOSTR(session_id));
+            }
+            return sessions_[session_id].get();
+        }
+
+        void Schedule(Session *session) {
+            {
+                std::lock_guard<std::mutex> lock(ready_mutex_);
+                ready_sessions_.push_back(session);
+            }
+            ready_cv_.notify_one();
+        }
+
+        void Complete(ReactorCompletion &&completion) {
+            {
+                std::lock_guard<std::mutex> lock(completion_mutex_);
+                completions_.push_back(std::move(completion));
+            }
+            completion_cv_.notify_one();
+        }
+
+        void OnOutputSpace(Session *session) {
+            bool schedule = false;
+            {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                session->num_output_returns++;
+                std::swap(schedule, session->is_output_blocked);
+            }
+            if (schedule) Schedule(session);
+        }
+
+        void WorkerThreadFunc() {
+            while (true) {
+                Session *session;
+                {
+                    std::unique_lock<std::mutex> lock(ready_mutex_);
+                    ready_cv_.wait(lock, [&] { return stop_ || !ready_sessions_.empty(); });
+                    if (stop_) return;
+                    session = ready_sessions_.front();
+                    ready_sessions_.pop_front();
+                }
+                RunSession(session);
+            }
+        }
+
+        /**
+         * @brief submits the oldest packet of a session and delivers the frames it outputs, then puts the session back in
+         *        line if it has more packets
+         */
+        void RunSession(Session *session) {
+            PipelinePacket *packet;
+            uint64_t num_output_returns;
+            {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                if (session->packets.empty()) {
+                    session->is_scheduled = false;
+                    return;
+                }
+                // the producers only append, so the front packet stays in place while it's parsed without the lock
+                packet = &session->packets.front();
+                num_output_returns = session->num_output_returns;
+            }
+            bool is_end_of_stream = packet->data.empty();
+            int num_frames;
+            try {
+                num_frames = session->decoder->DecodeFrame(is_end_of_stream ? nullptr : packet->data.data(), packet->data.size(), 0, packet->pts);
+                if (num_frames != ROCDEC_DECODE_WOULD_BLOCK) {
+                    for (DecodedFrame frame = session->decoder->GetFrameHandle(); frame; frame = session->decoder->GetFrameHandle()) {
+                        ReactorCompletion completion;
+                        completion.session_id = session->id;
+                        completion.frame = std::move(frame);
+                        Complete(std::move(completion));
+                    }
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(session->mutex);
+                    session->has_failed = true;
+                    session->packets.clear();
+                    session->is_scheduled = false;
+                }
+                session->space_cv.notify_all();
+                ReactorCompletion completion;
+                completion.session_id = session->id;
+                completion.error = std::current_exception();
+                Complete(std::move(completion));
+                return;
+            }
+            if (num_frames == ROCDEC_DECODE_WOULD_BLOCK) {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                if (session->num_output_returns == num_output_returns) {
+                    // OnOutputSpace() schedules the session again
+                    session->is_output_blocked = true;
+                    return;
+                }
+            } else if (is_end_of_stream && num_frames > 0) {
+                // the flush can output more frames than the output depth, submit the end of stream again until it's drained
+            } else {
+                if (is_end_of_stream) {
+                    ReactorCompletion completion;
+                    completion.session_id = session->id;
+                    completion.is_end_of_stream = true;
+                    Complete(std::move(completion));
+                }
+                bool is_idle;
+                {
+                    std::lock_guard<std::mutex> lock(session->mutex);
+                    session->free_buffers.push_back(std::move(session->packets.front().data));
+                    session->packets.pop_front();
+                    is_idle = session->packets.empty();
+                    if (is_idle) {
+                        session->is_scheduled = false;
+                    }
+                }
+                session->space_cv.notify_one();
+                if (is_idle) return;
+            }
+            Schedule(session);
+        }
+
+        uint32_t max_session_packets_;
+        uint32_t max_session_frames_;
+        std::mutex sessions_mutex_;
+        std::vector<std::unique_ptr<Session>> sessions_;
+        std::mutex ready_mutex_;
+        std::condition_variable ready_cv_;
+        std::deque<Session *> ready_sessions_;   // sessions with packets, waiting for a worker
+        bool stop_ = false;
+        std::atomic<bool> is_closing_ = false;   // stop_ for the producers waiting in PushPacket()
+        std::mutex completion_mutex_;
+        std::condition_variable completion_cv_;
+        std::deque<ReactorCompletion> completions_;
+        bool is_stopped_ = false;   // stop_ for the consumers of the completions
+        std::vector<std::thread> workers_;
+};
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Fixed-capacity lock-free ring for one producer thread and one consumer thread, used for the output frames of
+ *        RocVideoDecoder: the display callback pushes, GetFrame()/ReleaseFrame() peek and pop. The capacity is rounded up to
+ *        a power of two. Each side caches the index of the other one and only reloads it when the ring looks full or
+ *        empty, so a push or a pop normally touches a single shared cache line.
+ */
+template <typename T>
+class SpscRing {
+    public:
+        explicit SpscRing(size_t capacity = 0) { Reset(capacity); }
+        SpscRing(const SpscRing &) = delete;
+        SpscRing& operator=(const SpscRing &) = delete;
+
+        /**
+         * @brief drops the items and resizes the ring; only while neither side uses it
+         */
+        void Reset(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            slots_.reset(new T[size]);
+            mask_ = size - 1;
+            head_.store(0, std::memory_order_relaxed);
+            tail_.store(0, std::memory_order_relaxed);
+            cached_head_ = cached_tail_ = 0;
+        }
+
+        /**
+         * @brief producer: appends item, returns false if the ring is full
+         */
+        bool Push(const T &item) {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cached_head_ > mask_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail - cached_head_ > mask_) return false;
+            }
+            slots_[tail & mask_] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief consumer: returns the oldest item, nullptr if the ring is empty. The item stays valid until Pop().
+         */
+        T* Front() {
+            size_t head = head_.load(std::memory_order_relaxed);
+            if (head == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == cached_tail_) return nullptr;
+            }
+            return &slots_[head & mask_];
+        }
+
+        /**
+         * @brief consumer: removes the oldest item and moves it to item if not null, returns false if the ring is empty
+         */
+        bool Pop(T *item = nullptr) {
+            T *front = Front();
+            if (!front) return false;
+            if (item) *item = std::move(*front);
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief approximate number of items when called concurrently with the other side
+         */
+        size_t Size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+        bool Empty() const { return Size() == 0; }
+        bool Full() const { return Size() > mask_; }
+        size_t Capacity() const { return mask_ + 1; }
+
+    private:
+        std::unique_ptr<T[]> slots_;
+        size_t mask_ = 0;
+        alignas(64) std::atomic<size_t> head_ = 0; // next item to pop, written by the consumer
+        size_t cached_tail_ = 0; // consumer's copy of tail_
+        alignas(64) std::atomic<size_t> tail_ = 0; // next slot to push, written by the producer
+        size_t cached_head_ = 0; // producer's copy of head_
+};
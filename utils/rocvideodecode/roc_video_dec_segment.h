@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2024 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "rocdecode.h"
+#include "roc_video_dec_queue.h"
+
+/**
+ * @brief Finds the random access points where RocVideoDecoderParallel can cut a stream into independently decodable segments:
+ *        an IDR picture for AVC, an IDR or BLA picture for HEVC, a key frame for VP9, and a key frame with a sequence header
+ *        for AV1. Open-GOP CRA pictures are not used, as their leading pictures reference the previous segment. It also keeps
+ *        the AVC and HEVC parameter sets seen so far, to be repeated in front of a segment that doesn't carry its own.
+ */
+class StreamSegmenter {
+    public:
+        explicit StreamSegmenter(rocDecVideoCodec codec_type) : codec_type_(codec_type) {}
+
+        /**
+         * @brief forgets the parameter sets, before a new stream
+         */
+        void Reset() { parameter_sets_.clear(); }
+
+        /**
+         * @brief returns true if a packet starts a closed GOP, and records the AVC and HEVC parameter sets it carries
+         */
+        bool ScanPacket(const uint8_t *data, size_t size) {
+            switch (codec_type_) {
+                case rocDecVideoCodec_AVC:
+                case rocDecVideoCodec_HEVC: {
+                    bool is_random_access_point = false;
+                    ForEachNalUnit(data, size, [&](const uint8_t *nal_unit, size_t nal_size) {
+                        if (!nal_size) return;
+                        int nal_unit_type = GetNalUnitType(nal_unit);
+                        if (codec_type_ == rocDecVideoCodec_AVC) {
+                            is_random_access_point |= nal_unit_type == 5; // IDR
+                        } else {
+                            is_random_access_point |= nal_unit_type >= 16 && nal_unit_type <= 20; // BLA, IDR
+                        }
+                        if (IsParameterSet(nal_unit_type)) {
+                            SaveParameterSet(nal_unit, nal_size);
+                        }
+                    });
+                    return is_random_access_point;
+                }
+                case rocDecVideoCodec_VP9: {
+                    // uncompressed header: frame_marker(2), profile_low_bit, profile_high_bit, [reserved_zero if profile 3],
+                    // show_existing_frame, frame_type (0 for a key frame)
+                    if (!size || (data[0] >> 6) != 2) return false;
+                    int profile = ((data[0] >> 5) & 1) | (((data[0] >> 4) & 1) << 1);
+                    int show_existing_frame_bit = profile == 3 ? 2 : 3;
+                    return !((data[0] >> show_existing_frame_bit) & 1) && !((data[0] >> (show_existing_frame_bit - 1)) & 1);
+                }
+                case rocDecVideoCodec_AV1: {
+                    bool has_sequence_header = false, is_key_frame = false;
+                    size_t offset = 0;
+                    while (offset < size) {
+                        // obu_header: forbidden bit, obu_type(4), obu_extension_flag, obu_has_size_field, reserved bit
+                        int obu_type = (data[offset] >> 3) & 0xF;
+                        bool has_extension = data[offset] & 0x4, has_size = data[offset] & 0x2;
+                        offset += has_extension ? 2 : 1;
+                        uint64_t obu_size = size > offset ? size - offset : 0;
+                        if (has_size) {
+                            obu_size = 0;
+                            for (int i = 0; i < 8 && offset < size; i++) {
+                                obu_size |= static_cast<uint64_t>(data[offset] & 0x7F) << (7 * i);
+                                if (!(data[offset++] & 0x80)) break;
+                            }
+                        }
+                        if (offset >= size) break;
+                        if (obu_type == 1) { // OBU_SEQUENCE_HEADER
+                            has_sequence_header = true;
+                        } else if (obu_type == 3 || obu_type == 6) { // OBU_FRAME_HEADER, OBU_FRAME
+                            // show_existing_frame(1), frame_type(2), show_frame(1) with reduced_still_picture_header 0
+                            is_key_frame = (data[offset] & 0xF0) == 0x10;
+                            break;
+                        }
+                        offset += obu_size;
+                    }
+                    return has_sequence_header && is_key_frame;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * @brief returns false for an AVC or HEVC packet without a sequence parameter set, which needs the saved ones in front
+         */
+        bool HasParameterSets(const uint8_t *data, size_t size) const {
+            if (codec_type_ != rocDecVideoCodec_AVC && codec_type_ != rocDecVideoCodec_HEVC) return true;
+            bool has_sps = false;
+            int sps_type = codec_type_ == rocDecVideoCodec_AVC ? 7 : 33;
+            ForEachNalUnit(data, size, [&](const uint8_t *nal_unit, size_t nal_size) {
+                has_sps |= nal_size && GetNalUnitType(nal_unit) == sps_type;
+            });
+            return has_sps;
+        }
+
+        /**
+         * @brief returns the parameter sets seen so far with their start codes, the latest last
+         */
+        const std::vector<std::vector<uint8_t>> &GetParameterSets() const { return parameter_sets_; }
+
+    private:
+        /**
+         * @brief calls nal_unit_func with each NAL unit of an Annex B packet, start code excluded
+         */
+        template <typename F>
+        static void ForEachNalUnit(const uint8_t *data, size_t size, F &&nal_unit_func) {
+            size_t start = size;
+            for (size_t i = 0; i + 2 < size; i++) {
+                if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+                    if (start < size) {
+                        size_t end = i;
+                        while (end > start && data[end - 1] == 0) end--;
+                        nal_unit_func(data + start, end - start);
+                    }
+                    start = i + 3;
+                    i += 2;
+                }
+            }
+            if (start < size) nal_unit_func(data + start, size - start);
+        }
+
+        /**
+         * @brief returns the type of an AVC or HEVC NAL unit
+         */
+        int GetNalUnitType(const uint8_t *nal_unit) const {
+            return codec_type_ == rocDecVideoCodec_AVC ? nal_unit[0] & 0x1F : (nal_unit[0] >> 1) & 0x3F;
+        }
+
+        bool IsParameterSet(int nal_unit_type) const {
+            if (codec_type_ == rocDecVideoCodec_AVC) {
+                return nal_unit_type == 7 || nal_unit_type == 8; // SPS, PPS
+            }
+            return nal_unit_type >= 32 && nal_unit_type <= 34; // VPS, SPS, PPS
+        }
+
+        void SaveParameterSet(const uint8_t *nal_unit, size_t nal_size) {
+            static const uint8_t start_code[4] = {0, 0, 0, 1};
+            std::vector<uint8_t> parameter_set(start_code, start_code + sizeof(start_code));
+            parameter_set.insert(parameter_set.end(), nal_unit, nal_unit + nal_size);
+            auto it = std::find(parameter_sets_.begin(), parameter_sets_.end(), parameter_set);
+            if (it != parameter_sets_.end()) {
+                parameter_sets_.erase(it);
+            } else if (parameter_sets_.size() >= kMaxParameterSets) {
+                parameter_sets_.erase(parameter_sets_.begin());
+            }
+            // latest last, so it overrides an older parameter set with the same id when they're repeated
+            parameter_sets_.push_back(std::move(parameter_set));
+        }
+
+        static constexpr size_t kMaxParameterSets = 32;
+        rocDecVideoCodec codec_type_;
+        std::vector<std::vector<uint8_t>> parameter_sets_;
+};
+
+/**
+ * @brief Frames of the segments decoded by several sessions, handed out segment after segment. Segment n is decoded by session
+ *        n % num_sessions, which queues its frames with Push() and ends each of its segments with EndSegment(); Pop() takes
+ *        the frames from the session of the current segment only, so they come out in the order of the stream however far
+ *        ahead the other sessions are. Each session buffers up to max_buffered_frames frames, then Push() waits for Pop().
+ */
+template <typename T>
+class SegmentedFrameQueue {
+    public:
+        SegmentedFrameQueue(uint32_t num_sessions, uint32_t max_buffered_frames) {
+            for (uint32_t i = 0; i < std::max(num_sessions, 1u); i++) {
+                queues_.emplace_back(std::make_unique<BoundedQueue<SegmentOutput>>(max_buffered_frames));
+            }
+        }
+
+        uint32_t GetNumSessions() const { return static_cast<uint32_t>(queues_.size()); }
+
+        /**
+         * @brief queues a frame of the current segment of a session; returns false once the queue is closed
+         */
+        bool Push(uint32_t session_index, T &&frame) {
+            SegmentOutput output;
+            output.frame = std::move(frame);
+            return queues_[session_index]->Push(std::move(output));
+        }
+
+        /**
+         * @brief ends the current segment of a session, the next frames it pushes belong to its next segment
+         */
+        bool EndSegment(uint32_t session_index) {
+            SegmentOutput output;
+            output.is_end_of_segment = true;
+            return queues_[session_index]->Push(std::move(output));
+        }
+
+        /**
+         * @brief the session has no more segments: Pop() returns false when it reaches the next segment of the session
+         */
+        void CloseSession(uint32_t session_index) { queues_[session_index]->Close(); }
+
+        /**
+         * @brief returns the next frame of the stream, waiting for it if needed; false at the end of the stream or after Close()
+         */
+        bool Pop(T &frame) {
+            while (true) {
+                SegmentOutput output;
+                if (!queues_[next_segment_ % queues_.size()]->Pop(output)) return false;
+                if (!output.is_end_of_segment) {
+                    frame = std::move(output.frame);
+                    return true;
+                }
+                next_segment_++;
+            }
+        }
+
+        /**
+         * @brief wakes up both sides: pushes fail from then on, and pops drain the frames queued before failing
+         */
+        void Close() {
+            for (auto &queue : queues_) {
+                queue->Close();
+            }
+        }
+
+        /**
+         * @brief drops the queued frames
+         */
+        void Clear() {
+            for (auto &queue : queues_) {
+                queue->Clear();
+            }
+        }
+
+        /**
+         * @brief drops the queued frames and starts again from the first segment; only while no session uses the queue
+         */
+        void Reset() {
+            for (auto &queue : queues_) {
+                queue->Reset();
+            }
+            next_segment_ = 0;
+        }
+
+    private:
+        struct SegmentOutput {
+            T frame;
+            bool is_end_of_segment = false;   // the frames of the segment have all been queued before
+        };
+
+        std::vector<std::unique_ptr<BoundedQueue<SegmentOutput>>> queues_;
+        size_t next_segment_ = 0;   // segment handed out by Pop()
+};